@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <switch.h>
+#include "piece_table.hpp"
 
 // 宏文件头
 struct MacroHeader {
@@ -63,6 +64,7 @@ struct MacroBasicInfo {
 class MacroData {
 public:
     static bool load(const char* filePath);
+    static void setFilePath(const char* filePath);
     static bool loadFrameAndBasicInfo(const char* filePath = nullptr);
     static bool loadBakMacroData();
     static bool saveForEdit();
@@ -71,6 +73,7 @@ public:
     static const MacroBasicInfo& getBasicInfo();
     static void parseActions();
     static std::vector<Action>& getActions();
+    static u32 getEditVersion();        // 动作列表版本号（解析、编辑、撤销后递增，用于界面缓存失效）
     
     // 编辑操作
     static void insertAction(s32 actionIndex, bool insertBefore);
@@ -86,9 +89,11 @@ public:
     static void clearStick(s32 startIndex, s32 endIndex, StickTarget target);
     static void setActionStick(s32 actionIndex, StickDir leftDir, StickDir rightDir);
     
-    // 撤销功能
+    // 撤销/重做功能
     static bool undo();
     static bool canUndo();
+    static bool redo();
+    static bool canRedo();
     
     // 内存管理
     static void allCleanup();
@@ -98,17 +103,33 @@ private:
     static char s_filePath[128];
     static MacroHeader s_header;
     static MacroBasicInfo s_basicInfo;
-    static std::vector<MacroFrame> s_frames;
-    static std::vector<MacroFrameV2> s_framesV2;
+    static PieceTable<MacroFrame> s_frames;       // 帧数据（分段表，保存时才拼接）
+    static PieceTable<MacroFrameV2> s_framesV2;
     static std::vector<Action> s_actions;
     
-    // 撤销快照栈（最多3层）
-    struct UndoSnapshot {
-        std::vector<MacroFrame> frames;
-        std::vector<MacroFrameV2> framesV2;
-        std::vector<Action> actions;
+    // 动作 → 帧起始位置的索引（树状数组，维护各动作 frameCount 的前缀和）
+    static std::vector<u32> s_frameIndex;
+    static u32 s_editVersion;
+    
+    // 编辑记录：每次编辑只改动一段连续的动作及其对应的帧，记录这段区域另一个版本的内容
+    // 撤销和重做都是把当前区域与记录的内容互换，内存只与改动的范围成正比
+    struct EditRecord {
+        u32 actionStart;                    // 区域起始动作
+        u32 actionLen;                      // 区域当前的动作数
+        u32 frameStart;                     // 区域起始帧
+        u32 frameLen;                       // 区域当前的帧数
+        std::vector<Action> actions;        // 区域另一个版本的动作
+        std::vector<MacroFrame> frames;     // 区域另一个版本的帧（V1）
+        std::vector<MacroFrameV2> framesV2; // 区域另一个版本的帧（V2）
+        size_t bytes() const;
     };
-    static std::vector<UndoSnapshot> s_undoStack;
+    static constexpr size_t UNDO_BUDGET_BYTES = 64 * 1024;  // 撤销/重做记录的内存上限
+    static std::vector<EditRecord> s_undoStack;
+    static std::vector<EditRecord> s_redoStack;
+    static EditRecord s_pendingEdit;        // 正在进行的编辑
+    static u32 s_pendingActionCount;        // 编辑前的动作总数
+    static u32 s_pendingFrameCount;         // 编辑前的帧总数
+    static size_t s_journalBytes;           // 撤销/重做记录当前占用的内存
     
     // 辅助函数：判断摇杆方向
     static StickDir getStickDir(s32 x, s32 y);
@@ -117,20 +138,28 @@ private:
     static bool isSameState(const MacroFrame& a, const MacroFrame& b);
     static bool isSameState(const MacroFrameV2& a, const MacroFrameV2& b);
     
+    // 辅助函数：帧索引维护
+    static void rebuildFrameIndex();                            // 动作增删后重建，O(n)
+    static void adjustFrameIndex(s32 actionIndex, s32 delta);   // 单个动作帧数变化，O(log n)
+    static s32 getFrameStart(s32 actionIndex);                  // 动作的帧起始位置，O(log n)
+    
     // 辅助函数：删除动作内部实现（不保存快照）
     static void deleteActionsInternal(s32 startIndex, s32 endIndex);
     
     // 辅助函数：更新总时长
     static void updateDurationMs();
 
-    // 辅助函数：保存快照,用于撤销
-    static void saveSnapshot();
+    // 辅助函数：撤销记录
+    static void beginEdit(s32 actionStart, s32 actionEnd);   // 编辑前调用，记录将被改动的动作区域 [start, end)
+    static void commitEdit();                                // 编辑后调用，记录入栈
+    static void swapRegion(EditRecord& record);              // 当前区域与记录内容互换（撤销/重做）
+    static u32 frameTotal();                                 // 当前版本的帧总数
     
     // 辅助函数：解析动作（版本分离）
     static void parseActionsV1();
     static void parseActionsV2();
     
-    // 辅助函数：保存帧数据（版本分离）
-    static void saveForEditV1(FILE* fp);
-    static void saveForEditV2(FILE* fp);
+    // 辅助函数：保存帧数据（版本分离，写入失败返回false）
+    static bool saveForEditV1(FILE* fp);
+    static bool saveForEditV2(FILE* fp);
 };
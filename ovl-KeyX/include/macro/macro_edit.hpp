@@ -14,6 +14,7 @@ private:
     const char* m_gameName;
     bool m_isRecord;
     bool m_bakMacro = false;
+    bool m_saveFailed = false;  // 上次保存写入失败（原文件已恢复，留在编辑界面）
     
     s32 m_scrollOffset = 0;
     s32 m_selectedIndex = 0;
@@ -48,6 +49,13 @@ private:
     s32 m_menuSelStart = 0;   // 菜单模式下的选中范围起始
     s32 m_menuSelEnd = 0;     // 菜单模式下的选中范围结束
     
+    // 时间轴缓存（各动作的起始时间，动作列表变化后重建）
+    std::vector<u32> m_actionStartMs;
+    u32 m_timelineVersion = 0;
+    bool m_timelineValid = false;
+    void updateTimelineCache();
+    s32 findActionAtMs(u32 ms) const;
+    
     bool hasVirtualMergedStick() const;
     bool hasStickL() const;
     bool hasStickR() const;
@@ -9,6 +9,7 @@
 class MacroListGui : public tsl::Gui {
 public:
     MacroListGui();
+    ~MacroListGui();
     virtual tsl::elm::Element* createUI() override;
     virtual void update() override;
    
@@ -21,7 +22,6 @@ private:
     };
 
     std::vector<MacroDirEntry> m_macroDirs{};
-    size_t m_nextIndex = 0;
 };
 
 // 脚本清单具体游戏的脚本列表类
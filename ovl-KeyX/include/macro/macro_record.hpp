@@ -9,11 +9,13 @@ class RecordingFrame : public tsl::elm::Element
 public:
     RecordingFrame();
     void setRecordingTime(u64 elapsed_s);
+    void setMaxLate(u32 lateUs);        // 采样最大延迟（录制时间误差）
     virtual void draw(tsl::gfx::Renderer* renderer) override;
     virtual void layout(u16 parentX, u16 parentY, u16 parentWidth, u16 parentHeight) override;
 
 private:
     char m_RecordingTimeText[32];
+    char m_MaxLateText[32];
 };
 
 // 录制时界面类
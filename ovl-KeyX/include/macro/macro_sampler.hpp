@@ -1,34 +1,76 @@
 #pragma once
 #include <tesla.hpp>
-#include <vector>
 #include <atomic>
+#include <stdio.h>
 #include "macro_data.hpp"
 
+// 宏录制采样器
+// 采样线程只把已结束的帧放入固定大小的环形缓冲，写入线程定期把缓冲中的帧成块追加到临时文件，
+// 录制时长不受内存限制，保存时修正文件头并重命名为正式文件
 class MacroSampler {
 public:
-    static void Prepare();              // 倒计时开始时调用：创建线程，线程空转等待
+    static void Prepare();              // 倒计时开始时调用：创建临时文件和线程，线程空转等待
     static void Start();                // 倒计时结束时调用：通知线程开始采样
-    static void Stop();                 // 停止采样
+    static void Stop();                 // 停止采样（剩余帧全部写入临时文件）
     static bool Save(u64 titleId, u64 comboMask = 0);  // 保存到文件，comboMask 用于移除末尾快捷键帧
-    static void Cancel();               // 取消（倒计时期间按B）
+    static void Cancel();               // 取消（倒计时期间按B），删除临时文件
     static const char* GetFilePath();   // 获取保存的文件路径
-    
+    static u32 GetMaxLateUs();          // 本次录制采样时刻的最大延迟(us)，用于衡量录制时间误差
+    static bool HasError();             // 临时文件写入失败或环形缓冲溢出（录制已不完整）
+
 private:
+    // 录制中的帧（时间戳保留微秒精度，帧结束时才换算成毫秒时长）
+    struct SampledFrame {
+        u64 startUs;        // 该帧开始时间（相对录制开始，微秒）
+        u64 keysHeld;       // 按键状态
+        s32 leftX;          // 左摇杆X
+        s32 leftY;          // 左摇杆Y
+        s32 rightX;         // 右摇杆X
+        s32 rightY;         // 右摇杆Y
+    };
+
+    // 环形缓冲帧数（必须是2的幂，约28KB）：最高采样率 1kHz 且每次采样都产生新帧时每秒 1000 帧，
+    // 写入线程每 20ms 取走约 20 帧，缓冲能承受约1秒的SD卡写入停顿，超出时录制标记为出错
+    static constexpr u32 RING_SIZE = 1024;
+    static constexpr u32 RING_MASK = RING_SIZE - 1;
+
     static void ThreadFunc(void* arg);
-    static void SampleOneFrame();
-    
+    static void WriterFunc(void* arg);
+    static void SampleOneFrame(u64 now);
+    static void PushFrame(const SampledFrame& frame, u64 endUs);    // 结束一帧并放入环形缓冲
+    static void DrainRing();                                        // 把环形缓冲中的帧写入临时文件
+    static bool ReadFrameAt(u32 index, MacroFrameV2& out);          // 从临时文件读回一帧
+    static void DiscardTempFile();
+    static u64 LoadSampleInterval();    // 从配置读取采样间隔（tick）
+
     // 线程相关
     static Thread s_thread;
     static bool s_threadCreated;
+    static Thread s_writerThread;
+    static bool s_writerCreated;
     static std::atomic<bool> s_shouldExit;
     static std::atomic<bool> s_sampling;
-    
+    static std::atomic<bool> s_writerExit;
+    static std::atomic<bool> s_error;
+
+    // 采样线程 → 写入线程（单生产者单消费者）
+    static MacroFrameV2 s_ring[RING_SIZE];
+    static std::atomic<u32> s_ringHead;     // 下一个写入位置（采样线程）
+    static std::atomic<u32> s_ringTail;     // 下一个读取位置（写入线程）
+
+    // 临时文件
+    static FILE* s_tempFile;
+    static u32 s_writtenFrames;             // 已写入临时文件的帧数
+
     // 采样数据
-    static std::vector<MacroFrameV2> s_frames;
+    static SampledFrame s_pending;          // 当前还未结束的帧
+    static bool s_hasPending;
     static char s_filePath[128];
     static u32 s_totalSamples;  // 总采样次数
     static u64 s_startTick;     // 录制开始时间
-    static u32 s_lastFrameMs;   // 上一帧时间(ms)
+    static u64 s_lastSampleUs;  // 最后一次采样时间(us)
+    static u64 s_intervalTicks; // 采样间隔（tick）
+    static u64 s_maxLateUs;     // 采样时刻相对预定时间的最大延迟(us)
     static PadState s_padP1;        // pro 控制器
     static PadState s_padHandheld;  // 掌机模式
 };
@@ -1,16 +1,31 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <mutex>
 #include <switch.h>
 
-// 宏工具类
+// 宏工具类（公开接口可能同时被界面线程和后台线程调用，例如商店下载完成后刷新索引，内部统一加锁）
 class MacroUtil {
 public:
-    // 宏条目（路径+快捷键）
+    // 宏条目（路径+显示名称+快捷键）
     struct MacroEntry {
         std::string path;
+        std::string name;
         u64 hotkey;
     };
+
+    // 宏索引条目（每个游戏目录下一个索引文件，浏览列表时只读索引，不再逐个打开宏文件）
+    struct MacroIndexEntry {
+        char fileName[96];      // 文件名（含扩展名）
+        char name[96];          // 显示名称
+        u32 fileSize;           // 文件大小（字节）
+        u32 durationMs;         // 总时长（毫秒）
+        u32 frameCount;         // 总帧数
+        u16 version;            // 宏文件版本号
+        u16 reserved;
+        u64 hotkey;             // 快捷键（0=未分配）
+        s64 mtime;              // 宏文件修改时间（与文件不一致时重新读取该条目）
+    } __attribute__((packed));
     
     // 游戏目录条目（titleId + 宏文件数量）
     struct GameDirEntry {
@@ -36,13 +51,16 @@ public:
     // 获取指定宏文件的快捷键
     static u64 getHotkey(u64 titleId, const char* macroPath);
     
-    // 设置指定宏文件的快捷键
-    static void setHotkey(u64 titleId, const char* macroPath, u64 hotkey);
+    // 单个游戏最多绑定的快捷键数量（系统模块把整个绑定表读入 8KB 的配置内存池：(8192 - 8) / 136）
+    static constexpr size_t MAX_BINDINGS = 60;
+
+    // 设置指定宏文件的快捷键（绑定数量已达上限时返回false）
+    static bool setHotkey(u64 titleId, const char* macroPath, u64 hotkey);
     
     // 删除指定宏文件的快捷键
     static bool removeHotkey(u64 titleId, const char* macroPath);
     
-    // 获取指定游戏已使用的快捷键列表
+    // 获取指定游戏已使用的快捷键列表（按快捷键值升序）
     static std::vector<u64> getUsedHotkeys(u64 titleId);
     
     // 从宏文件路径提取 titleId
@@ -60,10 +78,66 @@ public:
     // 重命名宏文件后更新配置和元数据，返回是否有快捷键需要重载
     static bool renameMacro(const char* oldPath, const char* newPath);
 
+    // 读取宏文件的索引条目（索引中没有或已过期时从宏文件刷新）
+    static bool getIndexEntry(const char* macroPath, MacroIndexEntry& out);
+
+    // 宏文件写入后刷新索引条目（录制保存、下载完成时调用，读取宏文件计算时长）
+    static void updateIndexEntry(const char* macroPath);
+
+    // 宏文件写入后刷新索引条目（编辑保存时调用，时长由调用方给出，不再读取帧数据）
+    static void updateIndexEntry(const char* macroPath, u16 version, u32 frameCount, u32 durationMs);
+
 private:
     // 获取游戏配置文件路径
     static void getGameCfgPath(u64 titleId, char* outPath, size_t size);
     
     // 获取宏目录路径
     static void getMacroDirPath(u64 titleId, char* outPath, size_t size);
+
+    // 快捷键绑定表记录（每个游戏一个绑定表文件，格式与系统模块一致）
+    struct MacroBinding {
+        u32 pathHash;           // 宏路径的 FNV-1a 哈希
+        u16 flags;              // 标志位（保留，目前为0）
+        u16 reserved;
+        u64 combo;              // 快捷键组合
+        char path[120];         // 相对宏目录的路径（{TID}/文件名），不在宏目录下时为完整路径
+    } __attribute__((packed));
+
+    // 保护绑定表缓存和索引文件的读改写（公开接口之间会互相调用，用递归锁）
+    static std::recursive_mutex s_mutex;
+
+    // 当前载入的绑定表（文件中的顺序即绑定先后，系统模块按此顺序匹配快捷键）
+    static u64 s_bindTitleId;
+    static std::vector<MacroBinding> s_bindings;
+    static std::vector<u16> s_bindByPath;       // 按 (pathHash, path) 排序的下标
+
+    // 绑定表读写（同一游戏只读一次；没有绑定表时从游戏配置的 macro_path_N/macro_combo_N 迁移）
+    static void getBindingPath(u64 titleId, char* outPath, size_t size);
+    static void loadBindings(u64 titleId);
+    static bool saveBindings();
+    static bool migrateBindings(u64 titleId);
+    // 修改绑定后重建排序下标
+    static void sortBindings();
+    // 按宏路径二分查找绑定，返回下标，找不到返回-1
+    static int findBinding(const char* macroPath);
+
+    // 索引文件读写（读取失败或损坏时扫描目录重建）
+    // dirMtime 为上次与目录核对时宏目录的修改时间，目录修改时间不变时信任索引，不再列目录
+    static void getIndexPath(u64 titleId, char* outPath, size_t size);
+    static std::vector<MacroIndexEntry> loadIndex(u64 titleId, s64* dirMtime = nullptr);
+    static bool saveIndex(u64 titleId, const std::vector<MacroIndexEntry>& entries, s64 dirMtime);
+    static std::vector<MacroIndexEntry> rebuildIndex(u64 titleId, s64* dirMtime = nullptr);
+    // 读取索引并与目录中的文件名核对（只列目录不打开文件）：补上外部拷入的宏，去掉已不存在的宏
+    static std::vector<MacroIndexEntry> syncIndex(u64 titleId);
+    // 宏目录的修改时间（目录不存在时返回-1）
+    static s64 getDirMtime(u64 titleId);
+
+    // 从宏文件读取一条索引（hotkey 由调用方填写）
+    static bool readIndexEntry(const char* macroPath, MacroIndexEntry& out);
+    // 根据文件状态和元数据填写条目的文件名、名称、大小与修改时间
+    static bool fillIndexFileInfo(const char* macroPath, MacroIndexEntry& out);
+    // 替换或追加一条索引
+    static void putIndexEntry(const char* macroPath, const MacroIndexEntry& entry);
+    // 修改索引中某个宏的快捷键
+    static void setIndexHotkey(u64 titleId, const char* macroPath, u64 hotkey);
 };
@@ -17,7 +17,9 @@ private:
     char m_gameName[64];
     char m_macroFilePath[128];
     bool m_isRecord;
+    u64 m_titleId = 0;
     u64 m_Hotkey = 0;
+    MacroUtil::MacroIndexEntry m_info{};   // 宏基础信息（来自宏索引）
     tsl::elm::ListItem* m_listButton = nullptr;
 
     void getHotkey();
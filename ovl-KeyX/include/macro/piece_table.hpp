@@ -0,0 +1,194 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <switch.h>
+
+// 分段表（piece table）：原始缓冲（文件读入的帧）+ 追加缓冲（编辑产生的帧）+ 片段列表
+// 插入、删除、复制、移动只改动片段列表，代价与片段数成正比，与帧数无关；保存时才拼接成连续数组
+template<typename T>
+class PieceTable {
+public:
+    // 载入原始数据（丢弃之前的编辑）
+    void load(std::vector<T>&& original) {
+        m_original = std::move(original);
+        m_added.clear();
+        m_pieces.clear();
+        if (!m_original.empty()) m_pieces.push_back({false, 0, (u32)m_original.size()});
+        m_size = m_original.size();
+    }
+
+    // 清空并释放内存
+    void clear() {
+        m_original.clear();
+        m_original.shrink_to_fit();
+        m_added.clear();
+        m_added.shrink_to_fit();
+        m_pieces.clear();
+        m_pieces.shrink_to_fit();
+        m_size = 0;
+    }
+
+    u32 size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    // 读取单帧（按片段查找）
+    const T& at(u32 index) const {
+        u32 offset;
+        size_t p = findPiece(index, offset);
+        return buffer(m_pieces[p])[m_pieces[p].start + offset];
+    }
+
+    // 取得一段可写的连续帧：该段先复制到追加缓冲末尾合成一个片段，返回的指针在下一次修改前有效
+    // （缓冲中已有的数据从不原地修改，所以复制出的片段可以安全地共享同一段数据）
+    T* writable(u32 pos, u32 count) {
+        if (count == 0) return nullptr;
+        std::vector<T> copied;
+        copyOut(pos, count, copied);
+        erase(pos, count);
+        insert(pos, copied.data(), count);
+        return &m_added[m_added.size() - count];
+    }
+
+    // 在 pos 处插入 count 帧数据（data 不能指向本表内部）
+    void insert(u32 pos, const T* data, u32 count) {
+        if (count == 0) return;
+        compactIfNeeded();
+        u32 start = m_added.size();
+        m_added.insert(m_added.end(), data, data + count);
+        insertPieces(pos, {{true, start, count}});
+    }
+
+    // 在 pos 处插入 count 个相同的帧
+    void insert(u32 pos, u32 count, const T& value) {
+        if (count == 0) return;
+        T copied = value;
+        compactIfNeeded();
+        u32 start = m_added.size();
+        m_added.insert(m_added.end(), count, copied);
+        insertPieces(pos, {{true, start, count}});
+    }
+
+    // 把 [srcPos, srcPos + count) 复制一份插入到 pos（只复制片段，不复制帧数据）
+    void insertCopy(u32 pos, u32 srcPos, u32 count) {
+        if (count == 0) return;
+        insertPieces(pos, slice(srcPos, count));
+    }
+
+    // 把 [srcPos, srcPos + count) 移动到 dstPos（dstPos 为移动前序列中的插入位置）
+    // dstPos 落在被移动的范围内（含两端）时序列不变，直接返回
+    void move(u32 srcPos, u32 count, u32 dstPos) {
+        if (count == 0 || (dstPos >= srcPos && dstPos <= srcPos + count)) return;
+        std::vector<Piece> pieces = slice(srcPos, count);
+        erase(srcPos, count);
+        if (dstPos > srcPos) dstPos -= count;
+        insertPieces(dstPos, pieces);
+    }
+
+    // 删除 [pos, pos + count)
+    void erase(u32 pos, u32 count) {
+        if (count == 0) return;
+        size_t first = splitAt(pos);
+        size_t last = splitAt(pos + count);
+        m_pieces.erase(m_pieces.begin() + first, m_pieces.begin() + last);
+        m_size -= count;
+    }
+
+    // 取出 [pos, pos + count) 到连续数组
+    void copyOut(u32 pos, u32 count, std::vector<T>& out) const {
+        out.clear();
+        out.reserve(count);
+        for (const Piece& piece : m_pieces) {
+            if (count == 0) break;
+            if (pos >= piece.length) {
+                pos -= piece.length;
+                continue;
+            }
+            u32 n = std::min(piece.length - pos, count);
+            const T* src = buffer(piece) + piece.start + pos;
+            out.insert(out.end(), src, src + n);
+            count -= n;
+            pos = 0;
+        }
+    }
+
+    // 拼接成连续数组（保存时调用）
+    void flatten(std::vector<T>& out) const {
+        copyOut(0, m_size, out);
+    }
+
+    // 连续数组形式的数据（多于一个片段时先拼接，用于解析等顺序遍历）
+    const T* data() {
+        if (m_pieces.size() > 1 || (m_pieces.size() == 1 && (m_pieces[0].added || m_pieces[0].start != 0))) {
+            std::vector<T> flat;
+            flatten(flat);
+            load(std::move(flat));
+        }
+        return m_original.data();
+    }
+
+private:
+    struct Piece {
+        bool added;         // true=追加缓冲, false=原始缓冲
+        u32 start;          // 在缓冲中的起始位置
+        u32 length;         // 帧数
+    };
+
+    std::vector<T> m_original;      // 原始缓冲（只读）
+    std::vector<T> m_added;         // 追加缓冲（只追加，过大时整理）
+    std::vector<Piece> m_pieces;    // 片段列表（按序拼接即为完整帧序列）
+    u32 m_size = 0;                 // 总帧数
+
+    static constexpr size_t COMPACT_MIN_FRAMES = 1024;  // 追加缓冲小于此帧数时不整理
+
+    // 追加缓冲超过当前总帧数的两倍时，其中至少一半已不再被任何片段引用（撤销/重做和重复编辑留下的），
+    // 拼接成新的原始缓冲并清空追加缓冲；只在追加新数据之前调用，writable 返回的指针不受影响
+    void compactIfNeeded() {
+        if (m_added.size() < COMPACT_MIN_FRAMES || m_added.size() <= 2 * (size_t)m_size) return;
+        std::vector<T> flat;
+        flatten(flat);
+        load(std::move(flat));
+        m_added.shrink_to_fit();
+    }
+
+    const T* buffer(const Piece& piece) const {
+        return piece.added ? m_added.data() : m_original.data();
+    }
+
+    // 查找包含 index 的片段，offset 返回片段内偏移（index == size 时返回片段数）
+    size_t findPiece(u32 index, u32& offset) const {
+        for (size_t i = 0; i < m_pieces.size(); i++) {
+            if (index < m_pieces[i].length) {
+                offset = index;
+                return i;
+            }
+            index -= m_pieces[i].length;
+        }
+        offset = 0;
+        return m_pieces.size();
+    }
+
+    // 保证 index 处是片段边界，返回从 index 开始的片段下标
+    size_t splitAt(u32 index) {
+        u32 offset;
+        size_t p = findPiece(index, offset);
+        if (p == m_pieces.size() || offset == 0) return p;
+        Piece right = {m_pieces[p].added, m_pieces[p].start + offset, m_pieces[p].length - offset};
+        m_pieces[p].length = offset;
+        m_pieces.insert(m_pieces.begin() + p + 1, right);
+        return p + 1;
+    }
+
+    // 取出 [pos, pos + count) 对应的片段
+    std::vector<Piece> slice(u32 pos, u32 count) {
+        size_t first = splitAt(pos);
+        size_t last = splitAt(pos + count);
+        return std::vector<Piece>(m_pieces.begin() + first, m_pieces.begin() + last);
+    }
+
+    // 在 pos 处插入片段
+    void insertPieces(u32 pos, const std::vector<Piece>& pieces) {
+        size_t p = splitAt(pos);
+        m_pieces.insert(m_pieces.begin() + p, pieces.begin(), pieces.end());
+        for (const Piece& piece : pieces) m_size += piece.length;
+    }
+};
@@ -49,7 +49,6 @@ private:
         tsl::elm::ListItem* item;
     };
     std::vector<GameEntry> m_entries;
-    size_t m_nextIndex = 0;
     int m_loadingIndex = -1;
     int m_frameIndex = 0;
     int m_frameCounter = 0;
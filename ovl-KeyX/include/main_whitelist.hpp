@@ -6,6 +6,7 @@ class SettingWhitelist : public tsl::Gui
 {
 public:
     SettingWhitelist();
+    ~SettingWhitelist();
     virtual tsl::elm::Element* createUI() override;
     virtual void update() override;
     virtual bool handleInput(u64 keysDown, u64 keysHeld, const HidTouchState &touchPos, 
@@ -16,5 +17,4 @@ private:
         tsl::elm::ToggleListItem* item;
     };
     std::vector<AppEntry> m_apps;
-    size_t m_nextIndex = 0;
 };
@@ -3,6 +3,9 @@
 #include <memory>
 #include <cstring>
 #include <vector>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 #include <switch.h>
 
@@ -25,6 +28,20 @@ public:
      */
     static bool getTitleIdGameName(u64 titleId, char* result);
 
+    /**
+     * 只从名称缓存获取程序名称（不调用任何服务，列表创建时直接填充）
+     * @param titleId 程序的Title ID
+     * @param result 用于存储结果的字符数组指针（至少64字节）
+     * @param verified 返回本次运行中是否已核对过程序版本（未核对的交给后台线程调用 getTitleIdGameName 核对）
+     * @return 缓存中有该程序返回true
+     */
+    static bool getCachedGameName(u64 titleId, char* result, bool* verified = nullptr);
+
+    /**
+     * 把名称缓存写回SD卡（有新增条目时才写入）
+     */
+    static void saveTitleNameCache();
+
     /**
      * 获取所有已安装应用的Title ID列表
      * @return 已安装应用的Title ID列表
@@ -43,5 +60,26 @@ public:
     static void loadWhitelist();
 
 private:
+    // 名称缓存条目（按 Title ID + 程序版本区分，游戏更新后重新读取）
+    struct TitleNameEntry {
+        u64 titleId;
+        u32 version;        // 程序版本（本体与补丁中的最高版本）
+        u32 reserved;
+        char name[64];
+    } __attribute__((packed));
+
     static std::unordered_set<u64> s_whitelist;
+
+    // 名称缓存（最近使用的在前，超过容量时淘汰最久未使用的）
+    static std::list<TitleNameEntry> s_nameLru;
+    static std::unordered_map<u64, std::list<TitleNameEntry>::iterator> s_nameIndex;
+    static std::unordered_set<u64> s_nameVerified;     // 本次运行中已核对过版本的条目
+    static bool s_nameCacheLoaded;
+    static bool s_nameCacheDirty;
+    static std::mutex s_nameMutex;                      // 名称缓存可能被后台解析线程同时访问
+
+    static void loadTitleNameCache();
+    static void putTitleName(u64 titleId, const char* name);
+    static bool verifyCachedName(u64 titleId);
+    static bool getAppVersion(u64 titleId, u32& version);
 };
\ No newline at end of file
@@ -1,137 +1,267 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <cstdio>
 #include <cstdlib>
+#include <mutex>
+#include <sys/stat.h>
+#include <switch.h>
 #include <ultra.hpp>
 
 /**
  * INI 配置文件辅助类
- * 封装 libultrahand 的 INI 功能，提供类似 minIni 的简洁接口
+ * 每个文件只解析一次并缓存在内存中，界面读写配置都通过 IniHelper::open 取得的对象进行
  */
 namespace IniHelper {
-    
-    /**
-     * 读取字符串值
-     * @param section   Section 名称
-     * @param key       键名
-     * @param defValue  默认值（键不存在时返回）
-     * @param filePath  INI 文件路径
-     * @return 读取到的字符串值，失败则返回默认值
-     */
-    inline std::string getString(const std::string& section, 
-                                  const std::string& key, 
-                                  const std::string& defValue,
-                                  const std::string& filePath) {
-        std::string value = ult::parseValueFromIniSection(filePath, section, key);
-        return value.empty() ? defValue : value;
-    }
-    
+
+    // 缓存的锁（商店下载线程与界面线程共用缓存，open 和 IniFile 的每个操作都持有）
+    inline std::recursive_mutex s_mutex;
+
     /**
-     * 读取整数值
-     * @param section   Section 名称
-     * @param key       键名
-     * @param defValue  默认值（键不存在时返回）
-     * @param filePath  INI 文件路径
-     * @return 读取到的整数值，失败则返回默认值
+     * 缓存的 INI 文件（通过 IniHelper::open 取得，各界面共享同一对象）
+     * 首次访问时整体解析一次，之后读写都在内存中进行，修改完成后调用 flush 一次性写回
+     * 文件被其他程序（如系统模块）修改后，下次 open 时自动重新解析
+     * 所有操作都持有 s_mutex，可以在后台线程中使用
      */
-    inline int getInt(const std::string& section, 
-                      const std::string& key, 
-                      int defValue,
-                      const std::string& filePath) {
-        std::string value = ult::parseValueFromIniSection(filePath, section, key);
-        if (value.empty()) {
-            return defValue;
+    class IniFile {
+    public:
+        std::string getString(const std::string& section, const std::string& key, const std::string& defValue) const {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            const std::string* value = find(section, key);
+            return (value && !value->empty()) ? *value : defValue;
         }
-        return std::atoi(value.c_str());
-    }
-    
-    /**
-     * 读取布尔值
-     * @param section   Section 名称
-     * @param key       键名
-     * @param defValue  默认值（键不存在时返回）
-     * @param filePath  INI 文件路径
-     * @return 读取到的布尔值，失败则返回默认值
-     */
-    inline bool getBool(const std::string& section, 
-                        const std::string& key, 
-                        bool defValue,
-                        const std::string& filePath) {
-        std::string value = ult::parseValueFromIniSection(filePath, section, key);
-        if (value.empty()) {
+
+        int getInt(const std::string& section, const std::string& key, int defValue) const {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            const std::string* value = find(section, key);
+            return (value && !value->empty()) ? std::atoi(value->c_str()) : defValue;
+        }
+
+        bool getBool(const std::string& section, const std::string& key, bool defValue) const {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            const std::string* value = find(section, key);
+            if (!value || value->empty()) return defValue;
+            if (*value == "1" || *value == "true" || *value == "yes" || *value == "on") return true;
+            if (*value == "0" || *value == "false" || *value == "no" || *value == "off") return false;
             return defValue;
         }
-        // 支持多种布尔值表示：true/false, 1/0, yes/no, on/off
-        if (value == "1" || value == "true" || value == "yes" || value == "on") {
-            return true;
+
+        void setString(const std::string& section, const std::string& key, const std::string& value) {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            Section* sec = findSection(section);
+            if (!sec) {
+                m_sections.push_back({section, {}});
+                sec = &m_sections.back();
+            }
+            for (auto& kv : sec->second) {
+                if (kv.first != key) continue;
+                if (kv.second == value) return;
+                kv.second = value;
+                m_dirty = true;
+                return;
+            }
+            sec->second.push_back({key, value});
+            m_dirty = true;
+        }
+
+        void setInt(const std::string& section, const std::string& key, int value) {
+            setString(section, key, std::to_string(value));
+        }
+
+        void setBool(const std::string& section, const std::string& key, bool value) {
+            setString(section, key, value ? "true" : "false");
+        }
+
+        void removeKey(const std::string& section, const std::string& key) {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            Section* sec = findSection(section);
+            if (!sec) return;
+            for (auto it = sec->second.begin(); it != sec->second.end(); ++it) {
+                if (it->first != key) continue;
+                sec->second.erase(it);
+                m_dirty = true;
+                return;
+            }
+        }
+
+        void removeSection(const std::string& section) {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            for (auto it = m_sections.begin(); it != m_sections.end(); ++it) {
+                if (it->first != section) continue;
+                m_sections.erase(it);
+                m_dirty = true;
+                return;
+            }
         }
-        if (value == "0" || value == "false" || value == "no" || value == "off") {
+
+        /**
+         * 有修改时整体写回文件
+         * @return 写入成功或无需写入返回true
+         */
+        bool flush() {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            if (!m_dirty) return true;
+            std::string content;
+            for (const auto& sec : m_sections) {
+                content += "[" + sec.first + "]\n";
+                for (const auto& kv : sec.second) content += kv.first + "=" + kv.second + "\n";
+                content += "\n";
+            }
+            FILE* fp = fopen(m_path.c_str(), "w");
+            if (!fp) {
+                // 目录不存在时先创建
+                ult::createDirectory(m_path.substr(0, m_path.find_last_of('/')));
+                fp = fopen(m_path.c_str(), "w");
+                if (!fp) return false;
+            }
+            bool ok = fwrite(content.data(), 1, content.size(), fp) == content.size();
+            ok = (fclose(fp) == 0) && ok;
+            if (ok) {
+                m_dirty = false;
+                m_size = content.size();
+                m_hash = hash(content);
+                stamp();
+            }
+            return ok;
+        }
+
+        explicit IniFile(const std::string& filePath) : m_path(filePath) {}
+
+        // 文件自上次解析/写回后是否被其他程序修改（有未写回的修改时以内存为准）
+        // 平时只比较文件大小和修改时间；FAT 的修改时间只精确到2秒，系统模块在同一个2秒内
+        // 把 0 改成 1 这类同样大小的改写看不出来，所以解析/写回后的几秒内仍比较内容哈希，
+        // 过了这段时间内容仍一致，之后的改写必然带来新的修改时间，只看文件信息即可
+        bool isStale() {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            if (m_dirty) return false;
+            if (!m_loaded) return true;
+            struct stat st{};
+            if (stat(m_path.c_str(), &st) != 0) return m_size != -1;
+            if ((long)st.st_size != m_size || st.st_mtime != m_mtime) return true;
+            if (m_settled) return false;
+            bool settled = armTicksToNs(armGetSystemTick() - m_stampTick) >= SETTLE_NS;
+            std::string content;
+            if (!readAll(content) || (long)content.size() != m_size || hash(content) != m_hash) return true;
+            m_settled = settled;
             return false;
         }
-        return defValue;
-    }
-    
-    /**
-     * 写入字符串值
-     * @param section   Section 名称
-     * @param key       键名
-     * @param value     要写入的值
-     * @param filePath  INI 文件路径
-     */
-    inline void setString(const std::string& section, 
-                          const std::string& key, 
-                          const std::string& value,
-                          const std::string& filePath) {
-        ult::setIniFileValue(filePath, section, key, value);
-    }
-    
-    /**
-     * 写入整数值
-     * @param section   Section 名称
-     * @param key       键名
-     * @param value     要写入的值
-     * @param filePath  INI 文件路径
-     */
-    inline void setInt(const std::string& section, 
-                       const std::string& key, 
-                       int value,
-                       const std::string& filePath) {
-        ult::setIniFileValue(filePath, section, key, std::to_string(value));
-    }
-    
-    /**
-     * 写入布尔值
-     * @param section   Section 名称
-     * @param key       键名
-     * @param value     要写入的值
-     * @param filePath  INI 文件路径
-     */
-    inline void setBool(const std::string& section, 
-                        const std::string& key, 
-                        bool value,
-                        const std::string& filePath) {
-        ult::setIniFileValue(filePath, section, key, value ? "true" : "false");
-    }
-    
-    /**
-     * 删除键
-     * @param section   Section 名称
-     * @param key       键名
-     * @param filePath  INI 文件路径
-     */
-    inline void removeKey(const std::string& section, 
-                          const std::string& key,
-                          const std::string& filePath) {
-        ult::removeIniKey(filePath, section, key);
-    }
-    
+
+        // 重新解析整个文件
+        void load() {
+            std::lock_guard<std::recursive_mutex> lock(s_mutex);
+            m_sections.clear();
+            m_dirty = false;
+            m_loaded = true;
+            std::string content;
+            if (!readAll(content)) {
+                m_size = -1;
+                return;
+            }
+            m_size = content.size();
+            m_hash = hash(content);
+            stamp();
+            Section* sec = nullptr;
+            size_t pos = 0;
+            while (pos < content.size()) {
+                size_t end = content.find('\n', pos);
+                if (end == std::string::npos) end = content.size();
+                std::string text = trim(content.substr(pos, end - pos));
+                pos = end + 1;
+                if (text.empty() || text[0] == ';' || text[0] == '#') continue;
+                if (text.front() == '[' && text.back() == ']') {
+                    std::string name = trim(text.substr(1, text.size() - 2));
+                    sec = findSection(name);
+                    if (!sec) {
+                        m_sections.push_back({name, {}});
+                        sec = &m_sections.back();
+                    }
+                    continue;
+                }
+                size_t eq = text.find('=');
+                if (!sec || eq == std::string::npos) continue;
+                sec->second.push_back({trim(text.substr(0, eq)), trim(text.substr(eq + 1))});
+            }
+        }
+
+    private:
+        using Section = std::pair<std::string, std::vector<std::pair<std::string, std::string>>>;
+
+        std::string m_path;
+        std::vector<Section> m_sections;    // 保持文件中的顺序
+        bool m_dirty = false;
+        bool m_loaded = false;
+        long m_size = -1;                   // 上次解析/写回时的文件大小（-1=文件不存在）
+        u32 m_hash = 0;                     // 上次解析/写回时的文件内容哈希
+        time_t m_mtime = 0;                 // 上次解析/写回时的文件修改时间
+        u64 m_stampTick = 0;                // 上次解析/写回的时刻
+        bool m_settled = false;             // 修改时间的精度窗口已过，只比较文件信息
+
+        static constexpr u64 SETTLE_NS = 3000000000ULL;     // 大于 FAT 修改时间精度（2秒）
+
+        // 记录解析/写回后的文件信息
+        void stamp() {
+            struct stat st{};
+            m_mtime = stat(m_path.c_str(), &st) == 0 ? st.st_mtime : 0;
+            m_stampTick = armGetSystemTick();
+            m_settled = false;
+        }
+
+        static std::string trim(const std::string& text) {
+            size_t begin = text.find_first_not_of(" \t\r\n");
+            if (begin == std::string::npos) return "";
+            size_t end = text.find_last_not_of(" \t\r\n");
+            return text.substr(begin, end - begin + 1);
+        }
+
+        // 读取整个文件（配置文件都只有几KB）
+        bool readAll(std::string& out) const {
+            out.clear();
+            FILE* fp = fopen(m_path.c_str(), "rb");
+            if (!fp) return false;
+            char buf[512];
+            size_t n;
+            while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) out.append(buf, n);
+            fclose(fp);
+            return true;
+        }
+
+        // 文件内容的 FNV-1a 哈希
+        static u32 hash(const std::string& content) {
+            u32 h = 2166136261u;
+            for (char c : content) h = (h ^ static_cast<u8>(c)) * 16777619u;
+            return h;
+        }
+
+        Section* findSection(const std::string& section) {
+            for (auto& sec : m_sections) if (sec.first == section) return &sec;
+            return nullptr;
+        }
+
+        const std::string* find(const std::string& section, const std::string& key) const {
+            for (const auto& sec : m_sections) {
+                if (sec.first != section) continue;
+                for (const auto& kv : sec.second) if (kv.first == key) return &kv.second;
+            }
+            return nullptr;
+        }
+    };
+
+    inline std::unordered_map<std::string, IniFile> s_files;    // 已打开的缓存文件（按路径）
+
     /**
-     * 删除整个 Section
-     * @param section   Section 名称
-     * @param filePath  INI 文件路径
+     * 取得缓存的 INI 文件（同一路径共享同一对象，文件被外部修改时重新解析）
+     * @param filePath  INI 文件路径（"sdmc:/config/..." 与 "/config/..." 视为同一文件）
+     * @return 缓存的 INI 文件
      */
-    inline void removeSection(const std::string& section,
-                              const std::string& filePath) {
-        ult::removeIniSection(filePath, section);
+    inline IniFile& open(const std::string& filePath) {
+        std::lock_guard<std::recursive_mutex> lock(s_mutex);
+        std::string key = filePath.compare(0, 5, "sdmc:") == 0 ? filePath.substr(5) : filePath;
+        auto it = s_files.find(key);
+        if (it == s_files.end()) it = s_files.emplace(key, IniFile(filePath)).first;
+        if (it->second.isStale()) it->second.load();
+        return it->second;
     }
 }
 
@@ -23,9 +23,71 @@
 // 白名单控制
 #define CMD_RELOAD_WHITELIST  11  // 重载白名单
 
+// 状态查询（只读）
+#define CMD_QUERY_STATUS      12  // 查询运行状态
+
+// 映射方案
+#define CMD_NEXT_PROFILE      13  // 切换到下一个映射方案
+
+// 内存查询（只读）
+#define CMD_QUERY_MEMORY      14  // 查询内存池和堆的使用情况
+
 // 系统控制
 #define CMD_EXIT              999 // 退出系统模块
 
+// 运行中的功能位（KeyXStatus::features）
+#define STATUS_FEATURE_TURBO    (1 << 0)   // 连发已开启
+#define STATUS_FEATURE_MACRO    (1 << 1)   // 宏已开启
+#define STATUS_FEATURE_MAPPING  (1 << 2)   // 映射已开启
+#define STATUS_FEATURE_FOCUS    (1 << 3)   // 游戏在前台
+#define STATUS_FEATURE_RUNNING  (1 << 4)   // 按键线程运行中
+#define STATUS_FEATURE_PAUSED   (1 << 5)   // 按键线程已暂停
+
+// 运行状态 - 与 sys-KeyX 保持一致
+struct KeyXStatus {
+    u64 tid;                // 当前游戏 TID（无游戏为0）
+    u32 features;           // 功能位（STATUS_FEATURE_*）
+    u8  controllerType;     // 手柄类型（0=无, 1=Pro, 2=双JoyCon, 3=SystemExt, 4=JoyCon, 5=Lite）
+    u8  turboActive;        // 连发是否正在执行
+    u8  turboPressed;       // 连发当前处于按下周期
+    u8  macroPlaying;       // 宏是否正在播放
+    s32 macroIndex;         // 正在播放的宏索引（-1=无）
+    u32 macroFrameIndex;    // 宏当前帧
+    u32 macroFrameCount;    // 宏总帧数
+    u32 pollIntervalMs;     // 当前游戏状态检测间隔（焦点变化检测延迟的上限）
+    u64 loopTicks;          // 按键线程循环次数
+    u64 injectTicks;        // 按键线程注入次数
+    u32 launchLatencyUs;    // 上次游戏启动：检测轮询被唤醒 → 功能生效的耗时（不含之前最多 pollIntervalMs 的等待）
+    u32 focusLatencyUs;     // 上次焦点变化：检测轮询被唤醒 → 暂停/恢复生效的耗时（同上）
+    u32 hotplugLatencyUs;   // 上次手柄连接：连接事件唤醒主循环 → 映射生效的耗时
+    u8  remapProfile;       // 当前映射方案（0=默认 [MAPPING]）
+    u8  remapProfileCount;  // 映射方案数量
+    u32 allocViolations;    // 按键线程中的堆分配次数（仅 ALLOC_TRIPWIRE 调试构建统计）
+    u8  inputPriority;      // 按键线程优先级
+    s8  inputCore;          // 按键线程核心（-2=默认）
+    u32 wakeSamples;        // 按键线程唤醒次数（本次游戏）
+    u32 wakeJitterP50Us;    // 唤醒延迟 p50（比预定时间晚多少）
+    u32 wakeJitterP99Us;    // 唤醒延迟 p99
+    u32 wakeJitterMaxUs;    // 唤醒延迟最大值
+} __attribute__((packed));
+
+// 单个内存池的统计
+struct KeyXPoolStats {
+    u32 capacity;           // 预算上限
+    u32 used;               // 当前使用
+    u32 peak;               // 历史峰值
+    u32 failures;           // 超出预算的分配次数
+} __attribute__((packed));
+
+// 内存统计（CMD_QUERY_MEMORY 的返回数据，与 sys-KeyX 保持一致）
+#define KEYX_MEMPOOL_COUNT  3
+struct KeyXMemoryStats {
+    KeyXPoolStats pools[KEYX_MEMPOOL_COUNT];   // 0=宏帧数据, 1=配置, 2=日志
+    u32 heapCapacity;       // 堆大小
+    u32 heapUsed;           // 堆当前已分配
+    u32 heapPeak;           // 堆已向系统申请的总量（只增不减）
+} __attribute__((packed));
+
 /**
  * IPC管理类 - 负责与 sys-KeyX 系统模块的通信
  * 
@@ -156,6 +218,29 @@ public:
      * @note 重载白名单配置
      */
     Result sendReloadWhitelistCommand();
+    
+    /**
+     * 发送切换映射方案命令给系统模块
+     * @return Result 0=成功，其他=失败
+     * @note 按顺序切换到下一个映射方案，只在游戏前台且映射开启时生效
+     */
+    Result sendNextProfileCommand();
+    
+    /**
+     * 查询系统模块的运行状态
+     * @param out 返回的状态数据
+     * @return Result 0=成功，其他=失败（系统模块未运行时返回失败）
+     * @note 只读命令，不会自动启动系统模块
+     */
+    Result queryStatus(KeyXStatus& out);
+    
+    /**
+     * 查询系统模块的内存池和堆使用情况
+     * @param out 返回的内存统计
+     * @return Result 0=成功，其他=失败（系统模块未运行时返回失败）
+     * @note 只读命令，不会自动启动系统模块
+     */
+    Result queryMemory(KeyXMemoryStats& out);
 };
 
 // 全局实例 - 程序退出时自动调用析构函数
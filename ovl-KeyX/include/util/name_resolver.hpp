@@ -0,0 +1,96 @@
+#pragma once
+#include <switch.h>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include "game.hpp"
+
+// 后台游戏名称解析：列表界面把缓存未命中的 Title ID 交给工作线程逐个读取，
+// 结果经单生产者单消费者环形队列交回界面线程，界面每帧只取结果，不再等待控制数据读取
+namespace NameResolver {
+
+    struct Result {
+        u32 index;          // 调用方的条目下标
+        bool found;         // 是否读取到名称
+        char name[64];      // 游戏名称
+    };
+
+    constexpr size_t STACK_SIZE = 16 * 1024;
+    constexpr u32 QUEUE_SIZE = 32;                      // 结果队列容量（必须是2的幂）
+    constexpr u32 QUEUE_MASK = QUEUE_SIZE - 1;
+    constexpr u64 WAIT_INTERVAL_NS = 1000000ULL;        // 队列满时 1ms 后重试
+
+    inline Thread s_thread;
+    inline bool s_created = false;
+    inline std::vector<std::pair<u32, u64>> s_jobs;     // 待解析（下标, Title ID）
+    inline const void* s_owner = nullptr;               // 发起本批解析的界面（结果只交给它）
+    inline std::atomic<bool> s_exit{false};
+
+    // 工作线程 → 界面线程
+    inline Result s_queue[QUEUE_SIZE];
+    inline std::atomic<u32> s_queueHead{0};             // 下一个写入位置（工作线程）
+    inline std::atomic<u32> s_queueTail{0};             // 下一个读取位置（界面线程）
+
+    inline void threadFunc(void*) {
+        for (const auto& job : s_jobs) {
+            if (s_exit) break;
+            Result result{};
+            result.index = job.first;
+            result.found = GameMonitor::getTitleIdGameName(job.second, result.name);
+
+            // 队列满时等待界面线程取走
+            u32 head = s_queueHead.load(std::memory_order_relaxed);
+            while (head - s_queueTail.load(std::memory_order_acquire) >= QUEUE_SIZE) {
+                if (s_exit) return;
+                svcSleepThread(WAIT_INTERVAL_NS);
+            }
+            s_queue[head & QUEUE_MASK] = result;
+            s_queueHead.store(head + 1, std::memory_order_release);
+        }
+        if (!s_exit) GameMonitor::saveTitleNameCache();
+    }
+
+    // 停止解析并丢弃未取走的结果（owner 不为空时只停止该界面发起的解析）
+    inline void stop(const void* owner = nullptr) {
+        if (owner && owner != s_owner) return;
+        if (s_created) {
+            s_exit = true;
+            threadWaitForExit(&s_thread);
+            threadClose(&s_thread);
+            s_created = false;
+        }
+        s_jobs.clear();
+        s_jobs.shrink_to_fit();
+        s_owner = nullptr;
+        s_queueHead = 0;
+        s_queueTail = 0;
+    }
+
+    // 开始解析一批 Title ID（会先停止上一批）
+    inline void start(const void* owner, std::vector<std::pair<u32, u64>> jobs) {
+        stop();
+        if (jobs.empty()) return;
+        s_owner = owner;
+        s_jobs = std::move(jobs);
+        s_exit = false;
+        memset(&s_thread, 0, sizeof(Thread));
+        if (R_SUCCEEDED(threadCreate(&s_thread, threadFunc, nullptr, nullptr, STACK_SIZE, 0x2C, -2))) {
+            s_created = true;
+            threadStart(&s_thread);
+        } else {
+            s_jobs.clear();
+            s_owner = nullptr;
+        }
+    }
+
+    // 界面线程取出一个结果，没有结果或不是该界面发起的解析时返回false
+    inline bool poll(const void* owner, Result& out) {
+        if (owner != s_owner) return false;
+        u32 tail = s_queueTail.load(std::memory_order_relaxed);
+        if (tail == s_queueHead.load(std::memory_order_acquire)) return false;
+        out = s_queue[tail & QUEUE_MASK];
+        s_queueTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+}
@@ -4,19 +4,25 @@
 #include <sys/stat.h>
 #include <cstring>
 #include <algorithm>
-#include <ultra.hpp>
 
 
 // 静态成员定义
 char MacroData::s_filePath[128];
 MacroHeader MacroData::s_header;
 MacroBasicInfo MacroData::s_basicInfo;
-std::vector<MacroFrame> MacroData::s_frames;
-std::vector<MacroFrameV2> MacroData::s_framesV2;
+PieceTable<MacroFrame> MacroData::s_frames;
+PieceTable<MacroFrameV2> MacroData::s_framesV2;
 std::vector<Action> MacroData::s_actions;
+std::vector<u32> MacroData::s_frameIndex;
+u32 MacroData::s_editVersion = 0;
 
-// 撤销快照栈
-std::vector<MacroData::UndoSnapshot> MacroData::s_undoStack;
+// 撤销/重做记录
+std::vector<MacroData::EditRecord> MacroData::s_undoStack;
+std::vector<MacroData::EditRecord> MacroData::s_redoStack;
+MacroData::EditRecord MacroData::s_pendingEdit;
+u32 MacroData::s_pendingActionCount = 0;
+u32 MacroData::s_pendingFrameCount = 0;
+size_t MacroData::s_journalBytes = 0;
 
 // 摇杆死区 (约2%)
 constexpr s32 STICK_DEADZONE = 655;
@@ -55,11 +61,41 @@ bool MacroData::isSameState(const MacroFrameV2& a, const MacroFrameV2& b) {
     return true;
 }
 
+// 重建帧索引（线性建树）
+void MacroData::rebuildFrameIndex() {
+    size_t n = s_actions.size();
+    s_frameIndex.assign(n + 1, 0);
+    for (size_t i = 1; i <= n; i++) {
+        s_frameIndex[i] += s_actions[i - 1].frameCount;
+        size_t parent = i + (i & -i);
+        if (parent <= n) s_frameIndex[parent] += s_frameIndex[i];
+    }
+}
+
+// 单个动作的帧数变化（delta 为新帧数 - 旧帧数）
+void MacroData::adjustFrameIndex(s32 actionIndex, s32 delta) {
+    for (size_t i = actionIndex + 1; i < s_frameIndex.size(); i += (i & -i))
+        s_frameIndex[i] += delta;
+}
+
+// 获取动作的帧起始位置（之前所有动作的帧数之和）
+s32 MacroData::getFrameStart(s32 actionIndex) {
+    s32 sum = 0;
+    for (size_t i = actionIndex; i > 0; i -= (i & -i))
+        sum += s_frameIndex[i];
+    return sum;
+}
+
 // 加载获取宏基础数据
 bool MacroData::load(const char* filePath) {
+    setFilePath(filePath);
+    return loadFrameAndBasicInfo(filePath);
+}
+
+// 只设置文件路径（帧数据在进入编辑界面时才加载）
+void MacroData::setFilePath(const char* filePath) {
     strncpy(s_filePath, filePath, sizeof(s_filePath) - 1);
     s_filePath[sizeof(s_filePath) - 1] = '\0';
-    return loadFrameAndBasicInfo(filePath);
 }
 
 // 从备份文件加载宏数据
@@ -81,13 +117,16 @@ bool MacroData::loadFrameAndBasicInfo(const char* filePath) {
     if (!fp) return false;
     // 读取文件头
     fread(&s_header, sizeof(MacroHeader), 1, fp);
-    // 获取所有帧数据
+    // 获取所有帧数据（作为分段表的原始缓冲）
     if (s_header.version == 1) {
-        s_frames.resize(s_header.frameCount);
-        fread(s_frames.data(), sizeof(MacroFrame), s_header.frameCount, fp);
+        std::vector<MacroFrame> frames(s_header.frameCount);
+        fread(frames.data(), sizeof(MacroFrame), s_header.frameCount, fp);
+        s_frames.load(std::move(frames));
     } else {
-        s_framesV2.resize(s_header.frameCount);
-        fread(s_framesV2.data(), sizeof(MacroFrameV2), s_header.frameCount, fp);
+        std::vector<MacroFrameV2> frames(s_header.frameCount);
+        fread(frames.data(), sizeof(MacroFrameV2), s_header.frameCount, fp);
+        for (const auto& frame : frames) s_basicInfo.durationMs += frame.durationMs;
+        s_framesV2.load(std::move(frames));
     }
     fclose(fp);
     
@@ -97,7 +136,6 @@ bool MacroData::loadFrameAndBasicInfo(const char* filePath) {
     s_basicInfo.frameRate = s_header.frameRate;
     s_basicInfo.frameCount = s_header.frameCount;
     if (s_header.version == 1) s_basicInfo.durationMs = s_header.frameRate ? (s_header.frameCount * 1000 / s_header.frameRate) : 0;
-    else for (const auto& frame : s_framesV2) s_basicInfo.durationMs += frame.durationMs;
     struct stat st{};
     if (stat(path, &st) == 0) s_basicInfo.fileSize = st.st_size;
     else s_basicInfo.fileSize = 0;
@@ -120,45 +158,71 @@ const char* MacroData::getFilePath() {
 
 // 保存编辑后的宏数据（统一入口）
 bool MacroData::saveForEdit() {
-    // 先将原文件备份
+    // 先将原文件重命名为备份（不复制文件内容），再写入新文件
     char bakPath[128];
     snprintf(bakPath, sizeof(bakPath), "%s.bak", s_filePath);
-    ult::copyFileOrDirectory(s_filePath, bakPath);
-    // 再修改
+    remove(bakPath);
+    bool hasBak = (rename(s_filePath, bakPath) == 0);
     FILE* fp = fopen(s_filePath, "wb");
-    if (!fp) return false;
-    if (s_header.version == 1) saveForEditV1(fp);
-    else saveForEditV2(fp);
-    fclose(fp);
+    if (!fp) {
+        if (hasBak) rename(bakPath, s_filePath);   // 写入失败，恢复原文件
+        return false;
+    }
+    bool ok = (s_header.version == 1) ? saveForEditV1(fp) : saveForEditV2(fp);
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) {
+        // 写入失败（如SD卡已满）：删除写了一半的文件，恢复原文件，索引保持不变
+        remove(s_filePath);
+        if (hasBak) rename(bakPath, s_filePath);
+        return false;
+    }
+    // 更新宏索引（帧数和时长已在保存时算出，无需重新读取文件）
+    MacroUtil::updateIndexEntry(s_filePath, s_header.version, s_header.frameCount, s_basicInfo.durationMs);
     return true;
 }
 
 // V1: 保存帧数据
-void MacroData::saveForEditV1(FILE* fp) {
-    s_header.frameCount = s_frames.size();
-    fwrite(&s_header, sizeof(MacroHeader), 1, fp);
-    fwrite(s_frames.data(), sizeof(MacroFrame), s_frames.size(), fp);
+bool MacroData::saveForEditV1(FILE* fp) {
+    std::vector<MacroFrame> frames;
+    s_frames.flatten(frames);
+    s_header.frameCount = frames.size();
+    s_basicInfo.frameCount = s_header.frameCount;
+    s_basicInfo.durationMs = s_header.frameRate ? (s_header.frameCount * 1000 / s_header.frameRate) : 0;
+    return fwrite(&s_header, sizeof(MacroHeader), 1, fp) == 1 &&
+           fwrite(frames.data(), sizeof(MacroFrame), frames.size(), fp) == frames.size();
 }
 
 // V2: 保存帧数据
-void MacroData::saveForEditV2(FILE* fp) {
-    
-    // 合并相邻相同的帧（消除编辑产生的碎片）
-    for (size_t i = 1; i < s_framesV2.size(); ) {
-        auto& prev = s_framesV2[i - 1];
-        auto& curr = s_framesV2[i];
-        if (prev.keysHeld == curr.keysHeld && 
-            prev.leftX == curr.leftX && prev.leftY == curr.leftY &&
-            prev.rightX == curr.rightX && prev.rightY == curr.rightY) {
-            prev.durationMs += curr.durationMs;
-            s_framesV2.erase(s_framesV2.begin() + i);
-        } else {
-            i++;
+bool MacroData::saveForEditV2(FILE* fp) {
+    std::vector<MacroFrameV2> frames;
+    s_framesV2.flatten(frames);
+    
+    // 合并相邻相同的帧（消除编辑产生的碎片），单次遍历原地压缩
+    size_t count = 0;
+    u32 totalMs = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        const auto& curr = frames[i];
+        totalMs += curr.durationMs;
+        if (count > 0) {
+            auto& prev = frames[count - 1];
+            if (prev.keysHeld == curr.keysHeld && 
+                prev.leftX == curr.leftX && prev.leftY == curr.leftY &&
+                prev.rightX == curr.rightX && prev.rightY == curr.rightY) {
+                prev.durationMs += curr.durationMs;
+                continue;
+            }
         }
+        if (count != i) frames[count] = curr;
+        count++;
     }
-    s_header.frameCount = s_framesV2.size();
-    fwrite(&s_header, sizeof(MacroHeader), 1, fp);
-    fwrite(s_framesV2.data(), sizeof(MacroFrameV2), s_framesV2.size(), fp);
+    frames.resize(count);
+    s_header.frameCount = frames.size();
+    s_basicInfo.frameCount = s_header.frameCount;
+    s_basicInfo.durationMs = totalMs;
+    bool ok = fwrite(&s_header, sizeof(MacroHeader), 1, fp) == 1 &&
+              fwrite(frames.data(), sizeof(MacroFrameV2), frames.size(), fp) == frames.size();
+    s_framesV2.load(std::move(frames));
+    return ok;
 }
 
 // 获取文件头数据
@@ -176,22 +240,25 @@ void MacroData::parseActions() {
     s_actions.clear();
     if (s_header.version == 1) parseActionsV1();
     else parseActionsV2();
+    rebuildFrameIndex();
+    s_editVersion++;
 }
 
 // V1: 解析帧数据到动作列表
 void MacroData::parseActionsV1() {
     if (s_frames.empty()) return;
+    const MacroFrame* frames = s_frames.data();
     
     Action current;
-    current.buttons = s_frames[0].keysHeld;
-    current.stickL = getStickDir(s_frames[0].leftX, s_frames[0].leftY);
-    current.stickR = getStickDir(s_frames[0].rightX, s_frames[0].rightY);
+    current.buttons = frames[0].keysHeld;
+    current.stickL = getStickDir(frames[0].leftX, frames[0].leftY);
+    current.stickR = getStickDir(frames[0].rightX, frames[0].rightY);
     current.frameCount = 1;
     current.stickMergedVirtual = false;
     
     for (size_t i = 1; i < s_frames.size(); i++) {
-        const auto& cur = s_frames[i];
-        const auto& prev = s_frames[i-1];
+        const auto& cur = frames[i];
+        const auto& prev = frames[i-1];
         
         // 判断是否是纯摇杆
         bool curIsPureStick = (cur.keysHeld == 0) && 
@@ -242,12 +309,13 @@ void MacroData::parseActionsV1() {
 // V2: 解析帧数据到动作列表
 void MacroData::parseActionsV2() {
     if (s_framesV2.empty()) return;
+    const MacroFrameV2* frames = s_framesV2.data();
     
     Action current;
     bool inStickMerge = false;  // 正在累积摇杆（纯摇杆或按键+摇杆）
     
     for (size_t i = 0; i < s_framesV2.size(); i++) {
-        const auto& frame = s_framesV2[i];
+        const auto& frame = frames[i];
         
         bool hasStick = (getStickDir(frame.leftX, frame.leftY) != StickDir::None || 
                          getStickDir(frame.rightX, frame.rightY) != StickDir::None);
@@ -265,7 +333,7 @@ void MacroData::parseActionsV2() {
                 inStickMerge = true;
             } else {
                 // 继续累积，检查按键相同+八向相同
-                if (frame.keysHeld == current.buttons && isSameState(frame, s_framesV2[i-1])) {
+                if (frame.keysHeld == current.buttons && isSameState(frame, frames[i-1])) {
                     current.duration += frame.durationMs;
                     current.frameCount++;
                     current.stickMergedVirtual = true;
@@ -307,6 +375,11 @@ std::vector<Action>& MacroData::getActions() {
     return s_actions;
 }
 
+// 获取动作列表版本号
+u32 MacroData::getEditVersion() {
+    return s_editVersion;
+}
+
 // 更新总时长
 void MacroData::updateDurationMs() {
     s_basicInfo.durationMs = 0;
@@ -317,57 +390,51 @@ void MacroData::updateDurationMs() {
 
 // 插入一个无动作（100ms，不合并）
 void MacroData::insertAction(s32 actionIndex, bool insertBefore) {
-    saveSnapshot();
     s32 insertPos = insertBefore ? actionIndex : actionIndex + 1;
+    beginEdit(insertPos, insertPos);
     
     // 计算帧插入位置
-    s32 frameInsertPos = 0;
-    for (s32 i = 0; i < insertPos && i < (s32)s_actions.size(); i++)
-        frameInsertPos += s_actions[i].frameCount;
+    s32 frameInsertPos = getFrameStart(std::min(insertPos, (s32)s_actions.size()));
     
     if (s_header.version == 1) {
         // V1: 计算100ms对应的帧数
         u32 newFrameCount = (100 * s_header.frameRate + 500) / 1000;
-        s_frames.insert(s_frames.begin() + frameInsertPos, newFrameCount, {});
+        s_frames.insert(frameInsertPos, newFrameCount, MacroFrame{});
         s_header.frameCount = s_frames.size();
         Action newAction = {0, StickDir::None, StickDir::None, 100, newFrameCount, true, false};
         s_actions.insert(s_actions.begin() + insertPos, newAction);
     } else {
         // V2: 直接100ms
-        s_framesV2.insert(s_framesV2.begin() + frameInsertPos, {100, 0, 0, 0, 0, 0});
+        s_framesV2.insert(frameInsertPos, 1, MacroFrameV2{100, 0, 0, 0, 0, 0});
         s_header.frameCount++;
         Action newAction = {0, StickDir::None, StickDir::None, 100, 1, true, false};
         s_actions.insert(s_actions.begin() + insertPos, newAction);
     }
     
+    rebuildFrameIndex();
     updateDurationMs();
+    commitEdit();
 }
 
 // 复制动作到指定位置
 void MacroData::copyActions(s32 startIndex, s32 endIndex, bool insertBefore) {
     if (startIndex < 0 || endIndex >= (s32)s_actions.size() || startIndex > endIndex) return;
     
-    saveSnapshot();
-    
     // 计算源动作的帧范围
-    s32 srcFrameStart = 0;
-    for (s32 i = 0; i < startIndex; i++) srcFrameStart += s_actions[i].frameCount;
-    u32 totalFrames = 0;
-    for (s32 i = startIndex; i <= endIndex; i++) totalFrames += s_actions[i].frameCount;
+    s32 srcFrameStart = getFrameStart(startIndex);
+    u32 totalFrames = getFrameStart(endIndex + 1) - srcFrameStart;
     
     // 计算插入位置
     s32 insertPos = insertBefore ? startIndex : endIndex + 1;
-    s32 insertFramePos = 0;
-    for (s32 i = 0; i < insertPos; i++) insertFramePos += s_actions[i].frameCount;
+    beginEdit(insertPos, insertPos);
+    s32 insertFramePos = getFrameStart(insertPos);
     
     // 复制帧数据
     if (s_header.version == 1) {
-        std::vector<MacroFrame> copiedFrames(s_frames.begin() + srcFrameStart, s_frames.begin() + srcFrameStart + totalFrames);
-        s_frames.insert(s_frames.begin() + insertFramePos, copiedFrames.begin(), copiedFrames.end());
+        s_frames.insertCopy(insertFramePos, srcFrameStart, totalFrames);
         s_header.frameCount = s_frames.size();
     } else {
-        std::vector<MacroFrameV2> copiedFrames(s_framesV2.begin() + srcFrameStart, s_framesV2.begin() + srcFrameStart + totalFrames);
-        s_framesV2.insert(s_framesV2.begin() + insertFramePos, copiedFrames.begin(), copiedFrames.end());
+        s_framesV2.insertCopy(insertFramePos, srcFrameStart, totalFrames);
         s_header.frameCount = s_framesV2.size();
     }
     
@@ -380,37 +447,33 @@ void MacroData::copyActions(s32 startIndex, s32 endIndex, bool insertBefore) {
     }
     
     // 再插入动作（不合并，保持独立）
-    for (size_t i = 0; i < copiedActions.size(); i++) {
-        s_actions.insert(s_actions.begin() + insertPos + i, copiedActions[i]);
-    }
+    s_actions.insert(s_actions.begin() + insertPos, copiedActions.begin(), copiedActions.end());
     
+    rebuildFrameIndex();
     updateDurationMs();
+    commitEdit();
 }
 
 void MacroData::resetActions(s32 startIndex, s32 endIndex) {
-    saveSnapshot();
+    beginEdit(startIndex, endIndex + 1);
     
     // 计算帧起始位置
-    s32 frameStart = 0;
-    for (s32 i = 0; i < startIndex; i++)
-        frameStart += s_actions[i].frameCount;
+    s32 frameStart = getFrameStart(startIndex);
     
     // 计算总帧数和V2总时长
-    u32 totalFrames = 0;
+    u32 totalFrames = getFrameStart(endIndex + 1) - frameStart;
     u32 totalDurationV2 = 0;
     for (s32 i = startIndex; i <= endIndex; i++) {
-        totalFrames += s_actions[i].frameCount;
         totalDurationV2 += s_actions[i].duration;
     }
     
     if (s_header.version == 1) {
         // V1: 每帧清零，帧数量不变
-        for (u32 i = 0; i < totalFrames; i++)
-            s_frames[frameStart + i] = {};
+        s_frames.erase(frameStart, totalFrames);
+        s_frames.insert(frameStart, totalFrames, MacroFrame{});
         
         // 删除选中动作
-        for (s32 i = endIndex; i >= startIndex; i--)
-            s_actions.erase(s_actions.begin() + i);
+        s_actions.erase(s_actions.begin() + startIndex, s_actions.begin() + endIndex + 1);
         
         // 插入新无动作，duration从帧数重新计算
         u32 totalDuration = totalFrames * 1000 / s_header.frameRate;
@@ -418,62 +481,57 @@ void MacroData::resetActions(s32 startIndex, s32 endIndex) {
         s_actions.insert(s_actions.begin() + startIndex, newAction);
     } else {
         // V2: 合并成1帧，清零
-        s_framesV2[frameStart] = {totalDurationV2, 0, 0, 0, 0, 0};
-        if (totalFrames > 1) {
-            s_framesV2.erase(s_framesV2.begin() + frameStart + 1, s_framesV2.begin() + frameStart + totalFrames);
-            s_header.frameCount = s_framesV2.size();
-        }
+        s_framesV2.erase(frameStart, totalFrames);
+        s_framesV2.insert(frameStart, 1, MacroFrameV2{totalDurationV2, 0, 0, 0, 0, 0});
+        s_header.frameCount = s_framesV2.size();
         
         // 删除选中动作
-        for (s32 i = endIndex; i >= startIndex; i--)
-            s_actions.erase(s_actions.begin() + i);
+        s_actions.erase(s_actions.begin() + startIndex, s_actions.begin() + endIndex + 1);
         
         // 插入新无动作
         Action newAction = {0, StickDir::None, StickDir::None, totalDurationV2, 1, true, false};
         s_actions.insert(s_actions.begin() + startIndex, newAction);
     }
 
+    rebuildFrameIndex();
     updateDurationMs();
+    commitEdit();
 }
 
 // 删除动作内部实现（不保存快照、不合并、不更新时长）
 void MacroData::deleteActionsInternal(s32 startIndex, s32 endIndex) {
     // 计算帧起始位置
-    s32 frameStart = 0;
-    for (s32 i = 0; i < startIndex; i++) {
-        frameStart += s_actions[i].frameCount;
-    }
+    s32 frameStart = getFrameStart(startIndex);
     
     // 计算要删除的总帧数
-    u32 totalFrames = 0;
-    for (s32 i = startIndex; i <= endIndex; i++) {
-        totalFrames += s_actions[i].frameCount;
-    }
+    u32 totalFrames = getFrameStart(endIndex + 1) - frameStart;
     
     // 删除帧数据
     if (s_header.version == 1) {
-        s_frames.erase(s_frames.begin() + frameStart, s_frames.begin() + frameStart + totalFrames);
+        s_frames.erase(frameStart, totalFrames);
         s_header.frameCount = s_frames.size();
     } else {
-        s_framesV2.erase(s_framesV2.begin() + frameStart, s_framesV2.begin() + frameStart + totalFrames);
+        s_framesV2.erase(frameStart, totalFrames);
         s_header.frameCount = s_framesV2.size();
     }
     
     // 删除动作
     s_actions.erase(s_actions.begin() + startIndex, s_actions.begin() + endIndex + 1);
+    rebuildFrameIndex();
 }
 
 void MacroData::deleteActions(s32 startIndex, s32 endIndex) {
-    saveSnapshot();
+    beginEdit(startIndex, endIndex + 1);
     deleteActionsInternal(startIndex, endIndex);
     updateDurationMs();
+    commitEdit();
 }
 
 // 清除摇杆数据
 void MacroData::clearStick(s32 startIndex, s32 endIndex, StickTarget target) {
     if (startIndex < 0 || endIndex >= (s32)s_actions.size() || startIndex > endIndex) return;
     
-    saveSnapshot();
+    beginEdit(startIndex, endIndex + 1);
     
     // 从后往前遍历（避免删除后索引变化）
     for (s32 i = endIndex; i >= startIndex; i--) {
@@ -490,27 +548,30 @@ void MacroData::clearStick(s32 startIndex, s32 endIndex, StickTarget target) {
         if (!hasTargetStick) continue;
         
         // 清零摇杆坐标
-        s32 frameStart = 0;
-        for (s32 j = 0; j < i; j++) frameStart += s_actions[j].frameCount;
+        s32 frameStart = getFrameStart(i);
+        MacroFrame* frames = nullptr;
+        MacroFrameV2* framesV2 = nullptr;
+        if (s_header.version == 1) frames = s_frames.writable(frameStart, s_actions[i].frameCount);
+        else framesV2 = s_framesV2.writable(frameStart, s_actions[i].frameCount);
         
         for (u32 f = 0; f < s_actions[i].frameCount; f++) {
             if (s_header.version == 1) {
                 if (target != StickTarget::Right) {
-                    s_frames[frameStart + f].leftX = 0;
-                    s_frames[frameStart + f].leftY = 0;
+                    frames[f].leftX = 0;
+                    frames[f].leftY = 0;
                 }
                 if (target != StickTarget::Left) {
-                    s_frames[frameStart + f].rightX = 0;
-                    s_frames[frameStart + f].rightY = 0;
+                    frames[f].rightX = 0;
+                    frames[f].rightY = 0;
                 }
             } else {
                 if (target != StickTarget::Right) {
-                    s_framesV2[frameStart + f].leftX = 0;
-                    s_framesV2[frameStart + f].leftY = 0;
+                    framesV2[f].leftX = 0;
+                    framesV2[f].leftY = 0;
                 }
                 if (target != StickTarget::Left) {
-                    s_framesV2[frameStart + f].rightX = 0;
-                    s_framesV2[frameStart + f].rightY = 0;
+                    framesV2[f].rightX = 0;
+                    framesV2[f].rightY = 0;
                 }
             }
         }
@@ -528,10 +589,11 @@ void MacroData::clearStick(s32 startIndex, s32 endIndex, StickTarget target) {
             } else {   // V2：时间序列，累加时间到第1帧，删除多余帧
                 u32 totalDuration = 0;
                 for (u32 f = 0; f < s_actions[i].frameCount; f++) {
-                    totalDuration += s_framesV2[frameStart + f].durationMs;
+                    totalDuration += framesV2[f].durationMs;
                 }
-                s_framesV2[frameStart].durationMs = totalDuration;
-                s_framesV2.erase(s_framesV2.begin() + frameStart + 1, s_framesV2.begin() + frameStart + s_actions[i].frameCount);
+                framesV2[0].durationMs = totalDuration;
+                s_framesV2.erase(frameStart + 1, s_actions[i].frameCount - 1);
+                adjustFrameIndex(i, 1 - (s32)s_actions[i].frameCount);
                 s_actions[i].frameCount = 1;
                 s_actions[i].duration = totalDuration;
             }
@@ -544,6 +606,7 @@ void MacroData::clearStick(s32 startIndex, s32 endIndex, StickTarget target) {
     }
     
     updateDurationMs();
+    commitEdit();
 }
 
 // 方向转坐标的辅助函数
@@ -566,11 +629,10 @@ static void dirToCoord(StickDir dir, s32& outX, s32& outY) {
 void MacroData::setActionStick(s32 actionIndex, StickDir leftDir, StickDir rightDir) {
     if (actionIndex < 0 || actionIndex >= (s32)s_actions.size()) return;
     
-    saveSnapshot();
+    beginEdit(actionIndex, actionIndex + 1);
     
     // 计算帧范围
-    s32 frameStart = 0;
-    for (s32 i = 0; i < actionIndex; i++) frameStart += s_actions[i].frameCount;
+    s32 frameStart = getFrameStart(actionIndex);
     
     // 转换方向为坐标
     s32 lx, ly, rx, ry;
@@ -579,40 +641,43 @@ void MacroData::setActionStick(s32 actionIndex, StickDir leftDir, StickDir right
     
     if (s_header.version == 1) {
         // V1：遍历所有帧设置坐标
+        MacroFrame* frames = s_frames.writable(frameStart, s_actions[actionIndex].frameCount);
         for (u32 f = 0; f < s_actions[actionIndex].frameCount; f++) {
-            s_frames[frameStart + f].leftX = lx;
-            s_frames[frameStart + f].leftY = ly;
-            s_frames[frameStart + f].rightX = rx;
-            s_frames[frameStart + f].rightY = ry;
+            frames[f].leftX = lx;
+            frames[f].leftY = ly;
+            frames[f].rightX = rx;
+            frames[f].rightY = ry;
         }
     } else {
         // V2
         if (s_actions[actionIndex].stickMergedVirtual) {
             // 虚拟合并：合并多帧为1帧
+            MacroFrameV2* frames = s_framesV2.writable(frameStart, s_actions[actionIndex].frameCount);
             u32 totalDuration = 0;
             for (u32 f = 0; f < s_actions[actionIndex].frameCount; f++)
-                totalDuration += s_framesV2[frameStart + f].durationMs;
+                totalDuration += frames[f].durationMs;
             
             // 设置第一帧
-            s_framesV2[frameStart].leftX = lx;
-            s_framesV2[frameStart].leftY = ly;
-            s_framesV2[frameStart].rightX = rx;
-            s_framesV2[frameStart].rightY = ry;
-            s_framesV2[frameStart].durationMs = totalDuration;
+            frames[0].leftX = lx;
+            frames[0].leftY = ly;
+            frames[0].rightX = rx;
+            frames[0].rightY = ry;
+            frames[0].durationMs = totalDuration;
             
             // 删除多余帧
             if (s_actions[actionIndex].frameCount > 1) {
-                s_framesV2.erase(s_framesV2.begin() + frameStart + 1,
-                                 s_framesV2.begin() + frameStart + s_actions[actionIndex].frameCount);
+                s_framesV2.erase(frameStart + 1, s_actions[actionIndex].frameCount - 1);
                 s_header.frameCount = s_framesV2.size();
             }
+            adjustFrameIndex(actionIndex, 1 - (s32)s_actions[actionIndex].frameCount);
             s_actions[actionIndex].frameCount = 1;
         } else {
             // 非虚拟合并：直接设置那1帧的坐标
-            s_framesV2[frameStart].leftX = lx;
-            s_framesV2[frameStart].leftY = ly;
-            s_framesV2[frameStart].rightX = rx;
-            s_framesV2[frameStart].rightY = ry;
+            MacroFrameV2* frame = s_framesV2.writable(frameStart, 1);
+            frame->leftX = lx;
+            frame->leftY = ly;
+            frame->rightX = rx;
+            frame->rightY = ry;
         }
     }
     
@@ -621,6 +686,7 @@ void MacroData::setActionStick(s32 actionIndex, StickDir leftDir, StickDir right
     s_actions[actionIndex].stickR = rightDir;
     s_actions[actionIndex].stickMergedVirtual = false;
     s_actions[actionIndex].modified = true;
+    commitEdit();
 }
 
 // 移动动作到指定位置
@@ -629,30 +695,20 @@ void MacroData::moveAction(s32 fromIndex, s32 toIndex) {
     if (toIndex < 0 || toIndex > (s32)s_actions.size()) return;
     if (fromIndex == toIndex || fromIndex == toIndex - 1) return;
     
-    // 保存快照
-    saveSnapshot();
+    // 记录受影响的区域（from < to 时为 [from, to)，否则为 [to, from]）
+    if (fromIndex < toIndex) beginEdit(fromIndex, toIndex);
+    else beginEdit(toIndex, fromIndex + 1);
     
     // 计算 fromIndex 动作的帧起始位置和帧数
-    s32 fromFrameStart = 0;
-    for (s32 i = 0; i < fromIndex; i++) fromFrameStart += s_actions[i].frameCount;
+    s32 fromFrameStart = getFrameStart(fromIndex);
     u32 frameCount = s_actions[fromIndex].frameCount;
     
     // 计算 toIndex 对应的帧插入位置
-    s32 toFrameStart = 0;
-    for (s32 i = 0; i < toIndex; i++) toFrameStart += s_actions[i].frameCount;
+    s32 toFrameStart = getFrameStart(toIndex);
     
     // 移动帧数据
-    if (s_header.version == 1) {
-        std::vector<MacroFrame> extractedFrames(s_frames.begin() + fromFrameStart, s_frames.begin() + fromFrameStart + frameCount);
-        s_frames.erase(s_frames.begin() + fromFrameStart, s_frames.begin() + fromFrameStart + frameCount);
-        if (toFrameStart > fromFrameStart) toFrameStart -= frameCount;
-        s_frames.insert(s_frames.begin() + toFrameStart, extractedFrames.begin(), extractedFrames.end());
-    } else {
-        std::vector<MacroFrameV2> extractedFrames( s_framesV2.begin() + fromFrameStart, s_framesV2.begin() + fromFrameStart + frameCount);
-        s_framesV2.erase(s_framesV2.begin() + fromFrameStart, s_framesV2.begin() + fromFrameStart + frameCount);
-        if (toFrameStart > fromFrameStart) toFrameStart -= frameCount;
-        s_framesV2.insert(s_framesV2.begin() + toFrameStart, extractedFrames.begin(), extractedFrames.end());
-    }
+    if (s_header.version == 1) s_frames.move(fromFrameStart, frameCount, toFrameStart);
+    else s_framesV2.move(fromFrameStart, frameCount, toFrameStart);
     
     // 标记受影响范围内的动作为 modified（toIndex 是插入位置，实际范围是 [from, to-1] 或 [to, from]）
     s32 rangeStart = (fromIndex < toIndex) ? fromIndex : toIndex;
@@ -666,12 +722,14 @@ void MacroData::moveAction(s32 fromIndex, s32 toIndex) {
     s_actions.erase(s_actions.begin() + fromIndex);
     if (toIndex > fromIndex) toIndex--;
     s_actions.insert(s_actions.begin() + toIndex, extractedAction);
+    rebuildFrameIndex();
+    commitEdit();
 }
 
 // 修改持续时间（支持多选）
 void MacroData::setActionDuration(s32 startIndex, s32 endIndex, u32 durationMs) {
     if (startIndex < 0 || endIndex >= (s32)s_actions.size() || startIndex > endIndex) return;
-    saveSnapshot();
+    beginEdit(startIndex, endIndex + 1);
     
     if (s_header.version == 1) {
         // V1: 根据持续时间计算帧数，修改每个动作对应的帧数据
@@ -681,17 +739,16 @@ void MacroData::setActionDuration(s32 startIndex, s32 endIndex, u32 durationMs)
         
         for (s32 i = startIndex; i <= endIndex; i++) {
             // 计算当前动作的帧起始位置
-            s32 frameStart = 0;
-            for (s32 j = 0; j < i; j++)
-                frameStart += s_actions[j].frameCount;
+            s32 frameStart = getFrameStart(i);
             
             u32 oldFrameCount = s_actions[i].frameCount;
             if (newFrameCount != oldFrameCount) {
-                MacroFrame templateFrame = s_frames[frameStart];
+                MacroFrame templateFrame = s_frames.at(frameStart);
                 if (newFrameCount > oldFrameCount)
-                    s_frames.insert(s_frames.begin() + frameStart + oldFrameCount, newFrameCount - oldFrameCount, templateFrame);
+                    s_frames.insert(frameStart + oldFrameCount, newFrameCount - oldFrameCount, templateFrame);
                 else
-                    s_frames.erase(s_frames.begin() + frameStart + newFrameCount, s_frames.begin() + frameStart + oldFrameCount);
+                    s_frames.erase(frameStart + newFrameCount, oldFrameCount - newFrameCount);
+                adjustFrameIndex(i, (s32)newFrameCount - (s32)oldFrameCount);
             }
             s_actions[i].frameCount = newFrameCount;
             s_actions[i].duration = actualDuration;
@@ -702,49 +759,124 @@ void MacroData::setActionDuration(s32 startIndex, s32 endIndex, u32 durationMs)
         // V2: 直接修改每个动作对应的帧的持续时间（每个动作都是1帧）
         for (s32 i = startIndex; i <= endIndex; i++) {
             // 计算当前动作的帧起始位置
-            s32 frameStart = 0;
-            for (s32 j = 0; j < i; j++)
-                frameStart += s_actions[j].frameCount;
+            s32 frameStart = getFrameStart(i);
             
-            s_framesV2[frameStart].durationMs = durationMs;
+            s_framesV2.writable(frameStart, 1)->durationMs = durationMs;
             s_actions[i].duration = durationMs;
             s_actions[i].modified = true;
         }
     }
     
     updateDurationMs();
+    commitEdit();
 }
 
 // 修改动作的触发按钮
 void MacroData::setActionButtons(s32 actionIndex, u64 buttons) {
     if (actionIndex < 0 || actionIndex >= (s32)s_actions.size()) return;
-    saveSnapshot();
+    beginEdit(actionIndex, actionIndex + 1);
     
     // 更新动作的按键
     s_actions[actionIndex].buttons = buttons;
     s_actions[actionIndex].modified = true;
     
     // 计算帧起始位置
-    s32 frameStart = 0;
-    for (s32 i = 0; i < actionIndex; i++)
-        frameStart += s_actions[i].frameCount;
+    s32 frameStart = getFrameStart(actionIndex);
     
     // 更新帧的按键
     if (s_header.version == 1) {
         // V1: 修改该动作对应的所有帧
+        MacroFrame* frames = s_frames.writable(frameStart, s_actions[actionIndex].frameCount);
         for (u32 i = 0; i < s_actions[actionIndex].frameCount; i++)
-            s_frames[frameStart + i].keysHeld = buttons;
+            frames[i].keysHeld = buttons;
     } else {
         // V2: 直接修改那一帧
-        s_framesV2[frameStart].keysHeld = buttons;
+        s_framesV2.writable(frameStart, 1)->keysHeld = buttons;
     }
+    commitEdit();
+}
+
+// 记录占用的内存
+size_t MacroData::EditRecord::bytes() const {
+    return sizeof(EditRecord) + actions.size() * sizeof(Action) +
+           frames.size() * sizeof(MacroFrame) + framesV2.size() * sizeof(MacroFrameV2);
+}
+
+// 当前版本的帧总数
+u32 MacroData::frameTotal() {
+    return (s_header.version == 1) ? s_frames.size() : s_framesV2.size();
+}
+
+// 编辑前记录将被改动的区域
+void MacroData::beginEdit(s32 actionStart, s32 actionEnd) {
+    if (actionEnd > (s32)s_actions.size()) actionEnd = s_actions.size();
+    if (actionStart > actionEnd) actionStart = actionEnd;
+    EditRecord& rec = s_pendingEdit;
+    rec.actionStart = actionStart;
+    rec.actionLen = actionEnd - actionStart;
+    rec.frameStart = getFrameStart(actionStart);
+    rec.frameLen = getFrameStart(actionEnd) - rec.frameStart;
+    rec.actions.assign(s_actions.begin() + actionStart, s_actions.begin() + actionEnd);
+    rec.frames.clear();
+    rec.framesV2.clear();
+    if (s_header.version == 1) s_frames.copyOut(rec.frameStart, rec.frameLen, rec.frames);
+    else s_framesV2.copyOut(rec.frameStart, rec.frameLen, rec.framesV2);
+    s_pendingActionCount = s_actions.size();
+    s_pendingFrameCount = frameTotal();
+}
+
+// 编辑后记录入栈（区域长度按总数的变化换算成编辑后的长度）
+void MacroData::commitEdit() {
+    EditRecord& rec = s_pendingEdit;
+    rec.actionLen = rec.actionLen + s_actions.size() - s_pendingActionCount;
+    rec.frameLen = rec.frameLen + frameTotal() - s_pendingFrameCount;
+    
+    // 新的编辑使重做记录失效
+    for (const auto& r : s_redoStack) s_journalBytes -= r.bytes();
+    s_redoStack.clear();
+    
+    s_journalBytes += rec.bytes();
+    s_undoStack.push_back(std::move(rec));
+    rec = {};
+    s_editVersion++;
+    
+    // 超出内存上限时丢弃最早的记录（至少保留最近一次）
+    size_t drop = 0;
+    while (s_journalBytes > UNDO_BUDGET_BYTES && s_undoStack.size() - drop > 1) {
+        s_journalBytes -= s_undoStack[drop].bytes();
+        drop++;
+    }
+    if (drop) s_undoStack.erase(s_undoStack.begin(), s_undoStack.begin() + drop);
 }
 
-// 保存快照，用于撤销
-void MacroData::saveSnapshot() {
-    if (s_undoStack.size() >= 3) s_undoStack.erase(s_undoStack.begin());
-    s_undoStack.push_back({s_frames, s_framesV2, s_actions});
+// 当前区域与记录内容互换
+void MacroData::swapRegion(EditRecord& rec) {
+    std::vector<Action> curActions(s_actions.begin() + rec.actionStart, s_actions.begin() + rec.actionStart + rec.actionLen);
+    s_actions.erase(s_actions.begin() + rec.actionStart, s_actions.begin() + rec.actionStart + rec.actionLen);
+    s_actions.insert(s_actions.begin() + rec.actionStart, rec.actions.begin(), rec.actions.end());
+    rec.actionLen = rec.actions.size();
+    rec.actions.swap(curActions);
     
+    if (s_header.version == 1) {
+        std::vector<MacroFrame> curFrames;
+        s_frames.copyOut(rec.frameStart, rec.frameLen, curFrames);
+        s_frames.erase(rec.frameStart, rec.frameLen);
+        s_frames.insert(rec.frameStart, rec.frames.data(), rec.frames.size());
+        rec.frameLen = rec.frames.size();
+        rec.frames.swap(curFrames);
+    } else {
+        std::vector<MacroFrameV2> curFrames;
+        s_framesV2.copyOut(rec.frameStart, rec.frameLen, curFrames);
+        s_framesV2.erase(rec.frameStart, rec.frameLen);
+        s_framesV2.insert(rec.frameStart, rec.framesV2.data(), rec.framesV2.size());
+        rec.frameLen = rec.framesV2.size();
+        rec.framesV2.swap(curFrames);
+    }
+    
+    s_header.frameCount = frameTotal();
+    rebuildFrameIndex();
+    updateDurationMs();
+    s_editVersion++;
 }
 
 // 查询能否撤销
@@ -755,24 +887,40 @@ bool MacroData::canUndo() {
 // 撤销
 bool MacroData::undo() {
     if (s_undoStack.empty()) return false;
-    auto& snapshot = s_undoStack.back();
-    s_frames = snapshot.frames;
-    s_framesV2 = snapshot.framesV2;
-    s_actions = snapshot.actions;
-    s_header.frameCount = (s_header.version == 1) ? s_frames.size() : s_framesV2.size();
+    EditRecord rec = std::move(s_undoStack.back());
     s_undoStack.pop_back();
-    updateDurationMs();
+    s_journalBytes -= rec.bytes();
+    swapRegion(rec);
+    s_journalBytes += rec.bytes();
+    s_redoStack.push_back(std::move(rec));
+    return true;
+}
+
+// 查询能否重做
+bool MacroData::canRedo() {
+    return !s_redoStack.empty();
+}
+
+// 重做
+bool MacroData::redo() {
+    if (s_redoStack.empty()) return false;
+    EditRecord rec = std::move(s_redoStack.back());
+    s_redoStack.pop_back();
+    s_journalBytes -= rec.bytes();
+    swapRegion(rec);
+    s_journalBytes += rec.bytes();
+    s_undoStack.push_back(std::move(rec));
     return true;
 }
 
 // 清理内存
 void MacroData::allCleanup() {
     s_frames.clear();
-    s_frames.shrink_to_fit();
     s_framesV2.clear();
-    s_framesV2.shrink_to_fit();
     s_actions.clear();
     s_actions.shrink_to_fit();
+    s_frameIndex.clear();
+    s_frameIndex.shrink_to_fit();
     s_basicInfo = {};
     undoCleanup();
 }
@@ -781,4 +929,8 @@ void MacroData::allCleanup() {
 void MacroData::undoCleanup() {
     s_undoStack.clear();
     s_undoStack.shrink_to_fit();
+    s_redoStack.clear();
+    s_redoStack.shrink_to_fit();
+    s_pendingEdit = {};
+    s_journalBytes = 0;
 }
@@ -6,6 +6,7 @@
 #include "macro_view.hpp"
 #include "i18n.hpp"
 #include <ultra.hpp>
+#include <algorithm>
 
 
 namespace {
@@ -166,10 +167,19 @@ tsl::elm::Element* MacroEditGui::createUI() {
             offsetX += sepW;
             // 撤销修改
             tsl::Color undoColor = MacroData::canUndo() ? r->a(tsl::onTextColor) : tsl::style::color::ColorDescription;
+            auto [undoW, undoH] = r->getTextDimensions(" 撤销修改", false, 15);
             r->drawString(" 撤销修改", false, offsetX, 73, 15, undoColor);
+            offsetX += undoW;
+            // 分界线
+            r->drawString("", false, offsetX, 73, 15, tsl::style::color::ColorDescription);
+            offsetX += sepW;
+            // 重做修改
+            tsl::Color redoColor = MacroData::canRedo() ? r->a(tsl::onTextColor) : tsl::style::color::ColorDescription;
+            r->drawString(" 重做", false, offsetX, 73, 15, redoColor);
         }
-        const char* btnText = m_selectMode ? "  修改" : "  保存";
-        r->drawString(btnText, false, 270, 693, 23, r->a(tsl::style::color::ColorText));
+        const char* btnText = m_selectMode ? "  修改" : m_saveFailed ? "  保存失败" : "  保存";
+        tsl::Color btnColor = (!m_selectMode && m_saveFailed) ? tsl::Color(0xF, 0x5, 0x5, 0xF) : tsl::style::color::ColorText;
+        r->drawString(btnText, false, 270, 693, 23, r->a(btnColor));
     }));
     
     auto drawer = new tsl::elm::CustomDrawer([this](tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, s32 h) {
@@ -252,7 +262,10 @@ void MacroEditGui::drawActionList(tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, s3
     m_listHeight = listH;
     s32 bottomY = y + h - 73;
     
-    for (size_t i = 0; i < actions.size(); i++) {
+    // 只遍历可见范围内的动作
+    size_t firstVisible = std::max(0, m_scrollOffset / ITEM_HEIGHT);
+    size_t lastVisible = std::min(actions.size(), (size_t)((m_scrollOffset + bottomY - listY) / ITEM_HEIGHT + 1));
+    for (size_t i = firstVisible; i < lastVisible; i++) {
         s32 itemY = listY + i * ITEM_HEIGHT - m_scrollOffset;
         if (itemY >= listY && itemY < bottomY) {
             r->drawRect(x + 4, itemY + ITEM_HEIGHT - 1, w - 8, 1, r->a(tsl::separatorColor));
@@ -303,9 +316,32 @@ void MacroEditGui::drawActionList(tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, s3
     }
 }
 
+// 重建时间轴缓存（动作列表变化后）
+void MacroEditGui::updateTimelineCache() {
+    u32 version = MacroData::getEditVersion();
+    if (m_timelineValid && m_timelineVersion == version) return;
+    auto& actions = MacroData::getActions();
+    m_actionStartMs.resize(actions.size() + 1);
+    m_actionStartMs[0] = 0;
+    for (size_t i = 0; i < actions.size(); i++) m_actionStartMs[i + 1] = m_actionStartMs[i] + actions[i].duration;
+    m_timelineVersion = version;
+    m_timelineValid = true;
+}
+
+// 查找某一时刻所在的动作（二分查找）
+s32 MacroEditGui::findActionAtMs(u32 ms) const {
+    auto it = std::upper_bound(m_actionStartMs.begin(), m_actionStartMs.end(), ms);
+    s32 index = (s32)(it - m_actionStartMs.begin()) - 1;
+    return std::clamp(index, 0, (s32)m_actionStartMs.size() - 2);
+}
+
 void MacroEditGui::drawTimelineArea(tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, double progress) {
     auto& actions = MacroData::getActions();
-    float totalDuration = (float)MacroData::getBasicInfo().durationMs / 1000.0f;
+    if (actions.empty()) return;
+    updateTimelineCache();
+    u32 totalMs = m_actionStartMs.back();
+    if (totalMs == 0) return;
+    float totalDuration = (float)totalMs / 1000.0f;
     float pixelPerSec = (float)(w - 20) / totalDuration;
     s32 barH = 25, barY = y + 50, tickY = y + 27;
     
@@ -329,39 +365,59 @@ void MacroEditGui::drawTimelineArea(tsl::gfx::Renderer* r, s32 x, s32 y, s32 w,
         selStart = std::min(m_selectAnchor, m_selectedIndex);
         selEnd = std::max(m_selectAnchor, m_selectedIndex);
     }
-    
-    // 动作色块
-    float currentTime = 0;
-    s32 rangeStartX = -1, rangeEndX = -1;
-    for (size_t i = 0; i < actions.size(); i++) {
-        float dur = (float)actions[i].duration / 1000.0f;
-        s32 blockX = x + 10 + (s32)(currentTime * pixelPerSec);
-        s32 nextBlockX = x + 10 + (s32)((currentTime + dur) * pixelPerSec);
-        s32 blockW = std::max(1, nextBlockX - blockX);
-        bool inRange = ((s32)i >= selStart && (s32)i <= selEnd);
-        s32 drawY = inRange ? barY - 3 : barY;
-        s32 drawH = inRange ? barH + 6 : barH;
-        bool hasStick = (actions[i].stickL != StickDir::None || actions[i].stickR != StickDir::None);
-        bool hasButtons = (actions[i].buttons != 0);
-        tsl::Color blockColor = actions[i].modified ? tsl::Color(0xF, 0xA, 0xC, 0xF)              // 粉色：已修改
-                              : (hasButtons && !hasStick) ? tsl::Color(0x2, 0xA, 0x2, 0xF)       // 绿色：纯按键
-                              : actions[i].stickMergedVirtual ? tsl::Color(0xF, 0x5, 0x5, 0xF)   // 红色：虚拟合并摇杆
-                              : hasStick ? tsl::Color(0xF, 0xA, 0x3, 0xF)                        // 橙色：非虚拟合并摇杆（含按键+摇杆）
-                              : tsl::Color(0x8, 0x8, 0x8, 0xF);                                  // 灰色：无动作
-        r->drawRect(blockX, drawY, blockW, drawH, r->a(blockColor));
-        if ((s32)i == selStart) rangeStartX = blockX;
-        if ((s32)i == selEnd) rangeEndX = blockX + blockW;
-        currentTime += dur;
+    selStart = std::clamp(selStart, 0, (s32)actions.size() - 1);
+    selEnd = std::clamp(selEnd, selStart, (s32)actions.size() - 1);
+    
+    // 动作色块：按像素列绘制，颜色和高度相同的相邻列合并成一个矩形
+    // 一列覆盖多个动作时取其中优先级最高的类型（已修改 > 纯按键 > 摇杆 > 无动作），短动作不会被相邻的长动作盖住；
+    // 相邻列最多共用一个动作，每帧的绘制代价是时间轴宽度加动作数量
+    static const tsl::Color BLOCK_COLORS[] = {
+        tsl::Color(0xF, 0xA, 0xC, 0xF),     // 粉色：已修改
+        tsl::Color(0x2, 0xA, 0x2, 0xF),     // 绿色：纯按键
+        tsl::Color(0xF, 0x5, 0x5, 0xF),     // 红色：虚拟合并摇杆
+        tsl::Color(0xF, 0xA, 0x3, 0xF),     // 橙色：非虚拟合并摇杆（含按键+摇杆）
+        tsl::Color(0x8, 0x8, 0x8, 0xF),     // 灰色：无动作
+    };
+    // 类型编号越小优先级越高
+    auto blockKind = [](const Action& action) -> int {
+        bool hasStick = (action.stickL != StickDir::None || action.stickR != StickDir::None);
+        bool hasButtons = (action.buttons != 0);
+        return action.modified ? 0 : (hasButtons && !hasStick) ? 1 : action.stickMergedVirtual ? 2 : hasStick ? 3 : 4;
+    };
+    s32 barW = w - 20;
+    float msPerPixel = (float)totalMs / barW;
+    s32 runStart = 0, runKind = -1;
+    bool runInRange = false;
+    for (s32 col = 0; col <= barW; col++) {
+        s32 kind = -1;
+        bool inRange = false;
+        if (col < barW) {
+            u32 colStartMs = (u32)(col * msPerPixel);
+            u32 colEndMs = (u32)((col + 1) * msPerPixel);
+            s32 first = findActionAtMs(colStartMs);
+            s32 last = colEndMs > colStartMs ? findActionAtMs(colEndMs - 1) : first;
+            kind = blockKind(actions[first]);
+            for (s32 i = first + 1; i <= last; i++) kind = std::min(kind, blockKind(actions[i]));
+            inRange = (first <= selEnd && last >= selStart);
+        }
+        if (col > 0 && (kind != runKind || inRange != runInRange)) {
+            s32 drawY = runInRange ? barY - 3 : barY;
+            s32 drawH = runInRange ? barH + 6 : barH;
+            r->drawRect(x + 10 + runStart, drawY, col - runStart, drawH, r->a(BLOCK_COLORS[runKind]));
+            runStart = col;
+        }
+        runKind = kind;
+        runInRange = inRange;
     }
     
     // 选中框
-    if (rangeStartX >= 0 && rangeEndX >= 0) {
-        s32 boxX = rangeStartX - 2, boxW = rangeEndX - rangeStartX + 4, boxY = barY - 3, boxH = barH + 6;
-        r->drawRect(boxX, boxY, boxW, 2, r->a(timelineHighlight));
-        r->drawRect(boxX, boxY + boxH, boxW, 2, r->a(timelineHighlight));
-        r->drawRect(boxX, boxY, 2, boxH, r->a(timelineHighlight));
-        r->drawRect(rangeEndX, boxY, 2, boxH, r->a(timelineHighlight));
-    }
+    s32 rangeStartX = x + 10 + (s32)(m_actionStartMs[selStart] / msPerPixel);
+    s32 rangeEndX = std::max(rangeStartX + 1, x + 10 + (s32)(m_actionStartMs[selEnd + 1] / msPerPixel));
+    s32 boxX = rangeStartX - 2, boxW = rangeEndX - rangeStartX + 4, boxY = barY - 3, boxH = barH + 6;
+    r->drawRect(boxX, boxY, boxW, 2, r->a(timelineHighlight));
+    r->drawRect(boxX, boxY + boxH, boxW, 2, r->a(timelineHighlight));
+    r->drawRect(boxX, boxY, 2, boxH, r->a(timelineHighlight));
+    r->drawRect(rangeEndX, boxY, 2, boxH, r->a(timelineHighlight));
 }
 
 void MacroEditGui::drawMenuArea(tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, double progress) {
@@ -390,31 +446,16 @@ void MacroEditGui::drawMenuArea(tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, doub
 
 void MacroEditGui::drawDurationEditArea(tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, double progress) {
     tsl::Color highlightColor = calcBlinkColor(tsl::highlightColor1, tsl::highlightColor2, progress);
-    auto& actions = MacroData::getActions();
-    s32 currentActionMs = actions[m_menuSelStart].duration;
-    s32 totalMs = MacroData::getBasicInfo().durationMs;
-    s32 maxEditMs = 30000 - (totalMs - currentActionMs);
-    bool isOverLimit = m_editingDuration > maxEditMs;
     s32 digits[5] = { m_editingDuration/10000%10, m_editingDuration/1000%10, m_editingDuration/100%10, m_editingDuration/10%10, m_editingDuration%10 };
     s32 digitW = 30, gap = 8;
     s32 totalW = digitW * 5 + gap * 5 + 30;
     s32 startX = x + (w - totalW) / 2;
-    tsl::Color errorColor = tsl::Color(0xF, 0x2, 0x2, 0xF);
-    tsl::Color errorHighlight = calcBlinkColor(tsl::Color(0xF,0x4,0x4,0xF), tsl::Color(0x8,0x1,0x1,0xF), progress);
     for (int i = 0; i < 5; i++) {
         char buf[2] = {(char)('0' + digits[i]), '\0'};
-        tsl::Color color = isOverLimit ? ((i == m_editDigitIndex) ? errorHighlight : errorColor) 
-                                       : ((i == m_editDigitIndex) ? highlightColor : tsl::defaultTextColor);
+        tsl::Color color = (i == m_editDigitIndex) ? highlightColor : tsl::defaultTextColor;
         r->drawString(buf, false, startX + i * (digitW + gap), y + 60, 36, r->a(color));
     }
-    r->drawString("ms", false, startX + 5 * (digitW + gap), y + 60, 28, r->a(isOverLimit ? errorColor : tsl::defaultTextColor));
-    
-    if (isOverLimit) {
-        char maxBuf[32];
-        snprintf(maxBuf, sizeof(maxBuf), "Max: %dms", maxEditMs);
-        auto [maxW, maxH] = r->drawString(maxBuf, false, 0, 0, 14, tsl::Color(0,0,0,0));
-        r->drawString(maxBuf, false, x + w - 15 - maxW, y + 90, 14, r->a(errorColor));
-    }
+    r->drawString("ms", false, startX + 5 * (digitW + gap), y + 60, 28, r->a(tsl::defaultTextColor));
 }
 
 void MacroEditGui::drawButtonEditArea(tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, double progress) {
@@ -562,7 +603,6 @@ void MacroEditGui::enterStickEditMode() {
 }
 
 bool MacroEditGui::handleDurationEditInput(u64 keysDown) {
-    auto& actions = MacroData::getActions();
     if (keysDown & HidNpadButton_AnyLeft) {
         m_editDigitIndex = (m_editDigitIndex + 4) % 5;
         return true;
@@ -589,11 +629,8 @@ bool MacroEditGui::handleDurationEditInput(u64 keysDown) {
         m_editingDuration = m_editingDuration - ((m_editingDuration / divisor) % 10) * divisor + digit * divisor;
         return true;
     }
+    // 宏总时长不设上限（播放时按窗口分段读入帧数据），单个动作最长 29999ms
     if (keysDown & HidNpadButton_Plus) {
-        s32 currentActionMs = actions[m_menuSelStart].duration;
-        s32 totalMs = MacroData::getBasicInfo().durationMs;
-        s32 maxEditMs = 30000 - (totalMs - currentActionMs);
-        if (m_editingDuration > maxEditMs) return true;
         MacroData::setActionDuration(m_menuSelStart, m_menuSelEnd, m_editingDuration);
         m_durationEditMode = false;
         m_selectMode = false;
@@ -749,6 +786,14 @@ bool MacroEditGui::handleNormalInput(u64 keysDown, u64 keysHeld) {
             return true;
         }
     }
+    if (keysDown & HidNpadButton_Y) {
+        if (MacroData::redo()) {
+            if (m_selectedIndex >= (s32)actions.size()) m_selectedIndex = actions.size() - 1;
+            m_selectMode = false;
+            m_selectAnchor = -1;
+            return true;
+        }
+    }
     if (keysDown & HidNpadButton_StickL) {
         if (m_bakMacro && MacroData::loadBakMacroData()) {
             MacroData::undoCleanup();
@@ -762,8 +807,9 @@ bool MacroEditGui::handleNormalInput(u64 keysDown, u64 keysHeld) {
     }
     if (keysDown & HidNpadButton_Plus) {
         if (!m_selectMode) {
-            
-            MacroData::saveForEdit();
+            // 写入失败时原文件已恢复，留在编辑界面，编辑内容仍在内存中可以再次保存
+            m_saveFailed = !MacroData::saveForEdit();
+            if (m_saveFailed) return true;
             Refresh::RefrRequest(Refresh::MacroGameList); 
             g_ipcManager.sendReloadMacroCommand();
             tsl::swapTo<MacroViewGui>(SwapDepth(2), MacroData::getFilePath(), m_gameName, m_isRecord);
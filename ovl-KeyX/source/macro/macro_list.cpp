@@ -7,6 +7,7 @@
 #include "hiddata.hpp"
 #include "refresh.hpp"
 #include "macro_util.hpp"
+#include "name_resolver.hpp"
 
 namespace {
     bool s_isBack = false;  
@@ -27,6 +28,10 @@ MacroListGui::MacroListGui()
 
 }
 
+MacroListGui::~MacroListGui() {
+    NameResolver::stop(this);
+}
+
 tsl::elm::Element* MacroListGui::createUI() {
     auto frame = new tsl::elm::OverlayFrame("脚本列表", "管理录制的脚本");
     auto list = new tsl::elm::List();
@@ -53,8 +58,16 @@ tsl::elm::Element* MacroListGui::createUI() {
     }
 
     list->addItem(new tsl::elm::CategoryHeader(" 选择要查看的游戏"));
-    for (auto& entry : m_macroDirs) {
-        auto item = new tsl::elm::ListItem("", std::to_string(entry.macroCount));
+    std::vector<std::pair<u32, u64>> unresolved;
+    for (size_t i = 0; i < m_macroDirs.size(); i++) {
+        auto& entry = m_macroDirs[i];
+        // 名称缓存中有的直接显示，其余（以及还没核对版本的）交给后台线程读取
+        char nameBuf[64]{};
+        u64 titleId = strtoull(entry.dirName.c_str(), nullptr, 16);
+        bool verified = false;
+        bool cached = GameMonitor::getCachedGameName(titleId, nameBuf, &verified);
+        if (!cached || !verified) unresolved.push_back({(u32)i, titleId});
+        auto item = new tsl::elm::ListItem(cached ? nameBuf : "", std::to_string(entry.macroCount));
         entry.item = item;
         item->setClickListener([this, entry](u64 keys) {
             if (keys & HidNpadButton_A) {
@@ -66,6 +79,7 @@ tsl::elm::Element* MacroListGui::createUI() {
         });
         list->addItem(item);
     }
+    NameResolver::start(this, std::move(unresolved));
 
     frame->setContent(list);
     return frame;
@@ -83,17 +97,14 @@ void MacroListGui::update() {
         }
     }
 
-    if (m_nextIndex >= m_macroDirs.size()) return;
-    auto& entry = m_macroDirs[m_nextIndex];
-    if (!entry.item) {
-        m_nextIndex = m_nextIndex + 1;
-        return;
+    // 取出后台线程已解析的名称
+    NameResolver::Result result;
+    while (NameResolver::poll(this, result)) {
+        auto& entry = m_macroDirs[result.index];
+        if (!entry.item) continue;
+        if (result.found) entry.item->setText(result.name);
+        else entry.item->setText(entry.dirName);
     }
-    u64 tid = strtoull(entry.dirName.c_str(), nullptr, 16);
-    char nameBuf[64]{};
-    if (GameMonitor::getTitleIdGameName(tid, nameBuf)) entry.item->setText(nameBuf);
-    else entry.item->setText(entry.dirName);
-    m_nextIndex = m_nextIndex + 1;
 }
 
 
@@ -135,8 +146,7 @@ tsl::elm::Element* MacroListGuiGame::createUI() {
 
     list->addItem(new tsl::elm::CategoryHeader(" 选择要查看的脚本"));
     for (const auto& entry : m_macro) {
-        std::string displayName = MacroUtil::getDisplayName(entry.path);
-        auto item = new tsl::elm::ListItem(displayName, HidHelper::getCombinedIcons(entry.hotkey));
+        auto item = new tsl::elm::ListItem(entry.name, HidHelper::getCombinedIcons(entry.hotkey));
         item->setClickListener([this, entry](u64 keys) {
             if (keys & HidNpadButton_A) {
                 tsl::changeTo<MacroViewGui>(entry.path.c_str(), m_gameName);
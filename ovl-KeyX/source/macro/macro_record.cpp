@@ -23,7 +23,7 @@ namespace {
 
 // 录制用的 Frame
 RecordingFrame::RecordingFrame() 
- : m_RecordingTimeText("REC  00:00")
+ : m_RecordingTimeText("REC  00:00"), m_MaxLateText("")
 {
 }
 
@@ -31,6 +31,10 @@ void RecordingFrame::setRecordingTime(u64 elapsed_s) {
     snprintf(m_RecordingTimeText, sizeof(m_RecordingTimeText), "REC  %02lu:%02lu", elapsed_s / 60, elapsed_s % 60);
 }
 
+void RecordingFrame::setMaxLate(u32 lateUs) {
+    snprintf(m_MaxLateText, sizeof(m_MaxLateText), "误差 %u.%ums", lateUs / 1000, (lateUs % 1000) / 100);
+}
+
 void RecordingFrame::draw(tsl::gfx::Renderer* renderer) {
     // 绘制全透明背景
     renderer->fillScreen(tsl::Color(0x0, 0x0, 0x0, 0x0));
@@ -56,6 +60,12 @@ void RecordingFrame::draw(tsl::gfx::Renderer* renderer) {
         tsl::Color(0xF, 0x5, 0x5, 0xF)      // 亮红色 - 特殊颜色（用于"REC"，和圆球同色）
     );
     renderer->drawCircle(circleX, circleY, circleRadius, true, tsl::Color(0xF, 0x5, 0x5, 0xF));
+    // 右下角显示采样最大延迟（录制的时间误差）
+    if (m_MaxLateText[0] != '\0') {
+        auto lateFontSize = 18;
+        auto lateDim = renderer->getTextDimensions(m_MaxLateText, false, lateFontSize);
+        renderer->drawString(m_MaxLateText, false, FrameX + FrameWidthSize - lateDim.first - 15, FrameY + FrameHightSize - 12, lateFontSize, tsl::Color(0xA, 0xA, 0xA, 0xF));
+    }
 }
 
 void RecordingFrame::layout(u16 parentX, u16 parentY, u16 parentWidth, u16 parentHeight) {
@@ -107,11 +117,12 @@ void RecordingGui::update() {
     if (elapsed_ms >= m_lastUpdatedSeconds + 1000) {
         m_lastUpdatedSeconds = elapsed_ms;
         m_frame->setRecordingTime(elapsed_ms / 1000);
+        m_frame->setMaxLate(MacroSampler::GetMaxLateUs());
     }
     
-    // 超时检测
-    if (elapsed_ms > 30000) {
-        g_recordMessage = "录制超时";
+    // 临时文件写入失败，录制已不完整
+    if (MacroSampler::HasError()) {
+        g_recordMessage = "录制写入失败";
         MacroSampler::Cancel();
         exitRecording();
     }
@@ -1,14 +1,29 @@
 #include "macro_sampler.hpp"
+#include "ini_helper.hpp"
+#include "macro_util.hpp"
 #include <ultra.hpp>
 #include <time.h>
+#include <unistd.h>
 
 namespace {
-    constexpr u64 SAMPLE_INTERVAL_NS = 8333333ULL;  // ~120Hz (8.33ms)
+    constexpr const char* CONFIG_PATH = "/config/KeyX/config.ini";
+    constexpr const char* MACROS_DIR = "sdmc:/config/KeyX/macros";
+    constexpr const char* TEMP_PATH = "sdmc:/config/KeyX/macros/.recording.tmp";   // 录制中的临时文件
+    constexpr int DEFAULT_SAMPLE_RATE = 120;         // 默认采样率（Hz）
+    constexpr int MIN_SAMPLE_RATE = 30;
+    constexpr int MAX_SAMPLE_RATE = 1000;            // 最高1kHz（相同帧会合并，高采样率只增加变化时刻的精度）
     constexpr u64 WAIT_INTERVAL_NS = 1000000ULL;     // 等待时 1ms 检查一次
+    constexpr u64 WRITE_INTERVAL_NS = 20000000ULL;   // 写入线程每 20ms 写一次
     constexpr u64 STICK_PSEUDO_MASK = 0xFF0000ULL;   // 摇杆伪按键掩码
     
+    // 微秒时间戳四舍五入到毫秒
+    u64 roundUsToMs(u64 us) {
+        return (us + 500) / 1000;
+    }
+    
     // 比较两帧是否相同
-    bool isSameFrame(const MacroFrameV2& a, const MacroFrameV2& b) {
+    template<typename Frame>
+    bool isSameFrame(const Frame& a, const Frame& b) {
         return a.keysHeld == b.keysHeld &&
                a.leftX == b.leftX && a.leftY == b.leftY &&
                a.rightX == b.rightX && a.rightY == b.rightY;
@@ -19,21 +34,57 @@ namespace {
 // 静态成员定义
 Thread MacroSampler::s_thread;
 bool MacroSampler::s_threadCreated = false;
+Thread MacroSampler::s_writerThread;
+bool MacroSampler::s_writerCreated = false;
 std::atomic<bool> MacroSampler::s_shouldExit{false};
 std::atomic<bool> MacroSampler::s_sampling{false};
-std::vector<MacroFrameV2> MacroSampler::s_frames;
+std::atomic<bool> MacroSampler::s_writerExit{false};
+std::atomic<bool> MacroSampler::s_error{false};
+MacroFrameV2 MacroSampler::s_ring[MacroSampler::RING_SIZE];
+std::atomic<u32> MacroSampler::s_ringHead{0};
+std::atomic<u32> MacroSampler::s_ringTail{0};
+FILE* MacroSampler::s_tempFile = nullptr;
+u32 MacroSampler::s_writtenFrames = 0;
+MacroSampler::SampledFrame MacroSampler::s_pending = {};
+bool MacroSampler::s_hasPending = false;
 char MacroSampler::s_filePath[128] = {};
 u32 MacroSampler::s_totalSamples = 0;
 u64 MacroSampler::s_startTick = 0;
-u32 MacroSampler::s_lastFrameMs = 0;
+u64 MacroSampler::s_lastSampleUs = 0;
+u64 MacroSampler::s_intervalTicks = 0;
+u64 MacroSampler::s_maxLateUs = 0;
 PadState MacroSampler::s_padP1 = {};
 PadState MacroSampler::s_padHandheld = {};
 
-// 采样一帧
-void MacroSampler::SampleOneFrame() {
-    // 计算时间
-    u32 elapsedMs = armTicksToNs(armGetSystemTick() - s_startTick) / 1000000;
-    u32 frameDuration = elapsedMs - s_lastFrameMs;
+// 从配置读取采样间隔（[MACRO] sampleRate，单位Hz）
+u64 MacroSampler::LoadSampleInterval() {
+    int rate = IniHelper::open(CONFIG_PATH).getInt("MACRO", "sampleRate", DEFAULT_SAMPLE_RATE);
+    if (rate < MIN_SAMPLE_RATE) rate = MIN_SAMPLE_RATE;
+    if (rate > MAX_SAMPLE_RATE) rate = MAX_SAMPLE_RATE;
+    return armGetSystemTickFreq() / rate;
+}
+
+// 结束一帧并放入环形缓冲（时长按两端的毫秒边界相减，舍入误差不会累积）
+void MacroSampler::PushFrame(const SampledFrame& frame, u64 endUs) {
+    u32 head = s_ringHead.load(std::memory_order_relaxed);
+    if (head - s_ringTail.load(std::memory_order_acquire) >= RING_SIZE) {
+        s_error = true;     // 写入跟不上，录制已不完整
+        return;
+    }
+    MacroFrameV2& out = s_ring[head & RING_MASK];
+    out.durationMs = roundUsToMs(endUs) - roundUsToMs(frame.startUs);
+    out.keysHeld = frame.keysHeld;
+    out.leftX = frame.leftX;
+    out.leftY = frame.leftY;
+    out.rightX = frame.rightX;
+    out.rightY = frame.rightY;
+    s_ringHead.store(head + 1, std::memory_order_release);
+}
+
+// 采样一帧（now 为本次采样的时刻）
+void MacroSampler::SampleOneFrame(u64 now) {
+    // 计算时间（微秒）
+    u64 elapsedUs = armTicksToNs(now - s_startTick) / 1000;
     
     // 读取 HID 输入（同时读取 pro 和 Handheld，合并输入）
     padUpdate(&s_padP1);
@@ -49,44 +100,106 @@ void MacroSampler::SampleOneFrame() {
     HidAnalogStickState leftStick = handheldHasStick ? leftStick_h : padGetStickPos(&s_padP1, 0);
     HidAnalogStickState rightStick = handheldHasStick ? rightStick_h : padGetStickPos(&s_padP1, 1);
     
-    MacroFrameV2 frame;
-    frame.durationMs = frameDuration;
+    SampledFrame frame;
+    frame.startUs = s_hasPending ? elapsedUs : 0;   // 第一帧从录制开始算起
     frame.keysHeld = keysHeld & ~STICK_PSEUDO_MASK;
     frame.leftX = leftStick.x;
     frame.leftY = leftStick.y;
     frame.rightX = rightStick.x;
     frame.rightY = rightStick.y;
     
-    // 合并相同帧或添加新帧
+    // 与当前帧相同则延续，否则当前帧结束，新开一帧
     s_totalSamples++;
-    if (!s_frames.empty() && isSameFrame(s_frames.back(), frame)) s_frames.back().durationMs += frameDuration;
-    else s_frames.push_back(frame);
-    s_lastFrameMs = elapsedMs;
+    if (!s_hasPending) {
+        s_pending = frame;
+        s_hasPending = true;
+    }
+    else if (!isSameFrame(s_pending, frame)) {
+        PushFrame(s_pending, elapsedUs);
+        s_pending = frame;
+    }
+    s_lastSampleUs = elapsedUs;
 }
 
-// 线程函数
+// 采样线程函数
+// 按绝对时间点采样：下一次采样时刻 = 上一次预定时刻 + 间隔，采样本身的耗时不会累积成漂移
 void MacroSampler::ThreadFunc(void* arg) {
+    u64 deadline = 0;
     while (!s_shouldExit) {
-        if (s_sampling) {
-            SampleOneFrame();
-            svcSleepThread(SAMPLE_INTERVAL_NS);
-        } else {
+        if (!s_sampling) {
             svcSleepThread(WAIT_INTERVAL_NS);
+            deadline = 0;
+            continue;
         }
+        u64 now = armGetSystemTick();
+        if (deadline == 0) deadline = now;
+        else if (now > deadline) {
+            u64 lateUs = armTicksToNs(now - deadline) / 1000;
+            if (lateUs > s_maxLateUs) s_maxLateUs = lateUs;
+        }
+        SampleOneFrame(now);
+        deadline += s_intervalTicks;
+        now = armGetSystemTick();
+        // 落后超过一个间隔时不补采，直接从当前时刻重新对齐
+        if (now >= deadline) deadline = now;
+        else svcSleepThread(armTicksToNs(deadline - now));
+    }
+    // 最后一帧持续到最后一次采样
+    if (s_hasPending) {
+        PushFrame(s_pending, s_lastSampleUs);
+        s_hasPending = false;
+    }
+}
+
+// 把环形缓冲中的帧写入临时文件（环形缓冲中连续的一段一次写入）
+void MacroSampler::DrainRing() {
+    u32 tail = s_ringTail.load(std::memory_order_relaxed);
+    u32 head = s_ringHead.load(std::memory_order_acquire);
+    while (tail != head) {
+        u32 index = tail & RING_MASK;
+        u32 count = std::min(head - tail, RING_SIZE - index);
+        if (s_tempFile && !s_error) {
+            if (fwrite(&s_ring[index], sizeof(MacroFrameV2), count, s_tempFile) != count) s_error = true;
+            else s_writtenFrames += count;
+        }
+        tail += count;
+        s_ringTail.store(tail, std::memory_order_release);
+    }
+}
+
+// 写入线程函数（退出前把剩余的帧全部写入）
+void MacroSampler::WriterFunc(void* arg) {
+    while (true) {
+        bool exiting = s_writerExit;
+        DrainRing();
+        if (exiting) break;
+        svcSleepThread(WRITE_INTERVAL_NS);
     }
 }
 
 // 准备（倒计时开始时调用）
 void MacroSampler::Prepare() {
-    // 清理旧数据并预分配（避免多次扩容导致内存碎片化）
-    s_frames.clear();
-    s_frames.reserve(1024);  // 预分配 ~32KB
+    // 清理旧数据
     s_filePath[0] = '\0';
     s_totalSamples = 0;
     s_startTick = 0;
-    s_lastFrameMs = 0;
+    s_lastSampleUs = 0;
+    s_maxLateUs = 0;
+    s_intervalTicks = LoadSampleInterval();
+    s_hasPending = false;
+    s_ringHead = 0;
+    s_ringTail = 0;
+    s_writtenFrames = 0;
+    s_error = false;
     s_sampling = false;
     s_shouldExit = false;
+    s_writerExit = false;
+    
+    // 创建临时文件，先写入占位文件头（保存时回写）
+    ult::createDirectory(MACROS_DIR);
+    s_tempFile = fopen(TEMP_PATH, "w+b");
+    MacroHeader header = {};
+    if (!s_tempFile || fwrite(&header, sizeof(header), 1, s_tempFile) != 1) s_error = true;
     
     // 初始化 pad（同时支持 pro 和 Handheld）
     padInitialize(&s_padP1, HidNpadIdType_No1);
@@ -94,13 +207,22 @@ void MacroSampler::Prepare() {
     padUpdate(&s_padP1);
     padUpdate(&s_padHandheld);
     
-    // 创建线程
+    // 创建采样线程
     memset(&s_thread, 0, sizeof(Thread));
     Result rc = threadCreate(&s_thread, ThreadFunc, nullptr, nullptr, 4 * 1024, 44, -2);
     if (R_SUCCEEDED(rc)) {
         s_threadCreated = true;
         threadStart(&s_thread);
     }
+    
+    // 创建写入线程（优先级低于采样线程）
+    memset(&s_writerThread, 0, sizeof(Thread));
+    rc = threadCreate(&s_writerThread, WriterFunc, nullptr, nullptr, 8 * 1024, 49, -2);
+    if (R_SUCCEEDED(rc)) {
+        s_writerCreated = true;
+        threadStart(&s_writerThread);
+    }
+    else s_error = true;
 }
 
 // 开始采样（倒计时结束时调用）
@@ -109,7 +231,7 @@ void MacroSampler::Start() {
     s_sampling = true;
 }
 
-// 停止采样
+// 停止采样（先等采样线程结束最后一帧，再等写入线程写完剩余帧）
 void MacroSampler::Stop() {
     s_sampling = false;
     s_shouldExit = true;
@@ -118,39 +240,75 @@ void MacroSampler::Stop() {
         threadClose(&s_thread);
         s_threadCreated = false;
     }
+    s_writerExit = true;
+    if (s_writerCreated) {
+        threadWaitForExit(&s_writerThread);
+        threadClose(&s_writerThread);
+        s_writerCreated = false;
+    }
+}
+
+// 关闭并删除临时文件
+void MacroSampler::DiscardTempFile() {
+    if (s_tempFile) {
+        fclose(s_tempFile);
+        s_tempFile = nullptr;
+    }
+    remove(TEMP_PATH);
 }
 
 // 取消录制
 void MacroSampler::Cancel() {
     Stop();
-    s_frames.clear();
-    s_frames.shrink_to_fit();
+    DiscardTempFile();
+}
+
+// 从临时文件读回一帧
+bool MacroSampler::ReadFrameAt(u32 index, MacroFrameV2& out) {
+    if (fseek(s_tempFile, sizeof(MacroHeader) + (long)index * sizeof(MacroFrameV2), SEEK_SET) != 0) return false;
+    return fread(&out, sizeof(out), 1, s_tempFile) == 1;
 }
 
 // 保存到文件
+// 帧数据已在录制过程中写入临时文件，这里只移除末尾帧、回写文件头，再重命名为正式文件
 bool MacroSampler::Save(u64 titleId, u64 comboMask) {
-    if (s_frames.empty()) return false;
+    if (!s_tempFile || s_error) {
+        DiscardTempFile();
+        return false;
+    }
+    u32 frameCount = s_writtenFrames;
+    MacroFrameV2 f;
     // 移除末尾快捷键帧
-    while (!s_frames.empty() && (s_frames.back().keysHeld & comboMask)) s_frames.pop_back();
+    while (frameCount > 0 && ReadFrameAt(frameCount - 1, f) && (f.keysHeld & comboMask)) frameCount--;
     // 移除末尾无动作帧
-    while (!s_frames.empty()) {
-        auto& f = s_frames.back();
-        if (f.keysHeld == 0 && f.leftX == 0 && f.leftY == 0 && f.rightX == 0 && f.rightY == 0) s_frames.pop_back();
-        else break;
+    while (frameCount > 0 && ReadFrameAt(frameCount - 1, f) &&
+           f.keysHeld == 0 && f.leftX == 0 && f.leftY == 0 && f.rightX == 0 && f.rightY == 0) frameCount--;
+    if (frameCount == 0) {
+        DiscardTempFile();
+        return false;
     }
-    if (s_frames.empty()) return false;
     
-    // 构造文件头
+    // 回写文件头，截掉移除的帧
+    u64 lastMs = roundUsToMs(s_lastSampleUs);
     MacroHeader header;
     memcpy(header.magic, "KEYX", 4);
     header.version = 2;
-    header.frameRate = s_lastFrameMs ? (s_totalSamples * 1000 / s_lastFrameMs) : 0;
+    header.frameRate = lastMs ? (s_totalSamples * 1000 / lastMs) : 0;
     header.titleId = titleId;
-    header.frameCount = s_frames.size();
+    header.frameCount = frameCount;
+    bool ok = fseek(s_tempFile, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, s_tempFile) == 1;
+    ok = ok && fflush(s_tempFile) == 0;
+    ok = ok && ftruncate(fileno(s_tempFile), sizeof(MacroHeader) + (off_t)frameCount * sizeof(MacroFrameV2)) == 0;
+    ok = (fclose(s_tempFile) == 0) && ok;
+    s_tempFile = nullptr;
+    if (!ok) {
+        remove(TEMP_PATH);
+        return false;
+    }
     
     // 生成目录
     char dirPath[64];
-    sprintf(dirPath, "sdmc:/config/KeyX/macros/%016lX", titleId);
+    sprintf(dirPath, "%s/%016lX", MACROS_DIR, titleId);
     ult::createDirectory(dirPath);
     
     // 生成文件名
@@ -163,14 +321,13 @@ bool MacroSampler::Save(u64 titleId, u64 comboMask) {
         sprintf(s_filePath, "%s/%02d%02d_%02d_%02d_%02d_%d.macro", dirPath, tmNow.tm_mon + 1, tmNow.tm_mday, tmNow.tm_hour, tmNow.tm_min, tmNow.tm_sec, suffix++);
     }
     
-    // 写入文件
-    FILE* fp = fopen(s_filePath, "wb");
-    if (!fp) return false;
-    fwrite(&header, sizeof(header), 1, fp);
-    fwrite(s_frames.data(), sizeof(MacroFrameV2), s_frames.size(), fp);
-    fclose(fp);
-    s_frames.clear(); 
-    s_frames.shrink_to_fit();
+    // 重命名为正式文件（同一文件系统内重命名，不会出现写了一半的宏文件）
+    if (rename(TEMP_PATH, s_filePath) != 0) {
+        remove(TEMP_PATH);
+        s_filePath[0] = '\0';
+        return false;
+    }
+    MacroUtil::updateIndexEntry(s_filePath);
     return true;
 }
 
@@ -178,3 +335,13 @@ bool MacroSampler::Save(u64 titleId, u64 comboMask) {
 const char* MacroSampler::GetFilePath() {
     return s_filePath;
 }
+
+// 获取采样最大延迟
+u32 MacroSampler::GetMaxLateUs() {
+    return (u32)s_maxLateUs;
+}
+
+// 录制是否出错
+bool MacroSampler::HasError() {
+    return s_error;
+}
@@ -2,14 +2,72 @@
 #include "ini_helper.hpp"
 #include <ultra.hpp>
 #include <algorithm>
+#include <cstring>
 #include <strings.h>
-#include <unordered_set>
+#include <sys/stat.h>
+#include "macro_data.hpp"
 
 namespace {
     constexpr const char* MACROS_DIR = "sdmc:/config/KeyX/macros";
     constexpr const char* GAME_CFG_DIR = "sdmc:/config/KeyX/GameConfig";
+    constexpr const char* INDEX_FILE = "macroIndex.bin";
+    constexpr u16 INDEX_VERSION = 2;
+    constexpr const char* BINDING_SUFFIX = "_macros.bin";
+    constexpr u16 BINDING_VERSION = 1;
+
+    // 索引文件头（后跟 count 个 MacroIndexEntry）
+    struct IndexHeader {
+        char magic[4];      // "KXIX"
+        u16 version;        // 索引格式版本
+        u16 entrySize;      // 条目大小（结构变化时自动重建）
+        u32 count;          // 条目数量
+        s64 dirMtime;       // 上次与目录核对时宏目录的修改时间
+    } __attribute__((packed));
+
+    // 快捷键绑定表文件头（后跟 count 个 MacroBinding）
+    struct BindingHeader {
+        char magic[4];      // "KXMB"
+        u16 version;        // 绑定表格式版本
+        u16 count;          // 绑定数量
+    } __attribute__((packed));
+
+    // 宏路径的 FNV-1a 哈希
+    u32 hashPath(const char* path) {
+        u32 hash = 2166136261u;
+        for (; *path; path++) hash = (hash ^ static_cast<u8>(*path)) * 16777619u;
+        return hash;
+    }
+
+    // 宏文件路径 → 绑定表中保存的路径（宏目录下的文件只保存相对路径）
+    const char* toBindingPath(const char* macroPath) {
+        const char* path = strncmp(macroPath, "sdmc:", 5) == 0 ? macroPath + 5 : macroPath;
+        const char* dir = MACROS_DIR + 5;
+        size_t len = strlen(dir);
+        if (strncmp(path, dir, len) == 0 && path[len] == '/') return path + len + 1;
+        return macroPath;
+    }
+
+    // 复制字符串到定长缓冲（不截断在 UTF-8 多字节字符中间）
+    void copyName(char* dst, size_t size, const std::string& src) {
+        size_t len = std::min(src.size(), size - 1);
+        while (len > 0 && len < src.size() && (static_cast<u8>(src[len]) & 0xC0) == 0x80) len--;
+        memcpy(dst, src.data(), len);
+        dst[len] = '\0';
+    }
+
+    // 按文件名查找索引条目
+    std::vector<MacroUtil::MacroIndexEntry>::iterator findEntry(std::vector<MacroUtil::MacroIndexEntry>& entries, const std::string& fileName) {
+        return std::find_if(entries.begin(), entries.end(), [&](const MacroUtil::MacroIndexEntry& e) {
+            return fileName == e.fileName;
+        });
+    }
 }
 
+std::recursive_mutex MacroUtil::s_mutex;
+u64 MacroUtil::s_bindTitleId = 0;
+std::vector<MacroUtil::MacroBinding> MacroUtil::s_bindings;
+std::vector<u16> MacroUtil::s_bindByPath;
+
 void MacroUtil::getGameCfgPath(u64 titleId, char* outPath, size_t size) {
     snprintf(outPath, size, "%s/%016lX.ini", GAME_CFG_DIR, titleId);
 }
@@ -18,154 +76,109 @@ void MacroUtil::getMacroDirPath(u64 titleId, char* outPath, size_t size) {
     snprintf(outPath, size, "%s/%016lX", MACROS_DIR, titleId);
 }
 
+void MacroUtil::getBindingPath(u64 titleId, char* outPath, size_t size) {
+    snprintf(outPath, size, "%s/%016lX%s", GAME_CFG_DIR, titleId, BINDING_SUFFIX);
+}
+
+void MacroUtil::getIndexPath(u64 titleId, char* outPath, size_t size) {
+    snprintf(outPath, size, "%s/%016lX/%s", MACROS_DIR, titleId, INDEX_FILE);
+}
+
+s64 MacroUtil::getDirMtime(u64 titleId) {
+    char dirPath[64];
+    getMacroDirPath(titleId, dirPath, sizeof(dirPath));
+    struct stat st{};
+    if (stat(dirPath, &st) != 0) return -1;
+    return st.st_mtime;
+}
+
 std::vector<MacroUtil::GameDirEntry> MacroUtil::getGameDirs() {
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
     std::vector<GameDirEntry> result;
     auto dirs = ult::getSubdirectories(MACROS_DIR);
     for (const auto& dir : dirs) {
-        char pattern[128];
-        snprintf(pattern, sizeof(pattern), "%s/%s/*.macro", MACROS_DIR, dir.c_str());
-        auto files = ult::getFilesListByWildcards(pattern);
-        if (!files.empty()) result.push_back({dir, (int)files.size()});
+        u64 titleId = strtoull(dir.c_str(), nullptr, 16);
+        if (titleId == 0) continue;
+        // 目录修改时间与索引记录的一致时直接使用索引，否则才列目录核对
+        s64 dirMtime = -1;
+        size_t count = loadIndex(titleId, &dirMtime).size();
+        if (dirMtime != getDirMtime(titleId)) count = syncIndex(titleId).size();
+        if (count > 0) result.push_back({dir, (int)count});
     }
     return result;
 }
 
 std::vector<MacroUtil::MacroEntry> MacroUtil::getMacroList(u64 titleId) {
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
     std::vector<MacroEntry> result;
+    std::vector<MacroIndexEntry> entries = syncIndex(titleId);
     
-    // 获取所有宏文件
-    char pattern[128];
-    snprintf(pattern, sizeof(pattern), "%s/%016lX/*.macro", MACROS_DIR, titleId);
-    std::vector<std::string> allFiles = ult::getFilesListByWildcards(pattern);
-    
-    // 按名称排序
-    std::sort(allFiles.begin(), allFiles.end(), [](const std::string& a, const std::string& b) {
-        return strcasecmp(a.c_str(), b.c_str()) < 0;
+    // 按名称排序，有快捷键的在前，无快捷键的在后
+    std::sort(entries.begin(), entries.end(), [](const MacroIndexEntry& a, const MacroIndexEntry& b) {
+        return strcasecmp(a.fileName, b.fileName) < 0;
     });
-    
-    // 读取快捷键配置
-    char cfgPath[96];
-    getGameCfgPath(titleId, cfgPath, sizeof(cfgPath));
-    
-    std::vector<MacroEntry> boundMacros;
-    int macroCount = IniHelper::getInt("MACRO", "macroCount", 0, cfgPath);
-    for (int idx = 1; idx <= macroCount; ++idx) {
-        std::string pathKey = "macro_path_" + std::to_string(idx);
-        std::string comboKey = "macro_combo_" + std::to_string(idx);
-        std::string macroPath = IniHelper::getString("MACRO", pathKey, "", cfgPath);
-        if (macroPath.empty()) continue;
-        u64 hotkey = static_cast<u64>(IniHelper::getInt("MACRO", comboKey, 0, cfgPath));
-        if (hotkey == 0) continue;
-        boundMacros.push_back({macroPath, hotkey});
-    }
-    
-    // 按名称排序
-    std::sort(boundMacros.begin(), boundMacros.end(), [](const MacroEntry& a, const MacroEntry& b) {
-        std::string nameA = ult::getFileName(a.path);
-        std::string nameB = ult::getFileName(b.path);
-        return strcasecmp(nameA.c_str(), nameB.c_str()) < 0;
+    std::stable_partition(entries.begin(), entries.end(), [](const MacroIndexEntry& e) {
+        return e.hotkey != 0;
     });
     
-    // 合并：有快捷键的在前，无快捷键的在后
-    std::unordered_set<std::string> boundPaths;
-    for (const auto& entry : boundMacros) {
-        boundPaths.insert(entry.path);
-        result.push_back(entry);
+    char dirPath[64];
+    getMacroDirPath(titleId, dirPath, sizeof(dirPath));
+    result.reserve(entries.size());
+    for (const auto& entry : entries) {
+        result.push_back({std::string(dirPath) + "/" + entry.fileName, entry.name, entry.hotkey});
     }
-    for (const auto& path : allFiles) {
-        if (boundPaths.count(path)) continue;
-        result.push_back({path, 0});
-    }
-    
     return result;
 }
 
 u64 MacroUtil::getHotkey(u64 titleId, const char* macroPath) {
-    char cfgPath[96];
-    getGameCfgPath(titleId, cfgPath, sizeof(cfgPath));
-    
-    int macroCount = IniHelper::getInt("MACRO", "macroCount", 0, cfgPath);
-    for (int idx = 1; idx <= macroCount; ++idx) {
-        std::string pathKey = "macro_path_" + std::to_string(idx);
-        std::string stored = IniHelper::getString("MACRO", pathKey, "", cfgPath);
-        if (stored == macroPath) {
-            std::string comboKey = "macro_combo_" + std::to_string(idx);
-            return static_cast<u64>(IniHelper::getInt("MACRO", comboKey, 0, cfgPath));
-        }
-    }
-    return 0;
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
+    loadBindings(titleId);
+    int idx = findBinding(macroPath);
+    return idx >= 0 ? s_bindings[idx].combo : 0;
 }
 
-void MacroUtil::setHotkey(u64 titleId, const char* macroPath, u64 hotkey) {
-    char cfgPath[96];
-    getGameCfgPath(titleId, cfgPath, sizeof(cfgPath));
-    
-    // 先删除已有的（如果存在）
-    removeHotkey(titleId, macroPath);
-    
-    // 添加新条目
-    int macroCount = IniHelper::getInt("MACRO", "macroCount", 0, cfgPath) + 1;
-    IniHelper::setInt("MACRO", "macroCount", macroCount, cfgPath);
-    
-    std::string pathKey = "macro_path_" + std::to_string(macroCount);
-    std::string comboKey = "macro_combo_" + std::to_string(macroCount);
-    IniHelper::setString("MACRO", pathKey, macroPath, cfgPath);
-    IniHelper::setInt("MACRO", comboKey, static_cast<int>(hotkey), cfgPath);
+bool MacroUtil::setHotkey(u64 titleId, const char* macroPath, u64 hotkey) {
+    MacroBinding binding{};
+    const char* bindPath = toBindingPath(macroPath);
+    if (strlen(bindPath) >= sizeof(binding.path)) return false;
+    strcpy(binding.path, bindPath);
+    binding.pathHash = hashPath(binding.path);
+    binding.combo = hotkey;
+
+    // 先删除已有的（如果存在），新绑定追加到末尾；超出系统模块能读入的数量时拒绝新增
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
+    loadBindings(titleId);
+    int idx = findBinding(macroPath);
+    if (idx < 0 && s_bindings.size() >= MAX_BINDINGS) return false;
+    if (idx >= 0) s_bindings.erase(s_bindings.begin() + idx);
+    s_bindings.push_back(binding);
+    sortBindings();
+    saveBindings();
+    setIndexHotkey(titleId, macroPath, hotkey);
+    return true;
 }
 
 bool MacroUtil::removeHotkey(u64 titleId, const char* macroPath) {
-    char cfgPath[96];
-    getGameCfgPath(titleId, cfgPath, sizeof(cfgPath));
-    
-    int macroCount = IniHelper::getInt("MACRO", "macroCount", 0, cfgPath);
-    int foundIdx = -1;
-    
-    // 查找要删除的条目
-    for (int idx = 1; idx <= macroCount; ++idx) {
-        std::string pathKey = "macro_path_" + std::to_string(idx);
-        std::string stored = IniHelper::getString("MACRO", pathKey, "", cfgPath);
-        if (stored == macroPath) {
-            foundIdx = idx;
-            break;
-        }
-    }
-    
-    if (foundIdx < 0) return false;
-    
-    // 将后面的条目前移
-    for (int idx = foundIdx; idx < macroCount; ++idx) {
-        std::string srcPath = "macro_path_" + std::to_string(idx + 1);
-        std::string srcCombo = "macro_combo_" + std::to_string(idx + 1);
-        std::string dstPath = "macro_path_" + std::to_string(idx);
-        std::string dstCombo = "macro_combo_" + std::to_string(idx);
-        
-        std::string path = IniHelper::getString("MACRO", srcPath, "", cfgPath);
-        int combo = IniHelper::getInt("MACRO", srcCombo, 0, cfgPath);
-        IniHelper::setString("MACRO", dstPath, path, cfgPath);
-        IniHelper::setInt("MACRO", dstCombo, combo, cfgPath);
-    }
-    
-    // 删除最后一个条目并更新计数
-    std::string lastPath = "macro_path_" + std::to_string(macroCount);
-    std::string lastCombo = "macro_combo_" + std::to_string(macroCount);
-    IniHelper::removeKey("MACRO", lastPath, cfgPath);
-    IniHelper::removeKey("MACRO", lastCombo, cfgPath);
-    IniHelper::setInt("MACRO", "macroCount", macroCount - 1, cfgPath);
-    
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
+    loadBindings(titleId);
+    int idx = findBinding(macroPath);
+    if (idx < 0) return false;
+    s_bindings.erase(s_bindings.begin() + idx);
+    sortBindings();
+    saveBindings();
+    setIndexHotkey(titleId, macroPath, 0);
     return true;
 }
 
 std::vector<u64> MacroUtil::getUsedHotkeys(u64 titleId) {
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
+    loadBindings(titleId);
     std::vector<u64> result;
-    char cfgPath[96];
-    getGameCfgPath(titleId, cfgPath, sizeof(cfgPath));
-    
-    int macroCount = IniHelper::getInt("MACRO", "macroCount", 0, cfgPath);
-    for (int idx = 1; idx <= macroCount; ++idx) {
-        std::string comboKey = "macro_combo_" + std::to_string(idx);
-        u64 hotkey = static_cast<u64>(IniHelper::getInt("MACRO", comboKey, 0, cfgPath));
-        if (hotkey != 0) result.push_back(hotkey);
+    result.reserve(s_bindings.size());
+    for (const auto& binding : s_bindings) {
+        if (binding.combo != 0) result.push_back(binding.combo);
     }
+    std::sort(result.begin(), result.end());
     return result;
 }
 
@@ -180,19 +193,16 @@ u64 MacroUtil::getTitleIdFromPath(const char* macroPath) {
 }
 
 bool MacroUtil::updateMacroPath(u64 titleId, const char* oldPath, const char* newPath) {
-    char cfgPath[96];
-    getGameCfgPath(titleId, cfgPath, sizeof(cfgPath));
-    
-    int macroCount = IniHelper::getInt("MACRO", "macroCount", 0, cfgPath);
-    for (int idx = 1; idx <= macroCount; ++idx) {
-        std::string pathKey = "macro_path_" + std::to_string(idx);
-        std::string stored = IniHelper::getString("MACRO", pathKey, "", cfgPath);
-        if (stored == oldPath) {
-            IniHelper::setString("MACRO", pathKey, newPath, cfgPath);
-            return true;
-        }
-    }
-    return false;
+    const char* bindPath = toBindingPath(newPath);
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
+    loadBindings(titleId);
+    int idx = findBinding(oldPath);
+    if (idx < 0 || strlen(bindPath) >= sizeof(s_bindings[idx].path)) return false;
+    strcpy(s_bindings[idx].path, bindPath);
+    s_bindings[idx].pathHash = hashPath(bindPath);
+    sortBindings();
+    saveBindings();
+    return true;
 }
 
 std::string MacroUtil::getDisplayName(const std::string& macroPath) {
@@ -203,7 +213,7 @@ std::string MacroUtil::getDisplayName(const std::string& macroPath) {
     snprintf(tidStr, sizeof(tidStr), "%016lX", tid);
     std::string iniPath = std::string(MACROS_DIR) + "/" + tidStr + "/macroMetadata.ini";
     
-    std::string name = IniHelper::getString(fileName, "name", "", iniPath);
+    std::string name = IniHelper::open(iniPath).getString(fileName, "name", "");
     
     if (name.empty()) {
         auto dot = fileName.rfind('.');
@@ -222,15 +232,17 @@ MacroUtil::MacroMetadata MacroUtil::getMetadata(const std::string& macroPath) {
     snprintf(tidStr, sizeof(tidStr), "%016lX", tid);
     std::string iniPath = std::string(MACROS_DIR) + "/" + tidStr + "/macroMetadata.ini";
     
+    IniHelper::IniFile& ini = IniHelper::open(iniPath);
     MacroMetadata meta;
-    meta.name = IniHelper::getString(fileName, "name", "", iniPath);
-    meta.author = IniHelper::getString(fileName, "author", "", iniPath);
-    meta.desc = IniHelper::getString(fileName, "desc", "", iniPath);
+    meta.name = ini.getString(fileName, "name", "");
+    meta.author = ini.getString(fileName, "author", "");
+    meta.desc = ini.getString(fileName, "desc", "");
     
     return meta;
 }
 
 bool MacroUtil::deleteMacro(u64 titleId, const char* macroPath) {
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
     // 删除宏文件与备份文件
     ult::deleteFileOrDirectory(macroPath);
     std::string backupPath = std::string(macroPath) + ".bak";
@@ -244,12 +256,24 @@ bool MacroUtil::deleteMacro(u64 titleId, const char* macroPath) {
     snprintf(tidStr, sizeof(tidStr), "%016lX", titleId);
     std::string iniPath = std::string(MACROS_DIR) + "/" + tidStr + "/macroMetadata.ini";
     std::string fileName = ult::getFileName(macroPath);
-    IniHelper::removeSection(fileName, iniPath);
+    IniHelper::IniFile& ini = IniHelper::open(iniPath);
+    ini.removeSection(fileName);
+    ini.flush();
+    
+    // 删除索引条目
+    s64 dirMtime = -1;
+    std::vector<MacroIndexEntry> entries = loadIndex(titleId, &dirMtime);
+    auto it = findEntry(entries, fileName);
+    if (it != entries.end()) {
+        entries.erase(it);
+        saveIndex(titleId, entries, dirMtime);
+    }
     
     return hadHotkey;
 }
 
 bool MacroUtil::renameMacro(const char* oldPath, const char* newPath) {
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
     // 重命名文件
     rename(oldPath, newPath);
     // 重命名备份文件
@@ -270,16 +294,384 @@ bool MacroUtil::renameMacro(const char* oldPath, const char* newPath) {
     std::string oldFileName = ult::getFileName(oldPath);
     std::string newFileName = ult::getFileName(newPath);
     
-    std::string name = IniHelper::getString(oldFileName, "name", "", iniPath);
-    std::string author = IniHelper::getString(oldFileName, "author", "", iniPath);
-    std::string desc = IniHelper::getString(oldFileName, "desc", "", iniPath);
+    IniHelper::IniFile& ini = IniHelper::open(iniPath);
+    std::string name = ini.getString(oldFileName, "name", "");
+    std::string author = ini.getString(oldFileName, "author", "");
+    std::string desc = ini.getString(oldFileName, "desc", "");
     
     if (!name.empty() || !author.empty() || !desc.empty()) {
-        if (!name.empty()) IniHelper::setString(newFileName, "name", name, iniPath);
-        if (!author.empty()) IniHelper::setString(newFileName, "author", author, iniPath);
-        if (!desc.empty()) IniHelper::setString(newFileName, "desc", desc, iniPath);
-        IniHelper::removeSection(oldFileName, iniPath);
+        if (!name.empty()) ini.setString(newFileName, "name", name);
+        if (!author.empty()) ini.setString(newFileName, "author", author);
+        if (!desc.empty()) ini.setString(newFileName, "desc", desc);
+        ini.removeSection(oldFileName);
+        ini.flush();
+    }
+    
+    // 更新索引条目的文件名和显示名称（文件内容不变，无需重新读取）
+    s64 dirMtime = -1;
+    std::vector<MacroIndexEntry> entries = loadIndex(titleId, &dirMtime);
+    auto it = findEntry(entries, oldFileName);
+    if (it != entries.end()) {
+        copyName(it->fileName, sizeof(it->fileName), newFileName);
+        copyName(it->name, sizeof(it->name), getDisplayName(newPath));
+        saveIndex(titleId, entries, dirMtime);
+    } else {
+        updateIndexEntry(newPath);
     }
     
     return hadHotkey;
 }
+
+bool MacroUtil::getIndexEntry(const char* macroPath, MacroIndexEntry& out) {
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
+    u64 titleId = getTitleIdFromPath(macroPath);
+    s64 dirMtime = -1;
+    std::vector<MacroIndexEntry> entries = loadIndex(titleId, &dirMtime);
+    auto it = findEntry(entries, ult::getFileName(macroPath));
+    
+    struct stat st{};
+    if (stat(macroPath, &st) != 0) {
+        // 文件已不存在，移除失效条目
+        if (it != entries.end()) {
+            entries.erase(it);
+            saveIndex(titleId, entries, dirMtime);
+        }
+        return false;
+    }
+    if (it != entries.end() && it->fileSize == (u32)st.st_size && it->mtime == (s64)st.st_mtime) {
+        out = *it;
+        return true;
+    }
+    
+    // 索引中没有或已过期，从宏文件刷新
+    if (!readIndexEntry(macroPath, out)) return false;
+    if (it != entries.end()) {
+        out.hotkey = it->hotkey;
+        *it = out;
+    } else {
+        out.hotkey = getHotkey(titleId, macroPath);
+        entries.push_back(out);
+    }
+    saveIndex(titleId, entries, dirMtime);
+    return true;
+}
+
+void MacroUtil::updateIndexEntry(const char* macroPath) {
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
+    MacroIndexEntry entry;
+    if (!readIndexEntry(macroPath, entry)) return;
+    putIndexEntry(macroPath, entry);
+}
+
+void MacroUtil::updateIndexEntry(const char* macroPath, u16 version, u32 frameCount, u32 durationMs) {
+    std::lock_guard<std::recursive_mutex> lock(s_mutex);
+    MacroIndexEntry entry;
+    if (!fillIndexFileInfo(macroPath, entry)) return;
+    entry.version = version;
+    entry.frameCount = frameCount;
+    entry.durationMs = durationMs;
+    putIndexEntry(macroPath, entry);
+}
+
+void MacroUtil::putIndexEntry(const char* macroPath, const MacroIndexEntry& entry) {
+    u64 titleId = getTitleIdFromPath(macroPath);
+    s64 dirMtime = -1;
+    std::vector<MacroIndexEntry> entries = loadIndex(titleId, &dirMtime);
+    auto it = findEntry(entries, entry.fileName);
+    if (it != entries.end()) {
+        u64 hotkey = it->hotkey;    // 快捷键只由 setHotkey/removeHotkey 修改
+        *it = entry;
+        it->hotkey = hotkey;
+    } else {
+        entries.push_back(entry);
+        entries.back().hotkey = getHotkey(titleId, macroPath);
+    }
+    saveIndex(titleId, entries, dirMtime);
+}
+
+void MacroUtil::setIndexHotkey(u64 titleId, const char* macroPath, u64 hotkey) {
+    s64 dirMtime = -1;
+    std::vector<MacroIndexEntry> entries = loadIndex(titleId, &dirMtime);
+    auto it = findEntry(entries, ult::getFileName(macroPath));
+    if (it == entries.end() || it->hotkey == hotkey) return;
+    it->hotkey = hotkey;
+    saveIndex(titleId, entries, dirMtime);
+}
+
+std::vector<MacroUtil::MacroIndexEntry> MacroUtil::loadIndex(u64 titleId, s64* dirMtime) {
+    char indexPath[96];
+    getIndexPath(titleId, indexPath, sizeof(indexPath));
+    FILE* fp = fopen(indexPath, "rb");
+    if (!fp) return rebuildIndex(titleId, dirMtime);
+    
+    // 一次读取整个索引，文件头不匹配或长度不足视为损坏
+    std::vector<MacroIndexEntry> entries;
+    IndexHeader header;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+              memcmp(header.magic, "KXIX", 4) == 0 &&
+              header.version == INDEX_VERSION &&
+              header.entrySize == sizeof(MacroIndexEntry);
+    if (ok) {
+        entries.resize(header.count);
+        ok = fread(entries.data(), sizeof(MacroIndexEntry), header.count, fp) == header.count;
+    }
+    fclose(fp);
+    if (!ok) return rebuildIndex(titleId, dirMtime);
+    if (dirMtime) *dirMtime = header.dirMtime;
+    return entries;
+}
+
+bool MacroUtil::saveIndex(u64 titleId, const std::vector<MacroIndexEntry>& entries, s64 dirMtime) {
+    char indexPath[96];
+    getIndexPath(titleId, indexPath, sizeof(indexPath));
+    // 索引文件在宏目录内，首次创建会改变目录修改时间
+    struct stat st{};
+    bool existed = stat(indexPath, &st) == 0;
+    FILE* fp = fopen(indexPath, "wb");
+    if (!fp) return false;
+    IndexHeader header;
+    memcpy(header.magic, "KXIX", 4);
+    header.version = INDEX_VERSION;
+    header.entrySize = sizeof(MacroIndexEntry);
+    header.count = entries.size();
+    header.dirMtime = dirMtime;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(entries.data(), sizeof(MacroIndexEntry), entries.size(), fp) == entries.size();
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) remove(indexPath);     // 写了一半的索引下次读取时会重建
+    // 新建索引引起的目录时间变化是自己造成的，改记为创建后的时间，免得下次白白核对一遍
+    if (ok && !existed && dirMtime >= 0) {
+        header.dirMtime = getDirMtime(titleId);
+        fp = fopen(indexPath, "r+b");
+        if (fp) {
+            fwrite(&header, sizeof(header), 1, fp);
+            fclose(fp);
+        }
+    }
+    return ok;
+}
+
+std::vector<MacroUtil::MacroIndexEntry> MacroUtil::rebuildIndex(u64 titleId, s64* dirMtime) {
+    std::vector<MacroIndexEntry> entries;
+    // 先取目录修改时间再列目录，列目录期间的变化下次还会核对
+    s64 mtime = getDirMtime(titleId);
+    if (dirMtime) *dirMtime = mtime;
+    char pattern[128];
+    snprintf(pattern, sizeof(pattern), "%s/%016lX/*.macro", MACROS_DIR, titleId);
+    std::vector<std::string> files = ult::getFilesListByWildcards(pattern);
+    if (files.empty()) {
+        // 目录为空或不存在时不生成索引文件
+        char indexPath[96];
+        getIndexPath(titleId, indexPath, sizeof(indexPath));
+        remove(indexPath);
+        return entries;
+    }
+    
+    // 快捷键从绑定表中查找
+    loadBindings(titleId);
+    
+    entries.reserve(files.size());
+    for (const auto& path : files) {
+        MacroIndexEntry entry;
+        if (!readIndexEntry(path.c_str(), entry)) continue;
+        int idx = findBinding(path.c_str());
+        entry.hotkey = idx >= 0 ? s_bindings[idx].combo : 0;
+        entries.push_back(entry);
+    }
+    saveIndex(titleId, entries, mtime);
+    return entries;
+}
+
+std::vector<MacroUtil::MacroIndexEntry> MacroUtil::syncIndex(u64 titleId) {
+    s64 oldMtime = -1;
+    std::vector<MacroIndexEntry> entries = loadIndex(titleId, &oldMtime);
+    s64 mtime = getDirMtime(titleId);
+    char pattern[128];
+    snprintf(pattern, sizeof(pattern), "%s/%016lX/*.macro", MACROS_DIR, titleId);
+    std::vector<std::string> files = ult::getFilesListByWildcards(pattern);
+    std::vector<std::string> names;
+    names.reserve(files.size());
+    for (const auto& path : files) names.push_back(ult::getFileName(path));
+    std::sort(names.begin(), names.end());
+    
+    // 去掉目录中已不存在的宏
+    size_t oldCount = entries.size();
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const MacroIndexEntry& e) {
+        return !std::binary_search(names.begin(), names.end(), std::string(e.fileName));
+    }), entries.end());
+    bool changed = entries.size() != oldCount;
+    
+    // 补上索引中没有的宏（只读取新增的文件）
+    if (entries.size() < names.size()) {
+        std::vector<std::string> indexed;
+        indexed.reserve(entries.size());
+        for (const auto& e : entries) indexed.push_back(e.fileName);
+        std::sort(indexed.begin(), indexed.end());
+        char dirPath[64];
+        getMacroDirPath(titleId, dirPath, sizeof(dirPath));
+        loadBindings(titleId);
+        for (const auto& name : names) {
+            if (std::binary_search(indexed.begin(), indexed.end(), name)) continue;
+            std::string path = std::string(dirPath) + "/" + name;
+            MacroIndexEntry entry;
+            if (!readIndexEntry(path.c_str(), entry)) continue;
+            int idx = findBinding(path.c_str());
+            entry.hotkey = idx >= 0 ? s_bindings[idx].combo : 0;
+            entries.push_back(entry);
+            changed = true;
+        }
+    }
+    // 内容没有变化时也要记下新的目录修改时间，下次不再核对
+    if (entries.empty() && changed) {
+        char indexPath[96];
+        getIndexPath(titleId, indexPath, sizeof(indexPath));
+        remove(indexPath);
+    }
+    else if (changed || mtime != oldMtime) saveIndex(titleId, entries, mtime);
+    return entries;
+}
+
+bool MacroUtil::fillIndexFileInfo(const char* macroPath, MacroIndexEntry& out) {
+    out = {};
+    struct stat st{};
+    if (stat(macroPath, &st) != 0) return false;
+    out.fileSize = st.st_size;
+    out.mtime = st.st_mtime;
+    copyName(out.fileName, sizeof(out.fileName), ult::getFileName(macroPath));
+    copyName(out.name, sizeof(out.name), getDisplayName(macroPath));
+    return true;
+}
+
+bool MacroUtil::readIndexEntry(const char* macroPath, MacroIndexEntry& out) {
+    if (!fillIndexFileInfo(macroPath, out)) return false;
+    FILE* fp = fopen(macroPath, "rb");
+    if (!fp) return false;
+    MacroHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1) {
+        fclose(fp);
+        return false;
+    }
+    out.version = header.version;
+    out.frameCount = header.frameCount;
+    if (header.version == 1) {
+        out.durationMs = header.frameRate ? (header.frameCount * 1000 / header.frameRate) : 0;
+    } else {
+        // V2 时长是各帧时长之和，分块读取避免一次分配整个文件
+        std::vector<MacroFrameV2> chunk(256);
+        u32 remaining = header.frameCount;
+        while (remaining > 0) {
+            size_t n = fread(chunk.data(), sizeof(MacroFrameV2), std::min<u32>(remaining, chunk.size()), fp);
+            if (n == 0) break;
+            for (size_t i = 0; i < n; i++) out.durationMs += chunk[i].durationMs;
+            remaining -= n;
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+void MacroUtil::loadBindings(u64 titleId) {
+    if (s_bindTitleId == titleId) return;
+    s_bindTitleId = titleId;
+    s_bindings.clear();
+    
+    char bindPath[96];
+    getBindingPath(titleId, bindPath, sizeof(bindPath));
+    bool ok = false;
+    FILE* fp = fopen(bindPath, "rb");
+    if (fp) {
+        BindingHeader header;
+        if (fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, "KXMB", 4) == 0 &&
+            header.version == BINDING_VERSION) {
+            s_bindings.resize(header.count);
+            ok = fread(s_bindings.data(), sizeof(MacroBinding), header.count, fp) == header.count;
+            for (auto& binding : s_bindings) binding.path[sizeof(binding.path) - 1] = '\0';
+        }
+        fclose(fp);
+    }
+    // 没有绑定表（或已损坏）时从游戏配置迁移，系统模块同样会忽略损坏的绑定表
+    if (!ok) {
+        s_bindings.clear();
+        migrateBindings(titleId);
+    }
+    sortBindings();
+}
+
+bool MacroUtil::saveBindings() {
+    char bindPath[96], tempPath[104];
+    getBindingPath(s_bindTitleId, bindPath, sizeof(bindPath));
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", bindPath);
+    FILE* fp = fopen(tempPath, "wb");
+    if (!fp) {
+        ult::createDirectory(GAME_CFG_DIR);
+        fp = fopen(tempPath, "wb");
+        if (!fp) return false;
+    }
+    BindingHeader header;
+    memcpy(header.magic, "KXMB", 4);
+    header.version = BINDING_VERSION;
+    header.count = s_bindings.size();
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(s_bindings.data(), sizeof(MacroBinding), s_bindings.size(), fp) == s_bindings.size();
+    ok = (fclose(fp) == 0) && ok;
+    // 写完整后再替换，系统模块不会读到写了一半的绑定表
+    if (ok) {
+        remove(bindPath);
+        ok = (rename(tempPath, bindPath) == 0);
+    }
+    if (!ok) remove(tempPath);
+    return ok;
+}
+
+bool MacroUtil::migrateBindings(u64 titleId) {
+    char cfgPath[96];
+    getGameCfgPath(titleId, cfgPath, sizeof(cfgPath));
+    IniHelper::IniFile& cfg = IniHelper::open(cfgPath);
+    int macroCount = cfg.getInt("MACRO", "macroCount", 0);
+    if (macroCount <= 0) return false;
+    
+    for (int idx = 1; idx <= macroCount && s_bindings.size() < MAX_BINDINGS; ++idx) {
+        std::string macroPath = cfg.getString("MACRO", "macro_path_" + std::to_string(idx), "");
+        u64 combo = strtoull(cfg.getString("MACRO", "macro_combo_" + std::to_string(idx), "0").c_str(), nullptr, 10);
+        const char* bindPath = toBindingPath(macroPath.c_str());
+        MacroBinding binding{};
+        if (combo == 0 || macroPath.empty() || strlen(bindPath) >= sizeof(binding.path)) continue;
+        strcpy(binding.path, bindPath);
+        binding.pathHash = hashPath(binding.path);
+        binding.combo = combo;
+        s_bindings.push_back(binding);
+    }
+    if (!saveBindings()) return false;
+    
+    // 绑定表写入成功后再删除旧的键（有绑定表时系统模块不再读取这些键）
+    for (int idx = 1; idx <= macroCount; ++idx) {
+        cfg.removeKey("MACRO", "macro_path_" + std::to_string(idx));
+        cfg.removeKey("MACRO", "macro_combo_" + std::to_string(idx));
+    }
+    cfg.removeKey("MACRO", "macroCount");
+    cfg.flush();
+    return true;
+}
+
+void MacroUtil::sortBindings() {
+    s_bindByPath.resize(s_bindings.size());
+    for (size_t i = 0; i < s_bindings.size(); i++) s_bindByPath[i] = i;
+    std::sort(s_bindByPath.begin(), s_bindByPath.end(), [](u16 a, u16 b) {
+        const MacroBinding& x = s_bindings[a];
+        const MacroBinding& y = s_bindings[b];
+        if (x.pathHash != y.pathHash) return x.pathHash < y.pathHash;
+        return strcmp(x.path, y.path) < 0;
+    });
+}
+
+int MacroUtil::findBinding(const char* macroPath) {
+    const char* bindPath = toBindingPath(macroPath);
+    u32 hash = hashPath(bindPath);
+    auto it = std::lower_bound(s_bindByPath.begin(), s_bindByPath.end(), hash, [](u16 idx, u32 value) {
+        return s_bindings[idx].pathHash < value;
+    });
+    for (; it != s_bindByPath.end() && s_bindings[*it].pathHash == hash; ++it) {
+        if (strcmp(s_bindings[*it].path, bindPath) == 0) return *it;
+    }
+    return -1;
+}
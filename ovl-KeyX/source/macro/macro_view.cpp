@@ -43,8 +43,16 @@ MacroViewGui::MacroViewGui(const char* macroFilePath, const char* gameName, bool
     strcpy(m_macroFilePath, macroFilePath);
     strncpy(m_gameName, gameName, sizeof(m_gameName) - 1);
     m_gameName[sizeof(m_gameName) - 1] = '\0';
-    MacroData::load(macroFilePath);
-    getHotkey();
+    // 基础信息从宏索引读取，帧数据在进入编辑界面时才加载
+    MacroData::setFilePath(macroFilePath);
+    m_titleId = MacroUtil::getTitleIdFromPath(macroFilePath);
+    if (MacroUtil::getIndexEntry(macroFilePath, m_info)) {
+        m_Hotkey = m_info.hotkey;
+    } else {
+        m_info = {};
+        strncpy(m_info.name, ult::getFileName(macroFilePath).c_str(), sizeof(m_info.name) - 1);
+        getHotkey();
+    }
 }
 
 MacroViewGui::~MacroViewGui()
@@ -54,8 +62,7 @@ MacroViewGui::~MacroViewGui()
 }
 
 void MacroViewGui::getHotkey() {
-    u64 titleId = MacroData::getBasicInfo().titleId;
-    m_Hotkey = MacroUtil::getHotkey(titleId, m_macroFilePath);
+    m_Hotkey = MacroUtil::getHotkey(m_titleId, m_macroFilePath);
 }
 
 
@@ -68,10 +75,10 @@ tsl::elm::Element* MacroViewGui::createUI() {
     }));
     auto list = new tsl::elm::List();
     auto textArea = new tsl::elm::CustomDrawer([this](tsl::gfx::Renderer* r, s32 x, s32 y, s32 w, s32 h) {
-        const auto& info = MacroData::getBasicInfo();
-        char titleId[17], fileName[64], params[64];
-        snprintf(titleId, sizeof(titleId), "%016lX", info.titleId);
-        snprintf(fileName, sizeof(fileName), "%s", info.fileName);
+        const auto& info = m_info;
+        char titleId[17], fileName[96], params[64];
+        snprintf(titleId, sizeof(titleId), "%016lX", m_titleId);
+        snprintf(fileName, sizeof(fileName), "%s", info.name);
         snprintf(params, sizeof(params), "%uF  %uS  %u KB", 
             info.frameCount, info.durationMs / 1000, (info.fileSize + 1023) / 1024);
         
@@ -171,8 +178,7 @@ bool MacroViewGui::handleInput(u64 keysDown, u64 keysHeld, const HidTouchState &
         return true;
     }
     if (keysDown & HidNpadButton_Minus) {
-        u64 titleId = MacroData::getBasicInfo().titleId;
-        if (MacroUtil::deleteMacro(titleId, m_macroFilePath)) g_ipcManager.sendReloadMacroCommand();
+        if (MacroUtil::deleteMacro(m_titleId, m_macroFilePath)) g_ipcManager.sendReloadMacroCommand();
         Refresh::RefrRequest(Refresh::MacroGameList);
         Refresh::RefrRequest(Refresh::MacroList);
         
@@ -295,7 +301,7 @@ void MacroHotKeySettingGui::update() {
 bool MacroHotKeySettingGui::isHotkeyValid() const {
     if (m_selectedButtons == 0) return false;
     if (m_selectedButtons == tsl::cfg::launchCombo) return false;
-    for (u64 used : m_usedHotkeys) if (used == m_selectedButtons) return false;
+    if (std::binary_search(m_usedHotkeys.begin(), m_usedHotkeys.end(), m_selectedButtons)) return false;
     // 检查选中按键数量（最多3个）
     int count = 0;
     for (u64 btn : buttons) if (m_selectedButtons & btn) count++;
@@ -355,7 +361,12 @@ bool MacroHotKeySettingGui::handleInput(u64 keysDown, u64 keysHeld, const HidTou
     if ((keysDown & HidNpadButton_Plus) && m_HotKeySave) {
         if (getFocusedElement() == m_HotKeySave) {
             if (!isHotkeyValid()) return true;
-            MacroUtil::setHotkey(m_titleId, m_macroFilePath, m_selectedButtons);
+            if (!MacroUtil::setHotkey(m_titleId, m_macroFilePath, m_selectedButtons)) {
+                // 该游戏的快捷键数量已达系统模块上限
+                m_HotKeySave->setValue("快捷键数量已达上限");
+                m_HotKeySave->setValueColor(tsl::Color(0xF, 0x5, 0x5, 0xF));
+                return true;
+            }
             g_ipcManager.sendReloadMacroCommand();
             Refresh::RefrSetMultiple(Refresh::MacroGameList | Refresh::MacroView);
             tsl::goBack();
@@ -216,8 +216,9 @@ UploadResult StoreData::uploadMacro(const std::string& filePath, u64 titleId, co
 
 void StoreData::saveMacroMetadataInfo(const std::string& gameId, const StoreMacroEntry& macro) {
     std::string iniPath = std::string(MACROS_DIR) + gameId + "/macroMetadata.ini";
-    IniHelper::setString(macro.file, "name", macro.name, iniPath);
-    IniHelper::setString(macro.file, "author", macro.author, iniPath);
+    IniHelper::IniFile& ini = IniHelper::open(iniPath);
+    ini.setString(macro.file, "name", macro.name);
+    ini.setString(macro.file, "author", macro.author);
     // 转义换行符，防止 INI 格式被破坏
     std::string escapedDesc = macro.desc;
     size_t pos = 0;
@@ -225,5 +226,6 @@ void StoreData::saveMacroMetadataInfo(const std::string& gameId, const StoreMacr
         escapedDesc.replace(pos, 1, "\\n");
         pos += 2;
     }
-    IniHelper::setString(macro.file, "desc", escapedDesc, iniPath);
+    ini.setString(macro.file, "desc", escapedDesc);
+    ini.flush();
 }
@@ -9,6 +9,8 @@
 #include "info_edit.hpp"
 #include "language.hpp"
 #include "qrcodegen.hpp"
+#include "macro_util.hpp"
+#include "name_resolver.hpp"
 
 
 using qrcodegen::QrCode;
@@ -286,6 +288,7 @@ StoreGameListGui::StoreGameListGui() {
 
 StoreGameListGui::~StoreGameListGui() {
     Thd::stop();
+    NameResolver::stop(this);
 }
 
 tsl::elm::Element* StoreGameListGui::createUI() {
@@ -294,10 +297,16 @@ tsl::elm::Element* StoreGameListGui::createUI() {
     auto list = new tsl::elm::List();
     list->addItem(new tsl::elm::CategoryHeader(" 选择对应游戏"));
     
+    std::vector<std::pair<u32, u64>> unresolved;
     for (size_t i = 0; i < s_gameList.games.size(); i++) {
         char tidStr[17];
         snprintf(tidStr, sizeof(tidStr), "%016lX", s_gameList.games[i].id);
-        auto item = new tsl::elm::ListItem(tidStr, std::to_string(s_gameList.games[i].count));
+        // 名称缓存中有的直接显示，其余（以及还没核对版本的）交给后台线程读取
+        char nameBuf[64]{};
+        bool verified = false;
+        bool cached = GameMonitor::getCachedGameName(s_gameList.games[i].id, nameBuf, &verified);
+        if (!cached || !verified) unresolved.push_back({(u32)i, s_gameList.games[i].id});
+        auto item = new tsl::elm::ListItem(cached ? nameBuf : tidStr, std::to_string(s_gameList.games[i].count));
         item->setClickListener([this, i](u64 keys) {
             if (keys & HidNpadButton_A) {
                 if (m_loadingIndex >= 0) return false;
@@ -316,22 +325,18 @@ tsl::elm::Element* StoreGameListGui::createUI() {
         m_entries[i].item = item;
         list->addItem(item);
     }
+    NameResolver::start(this, std::move(unresolved));
     
     frame->setContent(list);
     return frame;
 }
 
 void StoreGameListGui::update() {
-    // 更新游戏名
-    if (m_nextIndex < m_entries.size()) {
-        auto& entry = m_entries[m_nextIndex];
-        if (entry.item) {
-            char nameBuf[64]{};
-            if (GameMonitor::getTitleIdGameName(entry.tid, nameBuf)) {
-                entry.item->setText(nameBuf);
-            }
-        }
-        m_nextIndex++;
+    // 取出后台线程已解析的游戏名
+    NameResolver::Result result;
+    while (NameResolver::poll(this, result)) {
+        auto& entry = m_entries[result.index];
+        if (entry.item && result.found) entry.item->setText(result.name);
     }
     
     // 加载动画和结果处理
@@ -511,7 +516,10 @@ bool StoreMacroViewGui::handleInput(u64 keysDown, u64 keysHeld, const HidTouchSt
             std::string localPath = m_localPath;
             Thd::start([gameId, fileName, localPath] {
                 s_downloadSuccess = StoreData().downloadMacro(gameId, fileName, localPath);
-                if (s_downloadSuccess) StoreData::saveMacroMetadataInfo(gameId, s_selectedMacro);
+                if (s_downloadSuccess) {
+                    StoreData::saveMacroMetadataInfo(gameId, s_selectedMacro);
+                    MacroUtil::updateIndexEntry(localPath.c_str());
+                }
             });
             return true;
         }
@@ -5,6 +5,7 @@
 #include "refresh.hpp"
 #include "game.hpp"
 #include "Tthread.hpp"
+#include "name_resolver.hpp"
 #include "updater_data.hpp"
 
 
@@ -67,6 +68,8 @@ public:
     virtual void exitServices() override 
     {
         Thd::stop();                // 清理线程
+        NameResolver::stop();       // 停止游戏名称解析线程
+        GameMonitor::saveTitleNameCache();  // 保存游戏名称缓存
         curl_global_cleanup();
         socketExit();
         nsExit();                   // 退出 ns 服务
@@ -1,6 +1,7 @@
 #include "main_menu.hpp"
 #include "game.hpp"
 #include "ini_helper.hpp"
+#include "macro_util.hpp"
 #include "ipc.hpp"
 #include "sysmodule.hpp"
 #include "main_menu_setting.hpp"
@@ -46,12 +47,14 @@ void MainMenu::RefreshData() {
     m_KeyXinfo.isInGame = (currentTitleId != 0) && SysModuleManager::isRunning();
     snprintf(m_KeyXinfo.gameId, sizeof(m_KeyXinfo.gameId), "%016lX", currentTitleId);
     m_KeyXinfo.GameConfigPath = "/config/KeyX/GameConfig/" + std::string(m_KeyXinfo.gameId) + ".ini";  // 独立配置文件路径
-    m_KeyXinfo.isGlobalConfig = IniHelper::getBool("AUTOFIRE", "globconfig", true, m_KeyXinfo.GameConfigPath);  // 是否使用全局配置
-    std::string SwitchConfigPath = m_KeyXinfo.isGlobalConfig ? CONFIG_PATH : m_KeyXinfo.GameConfigPath;
+    // 每个配置文件只解析一次
+    IniHelper::IniFile& gameCfg = IniHelper::open(m_KeyXinfo.GameConfigPath);
+    m_KeyXinfo.isGlobalConfig = gameCfg.getBool("AUTOFIRE", "globconfig", true);  // 是否使用全局配置
+    IniHelper::IniFile& switchCfg = m_KeyXinfo.isGlobalConfig ? IniHelper::open(CONFIG_PATH) : gameCfg;
     if (m_KeyXinfo.isInGame) {
-        m_KeyXinfo.isAutoFireEnabled = IniHelper::getBool("AUTOFIRE", "autoenable", false, SwitchConfigPath);
-        m_KeyXinfo.isAutoRemapEnabled = IniHelper::getBool("MAPPING", "autoenable", false, SwitchConfigPath);
-        m_KeyXinfo.isAutoMacroEnabled = IniHelper::getBool("MACRO", "autoenable", false, m_KeyXinfo.GameConfigPath);   // 宏只读独立游戏配置
+        m_KeyXinfo.isAutoFireEnabled = switchCfg.getBool("AUTOFIRE", "autoenable", false);
+        m_KeyXinfo.isAutoRemapEnabled = switchCfg.getBool("MAPPING", "autoenable", false);
+        m_KeyXinfo.isAutoMacroEnabled = gameCfg.getBool("MACRO", "autoenable", false);   // 宏只读独立游戏配置
     } else {    
         m_KeyXinfo.isAutoFireEnabled = false;
         m_KeyXinfo.isAutoRemapEnabled = false;
@@ -72,24 +75,19 @@ void MainMenu::RefreshData() {
     }
 
     // 读取按钮掩码值用于绘制按钮图标
-    std::string ConfigPath = m_KeyXinfo.isGlobalConfig ? CONFIG_PATH : m_KeyXinfo.GameConfigPath;
-    std::string buttonsStr = IniHelper::getString("AUTOFIRE", "buttons", "0", ConfigPath);
+    std::string buttonsStr = switchCfg.getString("AUTOFIRE", "buttons", "0");
     m_KeyXinfo.buttons = std::stoull(buttonsStr);
     
     // 读取映射配置
     for (int i = 0; i < MappingDef::BUTTON_COUNT; i++) {
-        std::string temp = IniHelper::getString("MAPPING", s_buttonMappings[i].source, s_buttonMappings[i].source, ConfigPath);
+        std::string temp = switchCfg.getString("MAPPING", s_buttonMappings[i].source, s_buttonMappings[i].source);
         strncpy(s_buttonMappings[i].target, temp.c_str(), 7);
         s_buttonMappings[i].target[7] = '\0';
     }
 
     // 读取所有宏的快捷键
     m_KeyXinfo.macroHotKey = 0;
-    int macroCount = IniHelper::getInt("MACRO", "macroCount", 0, m_KeyXinfo.GameConfigPath);
-    for (int i = 1; i <= macroCount; i++) {
-        u64 combo = static_cast<u64>(IniHelper::getInt("MACRO", "macro_combo_" + std::to_string(i), 0, m_KeyXinfo.GameConfigPath));
-        m_KeyXinfo.macroHotKey |= combo;
-    }
+    for (u64 combo : MacroUtil::getUsedHotkeys(currentTitleId)) m_KeyXinfo.macroHotKey |= combo;
     
 }
 
@@ -104,9 +102,13 @@ void MainMenu::AutoKeyToggle() {
     m_KeyXinfo.isAutoFireEnabled = !m_KeyXinfo.isAutoFireEnabled;
     m_AutoFireEnableItem->setValue(s_switchText[m_KeyXinfo.isAutoFireEnabled]);
     m_AutoFireEnableItem->setValueColor(s_switchColor[m_KeyXinfo.isAutoFireEnabled]);
-    IniHelper::setBool("AUTOFIRE", "globconfig", m_KeyXinfo.isGlobalConfig, m_KeyXinfo.GameConfigPath);
-    IniHelper::setBool("AUTOFIRE", "autoenable", m_KeyXinfo.isAutoFireEnabled, m_KeyXinfo.GameConfigPath);
-    IniHelper::setBool("AUTOFIRE", "autoenable", m_KeyXinfo.isAutoFireEnabled, CONFIG_PATH);
+    IniHelper::IniFile& gameCfg = IniHelper::open(m_KeyXinfo.GameConfigPath);
+    IniHelper::IniFile& globalCfg = IniHelper::open(CONFIG_PATH);
+    gameCfg.setBool("AUTOFIRE", "globconfig", m_KeyXinfo.isGlobalConfig);
+    gameCfg.setBool("AUTOFIRE", "autoenable", m_KeyXinfo.isAutoFireEnabled);
+    globalCfg.setBool("AUTOFIRE", "autoenable", m_KeyXinfo.isAutoFireEnabled);
+    gameCfg.flush();
+    globalCfg.flush();
 }
 
 // 映射功能开关
@@ -119,9 +121,13 @@ void MainMenu::AutoRemapToggle() {
     m_KeyXinfo.isAutoRemapEnabled = !m_KeyXinfo.isAutoRemapEnabled;
     m_AutoRemapEnableItem->setValue(s_switchText[m_KeyXinfo.isAutoRemapEnabled]);
     m_AutoRemapEnableItem->setValueColor(s_switchColor[m_KeyXinfo.isAutoRemapEnabled]);
-    IniHelper::setBool("AUTOFIRE", "globconfig", m_KeyXinfo.isGlobalConfig, m_KeyXinfo.GameConfigPath);
-    IniHelper::setBool("MAPPING", "autoenable", m_KeyXinfo.isAutoRemapEnabled, m_KeyXinfo.GameConfigPath);
-    IniHelper::setBool("MAPPING", "autoenable", m_KeyXinfo.isAutoRemapEnabled, CONFIG_PATH);
+    IniHelper::IniFile& gameCfg = IniHelper::open(m_KeyXinfo.GameConfigPath);
+    IniHelper::IniFile& globalCfg = IniHelper::open(CONFIG_PATH);
+    gameCfg.setBool("AUTOFIRE", "globconfig", m_KeyXinfo.isGlobalConfig);
+    gameCfg.setBool("MAPPING", "autoenable", m_KeyXinfo.isAutoRemapEnabled);
+    globalCfg.setBool("MAPPING", "autoenable", m_KeyXinfo.isAutoRemapEnabled);
+    gameCfg.flush();
+    globalCfg.flush();
 }
 
 // 宏功能开关
@@ -134,19 +140,25 @@ void MainMenu::AutoMacroToggle() {
     m_KeyXinfo.isAutoMacroEnabled = !m_KeyXinfo.isAutoMacroEnabled;
     m_AutoMacroEnableItem->setValue(s_switchText[m_KeyXinfo.isAutoMacroEnabled]);
     m_AutoMacroEnableItem->setValueColor(s_switchColor[m_KeyXinfo.isAutoMacroEnabled]);
-    IniHelper::setBool("MACRO", "autoenable", m_KeyXinfo.isAutoMacroEnabled, m_KeyXinfo.GameConfigPath);
+    IniHelper::IniFile& gameCfg = IniHelper::open(m_KeyXinfo.GameConfigPath);
+    gameCfg.setBool("MACRO", "autoenable", m_KeyXinfo.isAutoMacroEnabled);
+    gameCfg.flush();
 }
 
 // 配置切换（全局/独立）
 void MainMenu::ConfigToggle() {
     if (!m_KeyXinfo.isInGame) return;
     m_KeyXinfo.isGlobalConfig = !m_KeyXinfo.isGlobalConfig;
-    IniHelper::setBool("AUTOFIRE", "globconfig", m_KeyXinfo.isGlobalConfig, m_KeyXinfo.GameConfigPath);
-    IniHelper::setBool("AUTOFIRE", "autoenable", m_KeyXinfo.isAutoFireEnabled, m_KeyXinfo.GameConfigPath);
-    IniHelper::setBool("AUTOFIRE", "autoenable", m_KeyXinfo.isAutoFireEnabled, CONFIG_PATH);
-    IniHelper::setBool("MAPPING", "autoenable", m_KeyXinfo.isAutoRemapEnabled, m_KeyXinfo.GameConfigPath);
-    IniHelper::setBool("MAPPING", "autoenable", m_KeyXinfo.isAutoRemapEnabled, CONFIG_PATH);
-    IniHelper::setBool("MACRO", "autoenable", m_KeyXinfo.isAutoMacroEnabled, m_KeyXinfo.GameConfigPath);
+    IniHelper::IniFile& gameCfg = IniHelper::open(m_KeyXinfo.GameConfigPath);
+    IniHelper::IniFile& globalCfg = IniHelper::open(CONFIG_PATH);
+    gameCfg.setBool("AUTOFIRE", "globconfig", m_KeyXinfo.isGlobalConfig);
+    gameCfg.setBool("AUTOFIRE", "autoenable", m_KeyXinfo.isAutoFireEnabled);
+    globalCfg.setBool("AUTOFIRE", "autoenable", m_KeyXinfo.isAutoFireEnabled);
+    gameCfg.setBool("MAPPING", "autoenable", m_KeyXinfo.isAutoRemapEnabled);
+    globalCfg.setBool("MAPPING", "autoenable", m_KeyXinfo.isAutoRemapEnabled);
+    gameCfg.setBool("MACRO", "autoenable", m_KeyXinfo.isAutoMacroEnabled);
+    gameCfg.flush();
+    globalCfg.flush();
     RefreshData();   // 刷新界面显示
     Result rc = g_ipcManager.sendReloadBasicCommand();
     if (R_FAILED(rc)) return;
@@ -26,7 +26,7 @@ constexpr const char* const descriptions[2][2] = {
 };
 
 SettingMenu::SettingMenu() {
-    m_notifEnabled = IniHelper::getBool("NOTIFICATION", "notif", false, CONFIG_PATH);
+    m_notifEnabled = IniHelper::open(CONFIG_PATH).getBool("NOTIFICATION", "notif", false);
     m_running = SysModuleManager::isRunning();
     m_hasFlag = SysModuleManager::hasBootFlag();
 }
@@ -82,7 +82,9 @@ tsl::elm::Element* SettingMenu::createUI() {
     listItemNotif->setClickListener([listItemNotif, this](u64 keys) {
         if (keys & HidNpadButton_A) {
             m_notifEnabled = !m_notifEnabled;
-            IniHelper::setBool("NOTIFICATION", "notif", m_notifEnabled, CONFIG_PATH);
+            IniHelper::IniFile& ini = IniHelper::open(CONFIG_PATH);
+            ini.setBool("NOTIFICATION", "notif", m_notifEnabled);
+            ini.flush();
             g_ipcManager.sendReloadBasicCommand();
             listItemNotif->setValue(m_notifEnabled ? "开" : "关");
             return true;
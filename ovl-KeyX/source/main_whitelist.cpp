@@ -2,6 +2,7 @@
 #include "game.hpp"
 #include "ini_helper.hpp"
 #include "ipc.hpp"
+#include "name_resolver.hpp"
 
 namespace {
     constexpr const char* WHITE_INI_PATH = "sdmc:/config/KeyX/white.ini";
@@ -15,43 +16,53 @@ SettingWhitelist::SettingWhitelist() {
     }
 }
 
+SettingWhitelist::~SettingWhitelist() {
+    NameResolver::stop(this);
+}
+
 tsl::elm::Element* SettingWhitelist::createUI() {
     auto frame = new tsl::elm::OverlayFrame("设置白名单", "允许按键助手在非游戏应用生效");
     auto list = new tsl::elm::List();
 
     list->addItem(new tsl::elm::CategoryHeader(" 设置后立即生效"));
 
-    for (auto& entry : m_apps) {
+    IniHelper::IniFile& whiteIni = IniHelper::open(WHITE_INI_PATH);
+    std::vector<std::pair<u32, u64>> unresolved;
+    for (size_t i = 0; i < m_apps.size(); i++) {
+        auto& entry = m_apps[i];
         char tidStr[17];
         snprintf(tidStr, sizeof(tidStr), "%016lX", entry.tid);
-        bool isWhite = IniHelper::getBool("white", tidStr, false, WHITE_INI_PATH);
-        auto item = new tsl::elm::ToggleListItem(tidStr, isWhite);
+        bool isWhite = whiteIni.getBool("white", tidStr, false);
+        // 名称缓存中有的直接显示，其余（以及还没核对版本的）交给后台线程读取
+        char nameBuf[64]{};
+        bool verified = false;
+        bool cached = GameMonitor::getCachedGameName(entry.tid, nameBuf, &verified);
+        if (!cached || !verified) unresolved.push_back({(u32)i, entry.tid});
+        auto item = new tsl::elm::ToggleListItem(cached ? nameBuf : tidStr, isWhite);
         item->setStateChangedListener([tidStr = std::string(tidStr)](bool state) {
-            if (state) IniHelper::setBool("white", tidStr, true, WHITE_INI_PATH);
-            else IniHelper::removeKey("white", tidStr, WHITE_INI_PATH);
+            IniHelper::IniFile& ini = IniHelper::open(WHITE_INI_PATH);
+            if (state) ini.setBool("white", tidStr, true);
+            else ini.removeKey("white", tidStr);
+            ini.flush();
             g_ipcManager.sendReloadWhitelistCommand();
             GameMonitor::loadWhitelist();
         });
         entry.item = item;
         list->addItem(item);
     }
+    NameResolver::start(this, std::move(unresolved));
 
     frame->setContent(list);
     return frame;
 }
 
 void SettingWhitelist::update() {
-    if (m_nextIndex >= m_apps.size()) return;
-    auto& entry = m_apps[m_nextIndex];
-    if (!entry.item) {
-        m_nextIndex++;
-        return;
-    }
-    char nameBuf[64]{};
-    if (GameMonitor::getTitleIdGameName(entry.tid, nameBuf)) {
-        entry.item->setText(nameBuf);
+    // 取出后台线程已解析的名称
+    NameResolver::Result result;
+    while (NameResolver::poll(this, result)) {
+        auto& entry = m_apps[result.index];
+        if (entry.item && result.found) entry.item->setText(result.name);
     }
-    m_nextIndex++;
 }
 
 bool SettingWhitelist::handleInput(u64 keysDown, u64 keysHeld, const HidTouchState &touchPos, 
@@ -56,12 +56,12 @@ SettingRemapConfig::SettingRemapConfig(bool isGlobal, u64 currentTitleId)
 }
 
 void SettingRemapConfig::loadMappings() {
+    IniHelper::IniFile& ini = IniHelper::open(s_configPath);
     for (int i = 0; i < MappingDef::BUTTON_COUNT; i++) {
-        std::string temp = IniHelper::getString(
+        std::string temp = ini.getString(
             "MAPPING",
             s_ButtonMappings[i].source,
-            s_ButtonMappings[i].source,
-            s_configPath
+            s_ButtonMappings[i].source
         );
         strncpy(s_ButtonMappings[i].target, temp.c_str(), 7);
         s_ButtonMappings[i].target[7] = '\0';
@@ -282,13 +282,14 @@ bool SettingRemapDisplay::handleInput(u64 keysDown, u64 keysHeld, const HidTouch
 }
 
 void SettingRemapDisplay::resetMappings() {
-    // 保存到配置文件（写入默认值）
+    // 保存到配置文件（写入默认值，全部修改后一次写回）
+    IniHelper::IniFile& ini = IniHelper::open(s_configPath);
     for (int i = 0; i < MappingDef::BUTTON_COUNT; i++) {
-        IniHelper::setString("MAPPING", 
+        ini.setString("MAPPING", 
             s_ButtonMappings[i].source, 
-            s_ButtonMappings[i].source,
-            s_configPath);
+            s_ButtonMappings[i].source);
     }
+    ini.flush();
 }
 
 
@@ -328,10 +329,11 @@ tsl::elm::Element* SettingRemapEdit::createUI() {
         item->setClickListener([this, targetName](u64 keys) {
             if (keys & HidNpadButton_A) {
                 // 保存到 INI 文件
-                IniHelper::setString("MAPPING", 
+                IniHelper::IniFile& ini = IniHelper::open(s_configPath);
+                ini.setString("MAPPING", 
                     s_ButtonMappings[m_buttonIndex].source, 
-                    targetName, 
-                    s_configPath);
+                    targetName);
+                ini.flush();
                 g_ipcManager.sendReloadMappingCommand();
                 Refresh::RefrRequest(Refresh::RemapConfig);
                 tsl::goBack();
@@ -37,14 +37,15 @@ SettingTurboConfig::SettingTurboConfig(bool isGlobal, u64 currentTitleId)
     }
 
     // 读取速度配置（0=极速, 1=高速, 2=普通）
-    int press = IniHelper::getInt("AUTOFIRE", "presstime", 50, m_ConfigPath);
+    IniHelper::IniFile& ini = IniHelper::open(m_ConfigPath);
+    int press = ini.getInt("AUTOFIRE", "presstime", 50);
     if (press == 50) m_TurboSpeed = 0;
     else if (press == 100) m_TurboSpeed = 1;
     else m_TurboSpeed = 2;
     // 读取防止误触配置（0=关闭，1=开启）
-    m_DelayStart = IniHelper::getInt("AUTOFIRE", "delaystart", 1, m_ConfigPath);
+    m_DelayStart = ini.getInt("AUTOFIRE", "delaystart", 1);
     // 读取连发按键配置（默认值：0 = 未设置连发）
-    s_TurboButtons = static_cast<u64>(IniHelper::getInt("AUTOFIRE", "buttons", 0, m_ConfigPath));
+    s_TurboButtons = static_cast<u64>(ini.getInt("AUTOFIRE", "buttons", 0));
 }
 
 tsl::elm::Element* SettingTurboConfig::createUI() {
@@ -75,8 +76,10 @@ tsl::elm::Element* SettingTurboConfig::createUI() {
         if (keys & HidNpadButton_A) {
             m_TurboSpeed = (m_TurboSpeed + 1) % 3;
             auto& newCfg = SPEED_CONFIGS[m_TurboSpeed];
-            IniHelper::setInt("AUTOFIRE", "presstime", newCfg.press, m_ConfigPath);
-            IniHelper::setInt("AUTOFIRE", "fireinterval", newCfg.release, m_ConfigPath);
+            IniHelper::IniFile& ini = IniHelper::open(m_ConfigPath);
+            ini.setInt("AUTOFIRE", "presstime", newCfg.press);
+            ini.setInt("AUTOFIRE", "fireinterval", newCfg.release);
+            ini.flush();
             g_ipcManager.sendReloadAutoFireCommand();
             listItemTurboSpeed->setValue(newCfg.name);
             listItemTurboSpeed->setValueColor(newCfg.color);
@@ -92,7 +95,9 @@ tsl::elm::Element* SettingTurboConfig::createUI() {
     listItemDelayStart->setClickListener([listItemDelayStart, this](u64 keys) {
         if (keys & HidNpadButton_A) {
             m_DelayStart = !m_DelayStart;
-            IniHelper::setInt("AUTOFIRE", "delaystart", m_DelayStart ? 1 : 0, m_ConfigPath);
+            IniHelper::IniFile& ini = IniHelper::open(m_ConfigPath);
+            ini.setInt("AUTOFIRE", "delaystart", m_DelayStart ? 1 : 0);
+            ini.flush();
             g_ipcManager.sendReloadAutoFireCommand();
             listItemDelayStart->setValue(m_DelayStart ? "开" : "关");
             return true;
@@ -214,7 +219,9 @@ tsl::elm::Element* SettingTurboButton::createUI() {
             Refresh::RefrRequest(Refresh::MainMenu);
             if (state) s_TurboButtons |= btn.flag;
             else s_TurboButtons &= ~btn.flag;
-            IniHelper::setInt("AUTOFIRE", "buttons", s_TurboButtons, m_configPath);
+            IniHelper::IniFile& ini = IniHelper::open(m_configPath);
+            ini.setInt("AUTOFIRE", "buttons", s_TurboButtons);
+            ini.flush();
             g_ipcManager.sendReloadAutoFireCommand();
         });
         m_toggleItems.push_back(item);
@@ -237,7 +244,9 @@ bool SettingTurboButton::handleInput(u64 keysDown, u64 keysHeld, const HidTouchS
     // 监控右键，执行重置功能
     if (keysDown & HidNpadButton_Right) {
         s_TurboButtons = 0;
-        IniHelper::setInt("AUTOFIRE", "buttons", s_TurboButtons, m_configPath);
+        IniHelper::IniFile& ini = IniHelper::open(m_configPath);
+        ini.setInt("AUTOFIRE", "buttons", s_TurboButtons);
+        ini.flush();
         Refresh::RefrRequest(Refresh::TurboButton);
         g_ipcManager.sendReloadAutoFireCommand();
         return true;
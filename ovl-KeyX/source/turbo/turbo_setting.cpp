@@ -9,8 +9,9 @@
 constexpr const char* CONFIG_PATH = "/config/KeyX/config.ini";
 
 SettingTurbo::SettingTurbo() {
-    m_defaultAuto = IniHelper::getBool("AUTOFIRE", "defaultautoenable", false, CONFIG_PATH);
-    m_isJCRightHand = IniHelper::getBool("AUTOFIRE", "IsJCRightHand", true, CONFIG_PATH);
+    IniHelper::IniFile& ini = IniHelper::open(CONFIG_PATH);
+    m_defaultAuto = ini.getBool("AUTOFIRE", "defaultautoenable", false);
+    m_isJCRightHand = ini.getBool("AUTOFIRE", "IsJCRightHand", true);
 }
 
 tsl::elm::Element* SettingTurbo::createUI() {
@@ -53,7 +54,9 @@ tsl::elm::Element* SettingTurbo::createUI() {
     listItemDefaultAuto->setClickListener([listItemDefaultAuto, this](u64 keys) {
         if (keys & HidNpadButton_A) {
             m_defaultAuto = !m_defaultAuto;
-            IniHelper::setBool("AUTOFIRE", "defaultautoenable", m_defaultAuto, CONFIG_PATH);
+            IniHelper::IniFile& ini = IniHelper::open(CONFIG_PATH);
+            ini.setBool("AUTOFIRE", "defaultautoenable", m_defaultAuto);
+            ini.flush();
             listItemDefaultAuto->setValue(m_defaultAuto ? "开" : "关");
             return true;
         }
@@ -70,7 +73,9 @@ tsl::elm::Element* SettingTurbo::createUI() {
     listRightOrLeftHand->setClickListener([listRightOrLeftHand, this](u64 keys) {
         if (keys & HidNpadButton_A) {
             m_isJCRightHand = !m_isJCRightHand;
-            IniHelper::setBool("AUTOFIRE", "IsJCRightHand", m_isJCRightHand, CONFIG_PATH);
+            IniHelper::IniFile& ini = IniHelper::open(CONFIG_PATH);
+            ini.setBool("AUTOFIRE", "IsJCRightHand", m_isJCRightHand);
+            ini.flush();
             listRightOrLeftHand->setValue(m_isJCRightHand ? "" : "");
             listRightOrLeftHand->setValueColor(m_isJCRightHand ? tsl::Color{0xF, 0x5, 0x5, 0xF} : tsl::Color{0x00, 0xDD, 0xFF, 0xFF});
             g_ipcManager.sendReloadAutoFireCommand();
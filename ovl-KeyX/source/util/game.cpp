@@ -4,9 +4,87 @@
 
 namespace {
     constexpr const char* WHITE_INI_PATH = "sdmc:/config/KeyX/white.ini";
+
+    constexpr const char* NAME_CACHE_PATH = "sdmc:/config/KeyX/titleNames.bin";
+    constexpr u16 NAME_CACHE_VERSION = 1;
+    constexpr size_t NAME_CACHE_CAPACITY = 256;     // 内存中最多缓存的名称数量（约20KB）
+
+    // 名称缓存文件头（后跟 count 个条目）
+    struct NameCacheHeader {
+        char magic[4];      // "KXTN"
+        u16 version;        // 缓存格式版本
+        u16 language;       // 生成缓存时的语言（语言变化后缓存作废）
+        u32 count;          // 条目数量
+    } __attribute__((packed));
+
+    // 系统语言对应的 NACP 语言下标
+    int getNacpLanguageIndex() {
+        int systemLanguageIndex = 0;
+        switch (g_systemLanguage) {
+            case SetLanguage_ENUS:
+                systemLanguageIndex = 0;
+                break;
+            case SetLanguage_ENGB:
+                systemLanguageIndex = 1;
+                break;
+            case SetLanguage_JA:
+                systemLanguageIndex = 2;
+                break;
+            case SetLanguage_FR:
+                systemLanguageIndex = 3;
+                break;
+            case SetLanguage_DE:
+                systemLanguageIndex = 4;
+                break;
+            case SetLanguage_ES419:
+                systemLanguageIndex = 5;
+                break;
+            case SetLanguage_ES:
+                systemLanguageIndex = 6;
+                break;
+            case SetLanguage_IT:
+                systemLanguageIndex = 7;
+                break;
+            case SetLanguage_NL:
+                systemLanguageIndex = 8;
+                break;
+            case SetLanguage_FRCA:
+                systemLanguageIndex = 9;
+                break;
+            case SetLanguage_PT:
+                systemLanguageIndex = 10;
+                break;
+            case SetLanguage_RU:
+                systemLanguageIndex = 11;
+                break;
+            case SetLanguage_KO:
+                systemLanguageIndex = 12;
+                break;
+            case SetLanguage_ZHTW:
+            case SetLanguage_ZHHANT:
+                systemLanguageIndex = 13;
+                break;
+            case SetLanguage_ZHCN:
+            case SetLanguage_ZHHANS:
+                systemLanguageIndex = 14;
+                break;
+            case SetLanguage_PTBR:
+                systemLanguageIndex = 15;
+                break;
+            default:
+                systemLanguageIndex = 0;
+        }
+        return systemLanguageIndex;
+    }
 }
 
 std::unordered_set<u64> GameMonitor::s_whitelist;
+std::list<GameMonitor::TitleNameEntry> GameMonitor::s_nameLru;
+std::unordered_map<u64, std::list<GameMonitor::TitleNameEntry>::iterator> GameMonitor::s_nameIndex;
+std::unordered_set<u64> GameMonitor::s_nameVerified;
+bool GameMonitor::s_nameCacheLoaded = false;
+bool GameMonitor::s_nameCacheDirty = false;
+std::mutex GameMonitor::s_nameMutex;
 
 // 获取当前运行程序的Title ID
 u64 GameMonitor::getCurrentTitleId() {
@@ -30,6 +108,9 @@ u64 GameMonitor::getCurrentTitleId() {
 // 根据Title ID获取游戏名称
 bool GameMonitor::getTitleIdGameName(u64 titleId, char* result) {
     
+    // 优先从名称缓存读取（本次运行中首次使用时先核对程序版本）
+    bool verified = false;
+    if (getCachedGameName(titleId, result, &verified) && (verified || verifyCachedName(titleId))) return true;
     strcpy(result, "UNKNOWN");
     
     // 创建控制数据的智能指针（ns 服务已在 main.cpp 全局初始化）
@@ -46,67 +127,14 @@ bool GameMonitor::getTitleIdGameName(u64 titleId, char* result) {
     NacpLanguageEntry* entry = nullptr;
     int NameLanguageIndex[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
     
-    int systemLanguageIndex = 0;
-    switch (g_systemLanguage) {
-        case SetLanguage_ENUS:
-            systemLanguageIndex = 0;
-            break;
-        case SetLanguage_ENGB:
-            systemLanguageIndex = 1;
-            break;
-        case SetLanguage_JA:
-            systemLanguageIndex = 2;
-            break;
-        case SetLanguage_FR:
-            systemLanguageIndex = 3;
-            break;
-        case SetLanguage_DE:
-            systemLanguageIndex = 4;
-            break;
-        case SetLanguage_ES419:
-            systemLanguageIndex = 5;
-            break;
-        case SetLanguage_ES:
-            systemLanguageIndex = 6;
-            break;
-        case SetLanguage_IT:
-            systemLanguageIndex = 7;
-            break;
-        case SetLanguage_NL:
-            systemLanguageIndex = 8;
-            break;
-        case SetLanguage_FRCA:
-            systemLanguageIndex = 9;
-            break;
-        case SetLanguage_PT:
-            systemLanguageIndex = 10;
-            break;
-        case SetLanguage_RU:
-            systemLanguageIndex = 11;
-            break;
-        case SetLanguage_KO:
-            systemLanguageIndex = 12;
-            break;
-        case SetLanguage_ZHTW:
-        case SetLanguage_ZHHANT:
-            systemLanguageIndex = 13;
-            break;
-        case SetLanguage_ZHCN:
-        case SetLanguage_ZHHANS:
-            systemLanguageIndex = 14;
-            break;
-        case SetLanguage_PTBR:
-            systemLanguageIndex = 15;
-            break;
-        default:
-            systemLanguageIndex = 0;
-    }
+    int systemLanguageIndex = getNacpLanguageIndex();
 
     // 优先使用系统语言
     entry = &control_data->nacp.lang[systemLanguageIndex];
     if (entry->name[0] != '\0'){
         strncpy(result, entry->name, 63);
         result[63] = '\0';
+        putTitleName(titleId, result);
         return true;
     }
     
@@ -117,12 +145,137 @@ bool GameMonitor::getTitleIdGameName(u64 titleId, char* result) {
         if (entry->name[0] == '\0') continue;
         strncpy(result, entry->name, 63);
         result[63] = '\0';
+        putTitleName(titleId, result);
         return true;
     }
 
     return false;
 }
 
+// 只从名称缓存获取游戏名称（不调用任何服务）
+bool GameMonitor::getCachedGameName(u64 titleId, char* result, bool* verified) {
+    std::lock_guard<std::mutex> lock(s_nameMutex);
+    loadTitleNameCache();
+    auto it = s_nameIndex.find(titleId);
+    if (it == s_nameIndex.end()) return false;
+    if (verified) *verified = s_nameVerified.count(titleId) != 0;
+    
+    // 移到最近使用
+    s_nameLru.splice(s_nameLru.begin(), s_nameLru, it->second);
+    strcpy(result, it->second->name);
+    return true;
+}
+
+// 核对缓存条目的程序版本（游戏更新后名称可能变化），版本变化时删除条目并返回false，未安装的游戏保留缓存
+// 查询版本是服务调用，不持有缓存锁
+bool GameMonitor::verifyCachedName(u64 titleId) {
+    u32 version = 0;
+    bool installed = getAppVersion(titleId, version);
+    
+    std::lock_guard<std::mutex> lock(s_nameMutex);
+    auto it = s_nameIndex.find(titleId);
+    if (it == s_nameIndex.end()) return false;
+    if (installed && version != it->second->version) {
+        s_nameLru.erase(it->second);
+        s_nameIndex.erase(it);
+        s_nameCacheDirty = true;
+        return false;
+    }
+    s_nameVerified.insert(titleId);
+    return true;
+}
+
+// 加入名称缓存
+void GameMonitor::putTitleName(u64 titleId, const char* name) {
+    u32 version = 0;
+    getAppVersion(titleId, version);
+    
+    std::lock_guard<std::mutex> lock(s_nameMutex);
+    loadTitleNameCache();
+    auto it = s_nameIndex.find(titleId);
+    if (it != s_nameIndex.end()) {
+        s_nameLru.erase(it->second);
+        s_nameIndex.erase(it);
+    }
+    
+    TitleNameEntry entry{};
+    entry.titleId = titleId;
+    entry.version = version;
+    strncpy(entry.name, name, sizeof(entry.name) - 1);
+    s_nameLru.push_front(entry);
+    s_nameIndex[titleId] = s_nameLru.begin();
+    s_nameVerified.insert(titleId);
+    
+    // 超过容量时淘汰最久未使用的
+    if (s_nameLru.size() > NAME_CACHE_CAPACITY) {
+        u64 oldest = s_nameLru.back().titleId;
+        s_nameIndex.erase(oldest);
+        s_nameVerified.erase(oldest);
+        s_nameLru.pop_back();
+    }
+    s_nameCacheDirty = true;
+}
+
+// 获取程序版本（本体与补丁中的最高版本），未安装时返回false
+bool GameMonitor::getAppVersion(u64 titleId, u32& version) {
+    NsApplicationContentMetaStatus list[8];
+    s32 count = 0;
+    if (R_FAILED(nsListApplicationContentMetaStatus(titleId, 0, list, 8, &count)) || count <= 0) return false;
+    version = 0;
+    for (s32 i = 0; i < count; i++) {
+        if (list[i].meta_type == NcmContentMetaType_AddOnContent) continue;
+        if (list[i].version > version) version = list[i].version;
+    }
+    return true;
+}
+
+// 从SD卡加载名称缓存（每次运行只加载一次）
+void GameMonitor::loadTitleNameCache() {
+    if (s_nameCacheLoaded) return;
+    s_nameCacheLoaded = true;
+    
+    FILE* fp = fopen(NAME_CACHE_PATH, "rb");
+    if (!fp) return;
+    NameCacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+              memcmp(header.magic, "KXTN", 4) == 0 &&
+              header.version == NAME_CACHE_VERSION &&
+              header.language == getNacpLanguageIndex();
+    if (ok) {
+        std::vector<TitleNameEntry> entries(std::min<size_t>(header.count, NAME_CACHE_CAPACITY));
+        size_t n = fread(entries.data(), sizeof(TitleNameEntry), entries.size(), fp);
+        // 文件中按最近使用顺序保存
+        for (size_t i = 0; i < n; i++) {
+            entries[i].name[sizeof(entries[i].name) - 1] = '\0';
+            if (s_nameIndex.count(entries[i].titleId)) continue;
+            s_nameLru.push_back(entries[i]);
+            s_nameIndex[entries[i].titleId] = std::prev(s_nameLru.end());
+        }
+    }
+    fclose(fp);
+}
+
+// 把名称缓存写回SD卡
+void GameMonitor::saveTitleNameCache() {
+    std::lock_guard<std::mutex> lock(s_nameMutex);
+    if (!s_nameCacheDirty) return;
+    FILE* fp = fopen(NAME_CACHE_PATH, "wb");
+    if (!fp) return;
+    NameCacheHeader header;
+    memcpy(header.magic, "KXTN", 4);
+    header.version = NAME_CACHE_VERSION;
+    header.language = getNacpLanguageIndex();
+    header.count = s_nameLru.size();
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (const auto& entry : s_nameLru) {
+        if (!ok) break;
+        ok = fwrite(&entry, sizeof(entry), 1, fp) == 1;
+    }
+    ok = (fclose(fp) == 0) && ok;
+    if (ok) s_nameCacheDirty = false;
+    else remove(NAME_CACHE_PATH);
+}
+
 // 获取所有已安装应用的Title ID列表
 std::vector<u64> GameMonitor::getInstalledAppIds() {
     std::vector<u64> result;
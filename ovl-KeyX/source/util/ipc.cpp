@@ -95,6 +95,34 @@ Result IPCManager::sendReloadWhitelistCommand() {
     return SendCommand(CMD_RELOAD_WHITELIST, false);
 }
 
+Result IPCManager::sendNextProfileCommand() {
+    return SendCommand(CMD_NEXT_PROFILE, false);
+}
+
+Result IPCManager::queryStatus(KeyXStatus& out) {
+    out = {};
+    if (!SysModuleManager::isRunning()) return 0xCAFE02;  // 系统模块未运行
+    if (!m_connected) {
+        Result rc = connect();
+        if (R_FAILED(rc)) return rc;
+    }
+    Result rc = serviceDispatchOut(&m_service, CMD_QUERY_STATUS, out);
+    disconnect();
+    return rc;
+}
+
+Result IPCManager::queryMemory(KeyXMemoryStats& out) {
+    out = {};
+    if (!SysModuleManager::isRunning()) return 0xCAFE02;  // 系统模块未运行
+    if (!m_connected) {
+        Result rc = connect();
+        if (R_FAILED(rc)) return rc;
+    }
+    Result rc = serviceDispatchOut(&m_service, CMD_QUERY_MEMORY, out);
+    disconnect();
+    return rc;
+}
+
 Result IPCManager::sendExitCommand() {
     return SendCommand(CMD_EXIT, false);
 }
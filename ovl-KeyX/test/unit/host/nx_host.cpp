@@ -0,0 +1,133 @@
+// 界面单元测试用的 libnx/libultra 替身
+#include <switch.h>
+#include <ultra.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+
+namespace {
+    std::atomic<u64> s_tick{HOST_TICK_FREQ};    // 从1秒开始计时
+    std::atomic<int> s_clockPriority{-1};
+    std::atomic<u64> s_overshootUs{0};
+    std::atomic<u64 (*)(u64)> s_padSource{nullptr};
+    thread_local int t_priority = -1;
+}
+
+u64 armGetSystemTick(void) {
+    return s_tick.load();
+}
+
+void host_advance_ms(u64 ms) {
+    s_tick += ms * (HOST_TICK_FREQ / 1000);
+}
+
+void host_set_clock_priority(int priority) {
+    s_clockPriority = priority;
+}
+
+void host_set_sleep_overshoot_us(u64 us) {
+    s_overshootUs = us;
+}
+
+void host_set_pad_source(u64 (*source)(u64 tick)) {
+    s_padSource = source;
+}
+
+Result threadCreate(Thread* t, ThreadFunc entry, void* arg, void*, size_t, int prio, int) {
+    t->priority = prio;
+    t->handle = new std::thread([entry, arg, prio] {
+        t_priority = prio;
+        entry(arg);
+    });
+    return 0;
+}
+
+Result threadStart(Thread*) {
+    return 0;
+}
+
+Result threadWaitForExit(Thread* t) {
+    static_cast<std::thread*>(t->handle)->join();
+    return 0;
+}
+
+Result threadClose(Thread* t) {
+    delete static_cast<std::thread*>(t->handle);
+    t->handle = nullptr;
+    return 0;
+}
+
+void svcSleepThread(s64 nano) {
+    if (t_priority >= 0 && t_priority == s_clockPriority) {
+        s_tick += armNsToTicks(nano + s_overshootUs * 1000);
+        std::this_thread::yield();
+    }
+    else std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+void padInitialize(PadState* pad, HidNpadIdType id) {
+    pad->id = id;
+    pad->buttons = 0;
+}
+
+void padUpdate(PadState* pad) {
+    u64 (*source)(u64) = s_padSource;
+    pad->buttons = (pad->id == HidNpadIdType_No1 && source) ? source(armGetSystemTick()) : 0;
+}
+
+u64 padGetButtons(const PadState* pad) {
+    return pad->buttons;
+}
+
+HidAnalogStickState padGetStickPos(const PadState*, unsigned) {
+    return {0, 0};
+}
+
+namespace ult {
+    // 逐级创建目录
+    void createDirectory(const std::string& path) {
+        for (size_t pos = path.find('/'); ; pos = path.find('/', pos + 1)) {
+            mkdir(path.substr(0, pos).c_str(), 0755);
+            if (pos == std::string::npos) break;
+        }
+    }
+
+    bool isFile(const std::string& path) {
+        struct stat st{};
+        return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+    }
+
+    void deleteFileOrDirectory(const std::string& path) {
+        remove(path.c_str());
+    }
+
+    std::string getFileName(const std::string& path) {
+        size_t pos = path.find_last_of('/');
+        return pos == std::string::npos ? path : path.substr(pos + 1);
+    }
+
+    std::vector<std::string> getSubdirectories(const std::string& dir) {
+        std::vector<std::string> result;
+        DIR* dp = opendir(dir.c_str());
+        if (!dp) return result;
+        while (dirent* entry = readdir(dp)) {
+            if (entry->d_type == DT_DIR && entry->d_name[0] != '.') result.push_back(entry->d_name);
+        }
+        closedir(dp);
+        return result;
+    }
+
+    std::vector<std::string> getFilesListByWildcards(const std::string& pattern) {
+        std::vector<std::string> result;
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; i++) result.push_back(matches.gl_pathv[i]);
+        }
+        globfree(&matches);
+        return result;
+    }
+}
@@ -0,0 +1,67 @@
+// 界面单元测试用的 libnx 替身：只提供被测模块用到的类型与函数，在电脑上编译
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u32 Result;
+
+#define R_SUCCEEDED(rc) ((rc) == 0)
+#define R_FAILED(rc)    ((rc) != 0)
+#define BITL(n)         (1ULL << (n))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 系统tick（与主机一致的 19.2MHz，由测试代码控制）
+#define HOST_TICK_FREQ  19200000ULL
+u64 armGetSystemTick(void);
+static inline u64 armGetSystemTickFreq(void) { return HOST_TICK_FREQ; }
+static inline u64 armTicksToNs(u64 tick) { return (tick * 625) / 12; }
+static inline u64 armNsToTicks(u64 ns) { return (ns * 12) / 625; }
+
+// 线程（用主机线程实现；以 host_set_clock_priority 指定优先级创建的线程睡眠时推进tick，其余线程睡眠不推进）
+typedef struct { void* handle; int priority; } Thread;
+typedef void (*ThreadFunc)(void*);
+Result threadCreate(Thread* t, ThreadFunc entry, void* arg, void* stack_mem, size_t stack_sz, int prio, int cpuid);
+Result threadStart(Thread* t);
+Result threadWaitForExit(Thread* t);
+Result threadClose(Thread* t);
+void svcSleepThread(s64 nano);
+
+// HID（padUpdate 按当前tick从测试设置的输入源取按键）
+typedef enum {
+    HidNpadIdType_No1      = 0,
+    HidNpadIdType_Handheld = 0x20,
+} HidNpadIdType;
+
+typedef struct { s32 x, y; } HidAnalogStickState;
+
+typedef struct {
+    HidNpadIdType id;
+    u64 buttons;
+} PadState;
+
+void padInitialize(PadState* pad, HidNpadIdType id);
+void padUpdate(PadState* pad);
+u64 padGetButtons(const PadState* pad);
+HidAnalogStickState padGetStickPos(const PadState* pad, unsigned i);
+
+#ifdef __cplusplus
+}
+#endif
+
+// 测试控制接口
+void host_advance_ms(u64 ms);
+void host_set_clock_priority(int priority);             // 该优先级的线程睡眠时推进tick（-1=都不推进）
+void host_set_sleep_overshoot_us(u64 us);               // 推进tick的睡眠每次多睡的时间（模拟调度延迟）
+void host_set_pad_source(u64 (*source)(u64 tick));      // 1号手柄的按键随tick变化（掌机手柄始终无输入）
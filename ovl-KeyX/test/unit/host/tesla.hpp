@@ -0,0 +1,6 @@
+// 界面单元测试用的 libtesla 替身：被测模块只用到 libnx 和 libultra 的部分
+#pragma once
+#include <switch.h>
+#include <ultra.hpp>
+#include <cstring>
+#include <algorithm>
@@ -0,0 +1,13 @@
+// 界面单元测试用的 libultra 替身：只提供被测模块用到的文件工具函数
+#pragma once
+#include <string>
+#include <vector>
+
+namespace ult {
+    void createDirectory(const std::string& path);
+    bool isFile(const std::string& path);
+    void deleteFileOrDirectory(const std::string& path);
+    std::string getFileName(const std::string& path);
+    std::vector<std::string> getSubdirectories(const std::string& dir);
+    std::vector<std::string> getFilesListByWildcards(const std::string& pattern);
+}
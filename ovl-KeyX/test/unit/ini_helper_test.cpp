@@ -0,0 +1,94 @@
+// IniHelper：缓存解析、外部修改检测（含同样大小的改写）、多线程共用缓存
+#include "test.hpp"
+#include "ini_helper.hpp"
+#include <string>
+#include <thread>
+#include <utime.h>
+
+namespace {
+    const std::string DIR = "ini";
+
+    void writeFile(const std::string& path, const char* text) {
+        FILE* fp = fopen(path.c_str(), "w");
+        fputs(text, fp);
+        fclose(fp);
+    }
+
+    void appendFile(const std::string& path, const char* text) {
+        FILE* fp = fopen(path.c_str(), "a");
+        fputs(text, fp);
+        fclose(fp);
+    }
+
+    void setMtime(const std::string& path, time_t mtime) {
+        struct utimbuf times = {mtime, mtime};
+        utime(path.c_str(), &times);
+    }
+
+    void testParseAndFlush() {
+        std::string path = DIR + "/parse.ini";
+        writeFile(path, "[MACRO]\nmacroCount=2\nmacro_path_1 = x\n; 注释\n[X]\nk=v\n");
+        auto& ini = IniHelper::open(path);
+        CHECK(ini.getInt("MACRO", "macroCount", 0) == 2);
+        CHECK(ini.getString("MACRO", "macro_path_1", "") == "x");
+        ini.setString("Y", "a", "b");
+        ini.removeKey("MACRO", "macroCount");
+        CHECK(ini.flush());
+        // 外部追加内容后重新解析（仍是同一个缓存对象）
+        appendFile(path, "zz=1\n");
+        auto& again = IniHelper::open(path);
+        CHECK(&again == &ini);
+        CHECK(again.getInt("Y", "zz", 0) == 1);
+        CHECK(again.getInt("MACRO", "macroCount", -1) == -1);
+    }
+
+    void testSameSizeRewrite() {
+        std::string path = DIR + "/flip.ini";
+        writeFile(path, "[FOCUS]\nenable=0\n");
+        time_t mtime = time(nullptr);
+        setMtime(path, mtime);
+        CHECK(IniHelper::open(path).getInt("FOCUS", "enable", -1) == 0);
+        // 同一个修改时间内改成同样大小的内容（FAT 2秒精度内的改写），刚解析过仍能发现
+        writeFile(path, "[FOCUS]\nenable=1\n");
+        setMtime(path, mtime);
+        CHECK(IniHelper::open(path).getInt("FOCUS", "enable", -1) == 1);
+        // 精度窗口过后确认一次内容，之后只比较文件信息
+        host_advance_ms(3000);
+        CHECK(IniHelper::open(path).getInt("FOCUS", "enable", -1) == 1);
+        writeFile(path, "[FOCUS]\nenable=0\n");
+        setMtime(path, mtime + 2);
+        CHECK(IniHelper::open(path).getInt("FOCUS", "enable", -1) == 0);
+        // 文件被删除
+        remove(path.c_str());
+        CHECK(IniHelper::open(path).getInt("FOCUS", "enable", -1) == -1);
+    }
+
+    void testThreads() {
+        std::string path = DIR + "/threads.ini";
+        std::string other = DIR + "/other.ini";
+        writeFile(other, "[S]\nk=1\n");
+        // 商店下载线程与界面线程同时读写缓存
+        std::thread worker([&] {
+            for (int i = 0; i < 2000; i++) {
+                auto& ini = IniHelper::open(path);
+                ini.setInt("S", "k" + std::to_string(i % 50), i);
+                if (i % 100 == 0) ini.flush();
+            }
+        });
+        for (int i = 0; i < 2000; i++) {
+            IniHelper::open(path).getInt("S", "k1", 0);
+            IniHelper::open(other);
+        }
+        worker.join();
+        CHECK(IniHelper::open(path).flush());
+        CHECK(IniHelper::open(path).getInt("S", "k49", 0) == 1999);
+    }
+}
+
+int main() {
+    ult::createDirectory(DIR);
+    testParseAndFlush();
+    testSameSizeRewrite();
+    testThreads();
+    return g_failures;
+}
@@ -0,0 +1,90 @@
+// MacroData：编辑保存写入失败时恢复原文件、不更新索引；写入成功时保留备份
+#include "test.hpp"
+#include "macro_data.hpp"
+#include "macro_util.hpp"
+#include <ultra.hpp>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+namespace {
+    const std::string DIR = "sdmc:/config/KeyX/macros/0100000000000000";
+    const std::string PATH = DIR + "/edit.macro";
+    constexpr u32 FRAME_COUNT = 50;
+
+    std::vector<u8> readFile(const std::string& path) {
+        std::vector<u8> data;
+        FILE* fp = fopen(path.c_str(), "rb");
+        if (!fp) return data;
+        u8 buf[512];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) data.insert(data.end(), buf, buf + n);
+        fclose(fp);
+        return data;
+    }
+
+    // 相邻帧各不相同的V2宏（保存时不会合并，文件约1.4KB）
+    void writeMacro() {
+        ult::createDirectory(DIR);
+        FILE* fp = fopen(PATH.c_str(), "wb");
+        MacroHeader header = {};
+        memcpy(header.magic, "KEYX", 4);
+        header.version = 2;
+        header.frameRate = 60;
+        header.frameCount = FRAME_COUNT;
+        fwrite(&header, sizeof(header), 1, fp);
+        for (u32 i = 0; i < FRAME_COUNT; i++) {
+            MacroFrameV2 frame = {10 + i, BITL(i % 2), 0, 0, 0, 0};
+            fwrite(&frame, sizeof(frame), 1, fp);
+        }
+        fclose(fp);
+        remove((PATH + ".bak").c_str());
+    }
+
+    // 限制本进程可写的文件大小，模拟SD卡空间不足
+    void limitFileSize(rlim_t bytes) {
+        struct rlimit limit = {bytes, RLIM_INFINITY};
+        setrlimit(RLIMIT_FSIZE, &limit);
+    }
+
+    void testFailedSave() {
+        writeMacro();
+        MacroUtil::MacroIndexEntry before{};
+        CHECK(MacroUtil::getIndexEntry(PATH.c_str(), before));
+        std::vector<u8> original = readFile(PATH);
+        CHECK(MacroData::load(PATH.c_str()));
+        MacroData::parseActions();
+
+        limitFileSize(512);
+        bool saved = MacroData::saveForEdit();
+        limitFileSize(RLIM_INFINITY);
+        CHECK(!saved);
+        CHECK(readFile(PATH) == original);
+        CHECK(!ult::isFile(PATH + ".bak"));
+        MacroUtil::MacroIndexEntry after{};
+        CHECK(MacroUtil::getIndexEntry(PATH.c_str(), after));
+        CHECK(after.frameCount == before.frameCount && after.durationMs == before.durationMs);
+    }
+
+    void testSave() {
+        writeMacro();
+        std::vector<u8> original = readFile(PATH);
+        CHECK(MacroData::load(PATH.c_str()));
+        MacroData::parseActions();
+        CHECK(MacroData::saveForEdit());
+        CHECK(readFile(PATH + ".bak") == original);
+        CHECK(readFile(PATH).size() == original.size());
+        MacroUtil::MacroIndexEntry entry{};
+        CHECK(MacroUtil::getIndexEntry(PATH.c_str(), entry));
+        CHECK(entry.frameCount == FRAME_COUNT);
+    }
+}
+
+int main() {
+    signal(SIGXFSZ, SIG_IGN);   // 超出大小限制时让写入返回错误而不是结束进程
+    testFailedSave();
+    testSave();
+    return g_failures;
+}
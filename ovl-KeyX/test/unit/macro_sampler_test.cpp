@@ -0,0 +1,114 @@
+// MacroSampler：把带时间戳的合成输入流经替身 HID 录制成宏，检查每个按键边沿的录制时间误差
+#include "test.hpp"
+#include "macro_sampler.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr u64 TITLE_ID = 0x0100000000000000;
+    constexpr double INTERVAL_MS = 1000.0 / 120;    // 默认采样率 120Hz
+
+    struct Edge {
+        u64 us;         // 相对录制开始的时刻（微秒）
+        u64 keys;       // 此后的按键状态
+    };
+
+    std::vector<Edge> s_edges;
+    u64 s_startTick = 0;
+
+    // 当前tick的按键状态
+    u64 padSource(u64 tick) {
+        u64 us = armTicksToNs(tick - s_startTick) / 1000;
+        u64 keys = 0;
+        for (const auto& edge : s_edges) {
+            if (edge.us > us) break;
+            keys = edge.keys;
+        }
+        return keys;
+    }
+
+    // 间隔 31~180ms、落在任意微秒上的边沿，按键在几个组合间切换，最后松开
+    std::vector<Edge> makeEdges(u32 count) {
+        std::vector<Edge> edges;
+        const u64 keys[] = {BITL(0), BITL(0) | BITL(1), 0, BITL(12), BITL(12) | BITL(6), BITL(3)};
+        u32 seed = 12345;
+        u64 us = 50000;
+        for (u32 i = 0; i < count; i++) {
+            seed = seed * 1103515245u + 12345u;
+            us += 31000 + (seed >> 8) % 149000;
+            edges.push_back({us, i + 1 == count ? 0 : keys[i % 6]});
+        }
+        return edges;
+    }
+
+    // 录制一次并读回帧
+    std::vector<MacroFrameV2> record(u64 overshootUs, u32& maxLateUs) {
+        s_edges = makeEdges(60);
+        host_set_pad_source(padSource);
+        host_set_sleep_overshoot_us(overshootUs);
+        MacroSampler::Prepare();
+        s_startTick = armGetSystemTick();
+        MacroSampler::Start();
+        host_set_clock_priority(44);    // 采样线程的睡眠推进时间
+        u64 endTick = s_startTick + armNsToTicks((s_edges.back().us + 200000) * 1000);
+        while (armGetSystemTick() < endTick) svcSleepThread(0);
+        MacroSampler::Stop();
+        host_set_clock_priority(-1);
+        maxLateUs = MacroSampler::GetMaxLateUs();
+
+        std::vector<MacroFrameV2> frames;
+        CHECK(!MacroSampler::HasError());
+        CHECK(MacroSampler::Save(TITLE_ID));
+        FILE* fp = fopen(MacroSampler::GetFilePath(), "rb");
+        CHECK(fp != nullptr);
+        if (!fp) return frames;
+        MacroHeader header;
+        CHECK(fread(&header, sizeof(header), 1, fp) == 1);
+        frames.resize(header.frameCount);
+        CHECK(fread(frames.data(), sizeof(MacroFrameV2), frames.size(), fp) == frames.size());
+        fclose(fp);
+        remove(MacroSampler::GetFilePath());
+        return frames;
+    }
+
+    // 每个期望边沿与录制结果中对应边沿的时间差（ms），误差必须在 [-0.5, 采样间隔+调度延迟+0.5] 内
+    void checkEdges(u64 overshootUs) {
+        u32 maxLateUs = 0;
+        std::vector<MacroFrameV2> frames = record(overshootUs, maxLateUs);
+        double bound = INTERVAL_MS + overshootUs / 1000.0 + 0.5;
+        double maxErr = 0;
+        size_t next = 0;
+        u64 atMs = 0;
+        u64 keys = 0;
+        // 第一帧从录制开始（0ms，无按键）算起，之后每次按键变化都是一个录制边沿
+        for (const auto& frame : frames) {
+            if (frame.keysHeld != keys) {
+                CHECK(next < s_edges.size() && s_edges[next].keys == frame.keysHeld);
+                if (next >= s_edges.size()) break;
+                double err = atMs - s_edges[next].us / 1000.0;
+                CHECK(err >= -0.5 && err <= bound);
+                if (err > maxErr) maxErr = err;
+                keys = frame.keysHeld;
+                next++;
+            }
+            atMs += frame.durationMs;
+        }
+        // 最后一个边沿（全部松开）是最后一帧的结束，末尾的无动作帧保存时已移除
+        CHECK(next + 1 == s_edges.size());
+        if (next + 1 == s_edges.size()) {
+            double err = atMs - s_edges[next].us / 1000.0;
+            CHECK(err >= -0.5 && err <= bound);
+            if (err > maxErr) maxErr = err;
+        }
+        CHECK(maxLateUs + 1 >= overshootUs && maxLateUs <= overshootUs + 1);
+        printf("调度延迟 %lluus：%zu 个边沿，最大误差 %.3fms（上限 %.3fms），最大采样延迟 %uus\n",
+               (unsigned long long)overshootUs, s_edges.size(), maxErr, bound, maxLateUs);
+    }
+}
+
+int main() {
+    checkEdges(0);
+    checkEdges(300);
+    checkEdges(2000);
+    return g_failures;
+}
@@ -0,0 +1,87 @@
+// PieceTable：随机插入/删除/改写/复制/移动，与 std::vector 上的同样操作逐步比对
+#include "test.hpp"
+#include "piece_table.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+    // 移动前序列中的 dstPos 插入位置，与 PieceTable::move 的约定一致
+    void moveRef(std::vector<int>& ref, u32 pos, u32 count, u32 dst) {
+        if (dst >= pos && dst <= pos + count) return;
+        std::vector<int> moved(ref.begin() + pos, ref.begin() + pos + count);
+        ref.erase(ref.begin() + pos, ref.begin() + pos + count);
+        if (dst > pos) dst -= count;
+        ref.insert(ref.begin() + dst, moved.begin(), moved.end());
+    }
+
+    void testRandomOps() {
+        std::mt19937 rng(1);
+        auto rand = [&](u32 n) { return (u32)(rng() % n); };
+        PieceTable<int> table;
+        std::vector<int> ref(500);
+        for (int i = 0; i < 500; i++) ref[i] = i;
+        table.load(std::vector<int>(ref));
+        int next = 1000;
+        for (int it = 0; it < 200000; it++) {
+            u32 n = ref.size();
+            u32 pos = n ? rand(n) : 0;
+            u32 count = n ? std::min<u32>(rand(5) + 1, n - pos) : 0;
+            switch (rand(6)) {
+            case 0: {
+                u32 at = rand(n + 1);
+                std::vector<int> data(rand(5) + 1);
+                for (auto& v : data) v = next++;
+                table.insert(at, data.data(), data.size());
+                ref.insert(ref.begin() + at, data.begin(), data.end());
+                break;
+            }
+            case 1:
+                if (n <= 300) break;
+                table.erase(pos, count);
+                ref.erase(ref.begin() + pos, ref.begin() + pos + count);
+                break;
+            case 2: {
+                int* frames = table.writable(pos, count);
+                for (u32 i = 0; i < count; i++) frames[i] = ref[pos + i] = next++;
+                break;
+            }
+            case 3: {
+                if (n >= 2000) break;
+                u32 dst = rand(n + 1);
+                table.insertCopy(dst, pos, count);
+                std::vector<int> copied(ref.begin() + pos, ref.begin() + pos + count);
+                ref.insert(ref.begin() + dst, copied.begin(), copied.end());
+                break;
+            }
+            case 4: {
+                u32 dst = rand(n + 1);
+                table.move(pos, count, dst);
+                moveRef(ref, pos, count, dst);
+                break;
+            }
+            case 5: {
+                // 目标落在被移动的范围内（含两端）：序列不变
+                u32 dst = pos + rand(count + 1);
+                table.move(pos, count, dst);
+                break;
+            }
+            }
+            if (it % 997 == 0) {
+                std::vector<int> flat;
+                table.flatten(flat);
+                CHECK(flat == ref);
+                CHECK(table.size() == ref.size());
+                if (flat != ref) return;
+            }
+        }
+        std::vector<int> flat;
+        table.flatten(flat);
+        CHECK(flat == ref);
+        for (u32 i = 0; i < ref.size(); i += 37) CHECK(table.at(i) == ref[i]);
+    }
+}
+
+int main() {
+    testRandomOps();
+    return g_failures;
+}
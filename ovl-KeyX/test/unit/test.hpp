@@ -0,0 +1,9 @@
+// 单元测试的断言宏：失败时打印位置并计数，main 返回失败数
+#pragma once
+#include <cstdio>
+
+inline int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { std::printf("%s:%d: CHECK(%s) 失败\n", __FILE__, __LINE__, #cond); ++g_failures; } \
+} while (0)
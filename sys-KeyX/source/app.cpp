@@ -6,10 +6,20 @@
 #include <cstdlib>
 #include "libnotification.h"
 #include "language.hpp"
+#include "log.h"
+#include "threadcfg.hpp"
 
 #define CONFIG_DIR "/config/KeyX"
 #define CONFIG_PATH "/config/KeyX/config.ini"
 
+namespace {
+    // 游戏状态检测间隔（游戏退出由进程句柄信号驱动，不依赖轮询）
+    constexpr u64 POLL_IDLE_NS = 250000000ULL;      // 250ms 无游戏时检测启动
+    constexpr u64 POLL_FOCUS_NS = 100000000ULL;     // 100ms 功能运行中检测焦点
+    constexpr u64 POLL_RUNNING_NS = 500000000ULL;   // 500ms 功能未开启时
+    constexpr u64 POLL_EXITING_NS = 10000000ULL;    // 10ms 进程已终止，等待 pm 清理
+}
+
 // 检查文件是否存在
 bool App::FileExists(const char* path) {
     struct stat st;
@@ -25,12 +35,21 @@ bool App::InitializeConfigPath() {
 
 // App类的实现
 App::App() {
+    ueventCreate(&m_WakeEvent, true);
     if (!InitializeConfigPath()) return;
+    // 逐帧事件追踪（默认关闭，只用于排查问题）
+    if (ini_getbool("LOG", "trace", 0, CONFIG_PATH)) log_ring_start();
+    // 线程优先级和核心（主线程立即应用，其他线程创建时使用）
+    ThreadConfig::Load(CONFIG_PATH);
+    ThreadConfig::ApplyToCurrentThread(ThreadConfig::Monitor());
+    m_PadConnectionEventValid = R_SUCCEEDED(hidsysAcquireUniquePadConnectionEventHandle(&m_PadConnectionEvent));
     if (!InitializeIPC()) return;
     m_loop_error = false;
 }
 
 App::~App() {
+    if (m_PadConnectionEventValid) eventClose(&m_PadConnectionEvent);
+    log_ring_stop();
 }
 
 // 初始化IPC服务
@@ -44,8 +63,7 @@ bool App::InitializeIPC() {
 
     // 设置退出回调
     ipc_server->SetExitCallback([this]() {
-        ButtonRemapper::RestoreMapping();
-        m_loop_error = true;
+        PostRequest(REQ_EXIT);
     });
     
     // 设置开启连发回调
@@ -60,7 +78,7 @@ bool App::InitializeIPC() {
     // 设置关闭连发回调
     ipc_server->SetDisableAutoFireCallback([this]() {
         m_CurrentAutoEnable = false;
-        if (!m_CurrentAutoMacroEnable) StopAutoKey();
+        if (!NeedAutoKey()) StopAutoKey();
         else UpdateTurboConfig();
     });
     
@@ -76,30 +94,23 @@ bool App::InitializeIPC() {
     // 设置关闭宏回调
     ipc_server->SetDisableMacroCallback([this]() {
         m_CurrentAutoMacroEnable = false;
-        if (!m_CurrentAutoEnable) StopAutoKey();
+        if (!NeedAutoKey()) StopAutoKey();
         else UpdateMacroConfig();
     });
     
-    // 设置开启映射回调
+    // 设置开启映射回调（交给主循环处理）
     ipc_server->SetEnableMappingCallback([this]() {
-        m_CurrentAutoRemapEnable = true;
-        if (m_GameInFocus) ButtonRemapper::SetMapping(m_ConfigPath);
-        UpdateButtonMappingConfig();
+        PostRequest(REQ_ENABLE_REMAP, REQ_DISABLE_REMAP);
     });
     
-    // 设置关闭映射回调
+    // 设置关闭映射回调（交给主循环处理）
     ipc_server->SetDisableMappingCallback([this]() {
-        m_CurrentAutoRemapEnable = false;
-        ButtonRemapper::RestoreMapping();
+        PostRequest(REQ_DISABLE_REMAP, REQ_ENABLE_REMAP);
     });
     
-    // 设置重载全部配置
+    // 设置重载全部配置（交给主循环处理）
     ipc_server->SetReloadBasicCallback([this]() {
-        LoadGameConfig(m_CurrentTid);
-        if (m_GameInFocus && m_CurrentAutoRemapEnable) ButtonRemapper::SetMapping(m_ConfigPath);
-        UpdateTurboConfig();
-        UpdateMacroConfig();
-        UpdateButtonMappingConfig();
+        PostRequest(REQ_RELOAD_BASIC);
     });
     
     // 设置重载连发配置回调
@@ -112,10 +123,9 @@ bool App::InitializeIPC() {
         UpdateMacroConfig();
     });
     
-    // 设置重载映射配置回调
+    // 设置重载映射配置回调（交给主循环处理）
     ipc_server->SetReloadMappingCallback([this]() {
-        if (m_GameInFocus && m_CurrentAutoRemapEnable) ButtonRemapper::SetMapping(m_ConfigPath);
-        UpdateButtonMappingConfig();
+        PostRequest(REQ_RELOAD_REMAP);
     });
 
     // 重载白名单
@@ -123,6 +133,16 @@ bool App::InitializeIPC() {
         GameMonitor::LoadWhitelist();
     });
 
+    // 切换映射方案（交给主循环处理）
+    ipc_server->SetNextProfileCallback([this]() {
+        RequestProfileSwitch();
+    });
+
+    // 设置状态查询回调
+    ipc_server->SetStatusCallback([this](KeyXStatus& status) {
+        FillStatus(status);
+    });
+
     // 启动服务
     if (!ipc_server->Start("keyLoop")) {
         ipc_server.reset();
@@ -134,39 +154,99 @@ bool App::InitializeIPC() {
 
 
 void App::Loop() {
+    m_WakeTick = armGetSystemTick();
     while (!m_loop_error) {
         GameStateResult game = GameMonitor::GetState();
         switch (game.event) {
             case GameEvent::Idle:
                 // 无游戏运行
-                for (int i = 0; i < 10 && !m_loop_error; ++i) svcSleepThread(100000000ULL);
-                continue;
+                m_PollIntervalNs = POLL_IDLE_NS;
+                break;
             case GameEvent::Running:
                 OnGameRunning(game.tid);
-                if (autokey_loop || m_CurrentAutoRemapEnable) svcSleepThread(100000000ULL);
-                else for (int i = 0; i < 5 && !m_loop_error; ++i) svcSleepThread(100000000ULL);
-                continue;
+                m_PollIntervalNs = (autokey_loop || m_CurrentAutoRemapEnable) ? POLL_FOCUS_NS : POLL_RUNNING_NS;
+                break;
             case GameEvent::Launched:
                 OnGameLaunched(game.tid);
+                m_PollIntervalNs = POLL_FOCUS_NS;
                 break;
             case GameEvent::Exited:
                 OnGameExited();
+                m_PollIntervalNs = POLL_IDLE_NS;
                 break;
             default:
                 break;
         }
-        svcSleepThread(100000000ULL);  // 100ms
+        WaitForEvent(m_PollIntervalNs);
     }
 }
 
+// 等待下一次检测
+void App::WaitForEvent(u64 timeout_ns) {
+    // 等待对象：0=唤醒事件，1=手柄连接事件，2=游戏进程（均为可选）
+    Waiter waiters[3];
+    s32 types[3];
+    s32 count = 0;
+    waiters[count] = waiterForUEvent(&m_WakeEvent);
+    types[count++] = 0;
+    if (m_PadConnectionEventValid) {
+        waiters[count] = waiterForEvent(&m_PadConnectionEvent);
+        types[count++] = 1;
+    }
+    Handle process = GameMonitor::GetProcessHandle();
+    if (process != INVALID_HANDLE) {
+        waiters[count] = waiterForHandle(process);
+        types[count++] = 2;
+        m_ProcessExiting = false;
+    }
+    else if (m_ProcessExiting) timeout_ns = POLL_EXITING_NS;
+    
+    s32 index = -1;
+    Result rc = waitObjects(&index, waiters, count, timeout_ns);
+    m_WakeTick = armGetSystemTick();
+    
+    // 无论被哪个对象唤醒，都先执行已投递的请求
+    u32 requests = m_PendingRequests.exchange(0);
+    if (requests) HandleRequests(requests);
+    if (R_FAILED(rc) || index < 0 || index >= count) return;
+    
+    switch (types[index]) {
+        case 1:
+            OnPadConnectionChanged();
+            break;
+        case 2:
+            // 进程状态发生变化，清除信号后立即重新检测
+            // 已终止的进程无法清除信号，释放句柄并快速检测直到 pm 清理完进程
+            if (R_FAILED(svcResetSignal(process))) {
+                GameMonitor::ReleaseProcessHandle();
+                m_ProcessExiting = true;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// 处理手柄连接变化（只对新连接的手柄应用已缓存的映射）
+// 耗时从连接事件使主循环的等待返回时算起（含先执行的已投递请求）
+void App::OnPadConnectionChanged() {
+    eventClear(&m_PadConnectionEvent);
+    if (!m_GameInFocus || !m_CurrentAutoRemapEnable) return;
+    ButtonRemapper::ApplyToNewPads();
+    m_HotplugLatencyNs = armTicksToNs(armGetSystemTick() - m_WakeTick);
+}
+
 // 处理游戏启动事件
 void App::OnGameLaunched(u64 tid) {
+    log_event(LOG_EVT_GAME, (u32)GameEvent::Launched, tid, 0);
     m_FirstLaunch = true;
     m_GameInFocus = true;
     m_CurrentTid = tid;
     LoadGameConfig(tid);
-    if (m_CurrentAutoEnable || m_CurrentAutoMacroEnable) StartAutoKey();
+    ButtonRemapper::ResetProfile();
+    if (NeedAutoKey()) StartAutoKey();
     if (m_CurrentAutoRemapEnable) ButtonRemapper::SetMapping(m_ConfigPath);
+    m_LaunchLatencyNs = armTicksToNs(armGetSystemTick() - m_WakeTick);
     CreateNotification(true);
 }
 
@@ -177,10 +257,10 @@ void App::OnGameRunning(u64 tid) {
     switch (focus) {
         case FocusState::InFocus:
             m_GameInFocus = true;
-            if ((m_CurrentAutoEnable || m_CurrentAutoMacroEnable) && autokey_loop) ResumeAutoKey();
-            else if ((m_CurrentAutoEnable || m_CurrentAutoMacroEnable) && !autokey_loop) StartAutoKey();
-            else if (!m_CurrentAutoEnable && !m_CurrentAutoMacroEnable && autokey_loop) StopAutoKey();
-            if (m_CurrentAutoRemapEnable) ButtonRemapper::SetMapping(m_ConfigPath);
+            if (NeedAutoKey() && autokey_loop) ResumeAutoKey();
+            else if (NeedAutoKey() && !autokey_loop) StartAutoKey();
+            else if (!NeedAutoKey() && autokey_loop) StopAutoKey();
+            if (m_CurrentAutoRemapEnable) ButtonRemapper::EnableMapping();
             break;
         case FocusState::OutOfFocus:
             m_GameInFocus = false;
@@ -188,12 +268,16 @@ void App::OnGameRunning(u64 tid) {
             if (m_CurrentAutoRemapEnable) ButtonRemapper::RestoreMapping();
             break;
         default:
-            break;
+            return;
     }
+    m_FocusLatencyNs = armTicksToNs(armGetSystemTick() - m_WakeTick);
+    log_event(LOG_EVT_FOCUS, (u32)focus, tid, m_FocusLatencyNs);
 }
 
 // 处理游戏退出事件
 void App::OnGameExited() {
+    log_event(LOG_EVT_GAME, (u32)GameEvent::Exited, m_CurrentTid, 0);
+    m_ProcessExiting = false;
     m_GameInFocus = false;
     if (autokey_loop) StopAutoKey();
     m_CurrentTid = 0;
@@ -226,6 +310,85 @@ void App::LoadBasicConfig(u64 tid) {
     m_CurrentAutoEnable = ini_getbool("AUTOFIRE", "autoenable", 0, switchConfigPath);
     m_CurrentAutoRemapEnable = ini_getbool("MAPPING", "autoenable", 0, switchConfigPath);
     m_CurrentAutoMacroEnable = ini_getbool("MACRO", "autoenable", 0, m_GameConfigPath);  // 宏只读取独立配置
+    RefreshRemapFeatures();
+}
+
+// 刷新依赖按键线程的映射功能（规则、组合键和映射参数在同一个配置文件）
+// 软件映射需要映射开启且配置了规则，方案切换组合键需要映射开启且配置了组合键
+void App::RefreshRemapFeatures() {
+    m_CurrentSoftRemapEnable = m_CurrentAutoRemapEnable && ini_getl("SOFTMAP", "ruleCount", 0, m_ConfigPath) > 0;
+    m_ProfileHotkey = 0;
+    if (m_CurrentAutoRemapEnable) {
+        char comboStr[32];
+        ini_gets("MAPPING", "profileHotkey", "0", comboStr, sizeof(comboStr), m_ConfigPath);
+        m_ProfileHotkey = strtoull(comboStr, nullptr, 10);
+    }
+}
+
+// 请求切换映射方案（可在IPC线程或按键线程中调用，实际切换在主循环中进行）
+void App::RequestProfileSwitch() {
+    PostRequest(REQ_NEXT_PROFILE);
+}
+
+// 投递请求并唤醒主循环
+void App::PostRequest(u32 request, u32 cancels) {
+    if (cancels) m_PendingRequests.fetch_and(~cancels);
+    m_PendingRequests.fetch_or(request);
+    ueventSignal(&m_WakeEvent);
+}
+
+// 执行投递的请求（ButtonRemapper 的状态只在主循环中读写）
+void App::HandleRequests(u32 requests) {
+    if (requests & REQ_ENABLE_REMAP) {
+        m_CurrentAutoRemapEnable = true;
+        ReloadMapping();
+        UpdateButtonMappingConfig();
+        ApplyRemapChange();
+    }
+    if (requests & REQ_DISABLE_REMAP) {
+        m_CurrentAutoRemapEnable = false;
+        ButtonRemapper::RestoreMapping();
+        ApplyRemapChange();
+    }
+    if (requests & REQ_RELOAD_BASIC) {
+        LoadGameConfig(m_CurrentTid);
+        if (m_CurrentAutoRemapEnable) ReloadMapping();
+        UpdateTurboConfig();
+        UpdateMacroConfig();
+        UpdateRemapConfig();
+        UpdateButtonMappingConfig();
+    }
+    if (requests & REQ_RELOAD_REMAP) {
+        if (m_CurrentAutoRemapEnable) ReloadMapping();
+        UpdateButtonMappingConfig();
+        ApplyRemapChange();
+    }
+    if (requests & REQ_NEXT_PROFILE) SwitchRemapProfile();
+    if (requests & REQ_EXIT) {
+        ButtonRemapper::RestoreMapping();
+        m_loop_error = true;
+    }
+}
+
+// 重新读取映射方案（不在焦点时只读取，回到焦点时 EnableMapping 应用的就是新方案）
+void App::ReloadMapping() {
+    if (m_GameInFocus) ButtonRemapper::SetMapping(m_ConfigPath);
+    else ButtonRemapper::LoadProfiles(m_ConfigPath);
+}
+
+// 切换到下一个映射方案（方案已预先解析，只需重新设置手柄配置）
+void App::SwitchRemapProfile() {
+    if (!m_GameInFocus || !m_CurrentAutoRemapEnable) return;
+    ButtonRemapper::NextProfile();
+    ButtonRemapper::EnableMapping();
+}
+
+// 映射开关或配置变化后，按需启动/更新/退出按键模块
+void App::ApplyRemapChange() {
+    RefreshRemapFeatures();
+    if (!NeedAutoKey()) StopAutoKey();
+    else if (autokey_loop) UpdateRemapConfig();
+    else if (m_GameInFocus) StartAutoKey();
 }
 
 // 开启按键模块
@@ -233,7 +396,9 @@ bool App::StartAutoKey() {
     std::lock_guard<std::mutex> lock(autokey_mutex);
     // 如果已经创建，则不重复创建
     if (autokey_loop) return true;
-    autokey_loop = std::make_unique<AutoKeyLoop>(m_ConfigPath, m_GameConfigPath, m_CurrentAutoEnable, m_CurrentAutoMacroEnable);
+    autokey_loop = std::make_unique<AutoKeyLoop>(m_ConfigPath, m_GameConfigPath, m_CurrentAutoEnable, m_CurrentAutoMacroEnable, m_CurrentSoftRemapEnable);
+    autokey_loop->SetProfileHotkeyCallback([this]() { RequestProfileSwitch(); });
+    autokey_loop->SetProfileHotkey(m_ProfileHotkey);
     return true;
 }
 
@@ -271,6 +436,15 @@ void App::UpdateMacroConfig() {
     }
 }
 
+// 更新软件映射配置和方案切换组合键
+void App::UpdateRemapConfig() {
+    std::lock_guard<std::mutex> lock(autokey_mutex);
+    if (autokey_loop) {
+        autokey_loop->UpdateSoftRemapFeature(m_CurrentSoftRemapEnable, m_ConfigPath);
+        autokey_loop->SetProfileHotkey(m_ProfileHotkey);
+    }
+}
+
 // 更新按键映射配置
 void App::UpdateButtonMappingConfig() {
     std::lock_guard<std::mutex> lock(autokey_mutex);
@@ -279,6 +453,25 @@ void App::UpdateButtonMappingConfig() {
     }
 }
 
+// 填充运行状态
+void App::FillStatus(KeyXStatus& status) {
+    status.tid = m_CurrentTid;
+    if (m_CurrentAutoEnable) status.features |= STATUS_FEATURE_TURBO;
+    if (m_CurrentAutoMacroEnable) status.features |= STATUS_FEATURE_MACRO;
+    if (m_CurrentAutoRemapEnable) status.features |= STATUS_FEATURE_MAPPING;
+    if (m_GameInFocus) status.features |= STATUS_FEATURE_FOCUS;
+    status.pollIntervalMs = m_PollIntervalNs / 1000000;
+    status.launchLatencyUs = m_LaunchLatencyNs / 1000;
+    status.focusLatencyUs = m_FocusLatencyNs / 1000;
+    status.inputPriority = ThreadConfig::Input().priority;
+    status.inputCore = ThreadConfig::Input().core;
+    status.remapProfile = ButtonRemapper::GetActiveProfile();
+    status.remapProfileCount = ButtonRemapper::GetProfileCount();
+    status.hotplugLatencyUs = m_HotplugLatencyNs / 1000;
+    std::lock_guard<std::mutex> lock(autokey_mutex);
+    if (autokey_loop) autokey_loop->FillStatus(status);
+}
+
 void App::ShowNotification(const char* message) {
     if (m_notifEnabled) createNotification(message, 2, INFO, RIGHT);
 }
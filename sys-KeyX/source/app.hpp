@@ -5,6 +5,7 @@
 #include "focus.hpp"
 #include "game.hpp"
 #include <mutex>
+#include <atomic>
 #include <memory>
 
 // APP应用程序类
@@ -26,21 +27,63 @@ private:
     const char* m_ConfigPath;                // 其他配置路径（根据globconfig决定）
 
     // 当前游戏是否在焦点中
-    bool m_GameInFocus = false;
+    std::atomic<bool> m_GameInFocus{false};
 
     bool m_FirstLaunch = false;
 
+    // 唤醒主循环的事件（IPC退出等需要立即处理的情况）
+    UEvent m_WakeEvent;
+    
+    // 手柄连接变化事件（用于新连接的手柄立即应用映射）
+    Event m_PadConnectionEvent;
+    bool m_PadConnectionEventValid = false;
+    
+    // 游戏进程已终止，等待 pm 清理进程（此期间快速检测）
+    bool m_ProcessExiting = false;
+    
+    // 检测与响应耗时统计（状态查询用）
+    // 状态查询在 IPC 线程读取，FillStatus 读取的成员（含下方的 TID 和功能开关）都是原子变量
+    // 启动和焦点变化都靠轮询发现，系统不提供足够精确的事件时间戳，耗时从主循环被唤醒算起（含本轮检测查询），
+    // 不含唤醒前的等待；等待最多一个检测间隔
+    std::atomic<u64> m_PollIntervalNs{0};    // 当前检测间隔
+    u64 m_WakeTick = 0;                      // 主循环本轮被唤醒的时刻
+    std::atomic<u64> m_LaunchLatencyNs{0};   // 本轮唤醒 → 检测到启动 → 功能生效
+    std::atomic<u64> m_FocusLatencyNs{0};    // 本轮唤醒 → 检测到焦点变化 → 暂停/恢复生效
+    std::atomic<u64> m_HotplugLatencyNs{0};  // 手柄连接事件唤醒主循环 → 映射生效
+
     // 连发功能相关配置
-    u64 m_CurrentTid = 0;                    // 当前游戏 TID
-    bool m_CurrentAutoEnable = false;        // 是否自动启动
+    std::atomic<u64> m_CurrentTid{0};        // 当前游戏 TID
+    std::atomic<bool> m_CurrentAutoEnable{false};  // 是否自动启动
     bool m_CurrentGlobConfig = true;         // 是否使用全局配置
 
     // 按键映射功能相关配置
-    bool m_CurrentAutoRemapEnable = false;         // 是否自动启动
+    std::atomic<bool> m_CurrentAutoRemapEnable{false};  // 是否自动启动
+    bool m_CurrentSoftRemapEnable = false;         // 映射开启且配置了软件映射规则
+    u64 m_ProfileHotkey = 0;                       // 映射方案切换组合键（0=不检测）
     
     // 宏功能相关配置
-    bool m_CurrentAutoMacroEnable = false;         // 宏功能是否自动启动
-    
+    std::atomic<bool> m_CurrentAutoMacroEnable{false};  // 宏功能是否自动启动
+    
+    // 等待主循环处理的请求（IPC线程和按键线程只投递，映射的所有改动都在主循环中进行）
+    enum PendingRequest : u32 {
+        REQ_NEXT_PROFILE  = 1 << 0,    // 切换到下一个映射方案
+        REQ_ENABLE_REMAP  = 1 << 1,    // 开启映射
+        REQ_DISABLE_REMAP = 1 << 2,    // 关闭映射
+        REQ_RELOAD_REMAP  = 1 << 3,    // 重载映射配置
+        REQ_RELOAD_BASIC  = 1 << 4,    // 重载全部配置
+        REQ_EXIT          = 1 << 5,    // 恢复映射并退出
+    };
+    std::atomic<u32> m_PendingRequests{0};
+
+    // 投递请求并唤醒主循环（cancels 中的请求被新请求取代）
+    void PostRequest(u32 request, u32 cancels = 0);
+
+    // 执行投递的请求（主循环中调用）
+    void HandleRequests(u32 requests);
+
+    // 重新读取映射方案（在焦点时同时应用到手柄）
+    void ReloadMapping();
+
     // 初始化配置路径（确保目录存在）
     bool InitializeConfigPath();
     
@@ -56,11 +99,32 @@ private:
     // 加载基础配置（确定配置路径）
     void LoadBasicConfig(u64 tid);
     
+    // 刷新依赖按键线程的映射功能（软件映射规则、方案切换组合键）
+    void RefreshRemapFeatures();
+    
+    // 请求切换映射方案（任意线程，唤醒主循环处理）
+    void RequestProfileSwitch();
+    
+    // 切换到下一个映射方案（主循环中调用）
+    void SwitchRemapProfile();
+    
+    // 映射开关或配置变化后，按需启动/更新/退出按键模块
+    void ApplyRemapChange();
+    
+    // 是否需要按键模块（连发、宏、软件映射或方案切换组合键任一开启）
+    bool NeedAutoKey() const { return m_CurrentAutoEnable || m_CurrentAutoMacroEnable || m_CurrentSoftRemapEnable || m_ProfileHotkey != 0; }
+    
 
     
     // 获取当前游戏 Title ID（仅游戏，非游戏返回0）
     u64 GetCurrentGameTitleId();
     
+    // 等待下一次检测（游戏进程状态变化或被唤醒时提前返回）
+    void WaitForEvent(u64 timeout_ns);
+    
+    // 处理手柄连接变化
+    void OnPadConnectionChanged();
+    
     // 游戏事件处理函数
     void OnGameLaunched(u64 tid);
     void OnGameRunning(u64 tid);
@@ -90,9 +154,15 @@ private:
     // 更新宏配置（线程安全）
     void UpdateMacroConfig();
     
+    // 更新软件映射配置和方案切换组合键（线程安全）
+    void UpdateRemapConfig();
+    
     // 更新按键映射配置（线程安全）
     void UpdateButtonMappingConfig();
     
+    // 填充运行状态（IPC状态查询，线程安全）
+    void FillStatus(KeyXStatus& status);
+    
 public:
     // 构造函数
     App();
@@ -2,6 +2,9 @@
 #include <cstring>
 #include "minIni.h"
 #include "common.hpp"
+#include "log.h"
+#include "alloctrap.h"
+#include "threadcfg.hpp"
 
 namespace {
     // 摇杆伪按键位掩码 (BIT16-23)，必须过滤
@@ -71,7 +74,7 @@ alignas(0x1000) char AutoKeyLoop::thread_stack[4 * 1024];
 alignas(0x1000) u8 AutoKeyLoop::hdls_work_buffer[0x1000];
 
 // 构造函数
-AutoKeyLoop::AutoKeyLoop(const char* config_path, const char* macroCfgPath, bool enable_turbo, bool enable_macro) {
+AutoKeyLoop::AutoKeyLoop(const char* config_path, const char* macroCfgPath, bool enable_turbo, bool enable_macro, bool enable_softremap) {
     // 初始化HDLS工作缓冲区
     Result rc = hiddbgAttachHdlsWorkBuffer(&m_HdlsSessionId, hdls_work_buffer, sizeof(hdls_work_buffer));
     if (R_FAILED(rc)) return;
@@ -87,16 +90,16 @@ AutoKeyLoop::AutoKeyLoop(const char* config_path, const char* macroCfgPath, bool
     m_MappingCount = 0;
     memset(m_TargetMasks, 0, sizeof(m_TargetMasks));
     memset(m_SourceMasks, 0, sizeof(m_SourceMasks));
+    memset(m_ReverseLut, 0, sizeof(m_ReverseLut));
     
     // 初始化功能开关
-    m_EnableTurbo = enable_turbo;
-    m_EnableMacro = enable_macro;
-    // 根据开关创建功能模块
-    if (m_EnableTurbo) {
-        m_Turbo = std::make_unique<Turbo>(config_path);
-        m_isJCRightHand = m_Turbo->IsJCRightHand();
-    }
-    if (m_EnableMacro) m_Macro = std::make_unique<Macro>(macroCfgPath);
+    m_EnableTurbo = false;
+    m_EnableMacro = false;
+    m_EnableSoftRemap = false;
+    // 根据开关加载功能模块配置
+    UpdateTurboFeature(enable_turbo, config_path);
+    UpdateMacroFeature(enable_macro, macroCfgPath);
+    UpdateSoftRemapFeature(enable_softremap, config_path);
     
     // 初始化手柄类型
     m_ControllerType = ControllerType::C_NONE;
@@ -109,8 +112,12 @@ AutoKeyLoop::AutoKeyLoop(const char* config_path, const char* macroCfgPath, bool
     m_ThreadRunning = false;
     memset(&m_Thread, 0, sizeof(Thread));
     
+    // 宏帧窗口读取线程（启动失败时播放中在按键线程里直接读取）
+    m_Macro.StartReader(ThreadConfig::Reader());
+    
     // 创建线程
-    rc = threadCreate(&m_Thread, ThreadFunc, this, thread_stack, sizeof(thread_stack), 44, -2);
+    const ThreadSetting& setting = ThreadConfig::Input();
+    rc = threadCreate(&m_Thread, ThreadFunc, this, thread_stack, sizeof(thread_stack), setting.priority, setting.core);
     if (R_FAILED(rc)) return;
     m_ThreadCreated = true;
     
@@ -137,33 +144,63 @@ void AutoKeyLoop::ThreadFunc(void* arg) {
 
 // 主循环
 void AutoKeyLoop::MainLoop() {
+    // 稳定运行时按键线程不允许分配堆内存（调试构建中统计违规）
+    alloc_tripwire_watch();
     while (!m_ShouldExit) {
-        ProcessResult result{};
-        ReadPhysicalInput(result);
-        DetermineEvent(result);
-        switch (result.event) {
-            case FeatureEvent::PAUSED:
-                for (int i = 0; i < 10 && !m_ShouldExit; ++i) svcSleepThread(100000000ULL);  // 100ms
-                continue;
-            case FeatureEvent::IDLE:
-                break;
-            case FeatureEvent::STARTING:
-                hiddbgDumpHdlsStates(m_HdlsSessionId, &m_StateList);
-                break;
-            case FeatureEvent::Turbo_EXECUTING:
-                ApplyHdlsState(result);
-                break;
-            case FeatureEvent::Macro_EXECUTING:
-                ApplyHdlsState(result);
-                break;
-            case FeatureEvent::FINISHING:
-                result.analog_stick_l = {0};
-                result.analog_stick_r = {0};
-                InjectAll(result);
-                break;
+        if (m_HoldRequested) {
+            // 其他线程正在修改功能模块状态，停在这里直到修改完成
+            m_Held = true;
+            while (m_HoldRequested && !m_ShouldExit) svcSleepThread(UPDATE_INTERVAL_NS);
+            m_Held = false;
+            continue;
+        }
+        if (Tick() == FeatureEvent::PAUSED) {
+            for (int i = 0; i < 10 && !m_ShouldExit && !m_HoldRequested; ++i) svcSleepThread(100000000ULL);  // 100ms
+            continue;
         }
+        // 统计唤醒延迟（按下/松开边沿的时间误差主要来自这里）
+        u64 sleep_tick = armGetSystemTick();
         svcSleepThread(UPDATE_INTERVAL_NS);
+        u64 slept_ns = armTicksToNs(armGetSystemTick() - sleep_tick);
+        m_WakeJitter.Record(slept_ns > UPDATE_INTERVAL_NS ? slept_ns - UPDATE_INTERVAL_NS : 0);
+    }
+    alloc_tripwire_unwatch();
+}
+
+// 执行一次循环：读取输入、判定事件并注入
+FeatureEvent AutoKeyLoop::Tick() {
+    ProcessResult result{};
+    result.tick = armGetSystemTick();
+    ReadPhysicalInput(result);
+    DetermineEvent(result);
+    m_LoopTicks++;
+    log_event(LOG_EVT_TICK, (u32)result.event, result.buttons, result.OtherButtons);
+    switch (result.event) {
+        case FeatureEvent::PAUSED:
+        case FeatureEvent::IDLE:
+            break;
+        case FeatureEvent::STARTING:
+            hiddbgDumpHdlsStates(m_HdlsSessionId, &m_StateList);
+            break;
+        case FeatureEvent::Turbo_EXECUTING:
+            ApplyHdlsState(result);
+            m_InjectTicks++;
+            break;
+        case FeatureEvent::Macro_EXECUTING:
+            ApplyHdlsState(result);
+            m_InjectTicks++;
+            break;
+        case FeatureEvent::Remap_EXECUTING:
+            ApplyHdlsState(result);
+            m_InjectTicks++;
+            break;
+        case FeatureEvent::FINISHING:
+            result.analog_stick_l = {0};
+            result.analog_stick_r = {0};
+            InjectAll(result);
+            break;
     }
+    return result.event;
 }
 
 // 判定事件
@@ -174,31 +211,81 @@ void AutoKeyLoop::DetermineEvent(ProcessResult& result) {
         2. 检测事件时优先检测宏的事件
         3. 如果宏事件只要不是IDLE，就直接返回宏事件
         4. 在返回之前，会检查宏事件是否为STARTING，且若连发模块启用了，就重置一次连发的状态机参数
-        5. 如果宏事件是返回的IDLE，则检查连发模块是否启用，如果启用则返回连发模块的事件
-        6. 如果连发模块没有启用，则返回IDLE
+        5. 如果宏事件是返回的IDLE，则检查连发模块是否启用，如果启用且不是IDLE则返回连发模块的事件
+        6. 软件映射最先改写输入（宏和连发看到的都是映射后的按键），但优先级最低，
+           只有宏和连发都是IDLE时才由软件映射自己注入
+        7. 都没有则返回IDLE
     */ 
     if (m_IsPaused || m_ControllerType == ControllerType::C_NONE) {
         result.event = FeatureEvent::PAUSED;
         return;
     }
-    if (m_Macro) {
-        m_Macro->Process(result);
-        if (result.event == FeatureEvent::STARTING && m_Turbo) m_Turbo->TurboFinishing();
+    if (m_MacroFlushPending) {
+        // 宏播放中被重载或关闭，注入一次清理残留的宏按键
+        m_MacroFlushPending = false;
+        result.event = FeatureEvent::FINISHING;
+        return;
+    }
+    CheckProfileHotkey(result.buttons);
+    bool remapped = m_EnableSoftRemap && m_SoftRemap.Process(result);
+    if (m_EnableMacro) {
+        m_Macro.Process(result);
+        if (result.event == FeatureEvent::STARTING && m_EnableTurbo) m_Turbo.TurboFinishing();
+        if (result.event != FeatureEvent::IDLE) return;
+    }
+    if (m_EnableTurbo) {
+        m_Turbo.Process(result, m_isJoyCon);
         if (result.event != FeatureEvent::IDLE) return;
     }
-    if (m_Turbo) {
-        m_Turbo->Process(result, m_isJoyCon);
+    if (remapped) {
+        // 第一次生效时先备份HDLS状态，之后持续注入映射后的按键
+        result.OtherButtons = result.buttons;
+        result.event = m_SoftRemapInjecting ? FeatureEvent::Remap_EXECUTING : FeatureEvent::STARTING;
+        m_SoftRemapInjecting = true;
+        return;
+    }
+    if (m_SoftRemapInjecting) {
+        // 规则不再满足，注入一次原始输入清理残留
+        m_SoftRemapInjecting = false;
+        result.OtherButtons = result.buttons;
+        result.event = FeatureEvent::FINISHING;
         return;
     }
     result.event = FeatureEvent::IDLE;
 }
 
 
+// 检测映射方案切换组合键
+// 映射由系统按键配置实现，读到的已经是映射后的按键，组合键也按映射后的按键判定
+void AutoKeyLoop::CheckProfileHotkey(u64 buttons) {
+    u64 combo = m_ProfileHotkey;
+    if (combo == 0) return;
+    bool pressed = (buttons & combo) == combo;
+    if (pressed && !m_ProfileHotkeyPressed && m_ProfileHotkeyCallback) m_ProfileHotkeyCallback();
+    m_ProfileHotkeyPressed = pressed;
+}
+
+// 让按键线程停在循环开头（线程未运行时直接返回）
+void AutoKeyLoop::HoldLoop() {
+    if (!m_ThreadRunning) return;
+    m_HoldRequested = true;
+    while (!m_Held && !m_ShouldExit) svcSleepThread(UPDATE_INTERVAL_NS);
+}
+
+// 恢复按键线程（等它离开停顿，避免下一次 HoldLoop 看到旧的确认）
+void AutoKeyLoop::ReleaseLoop() {
+    m_HoldRequested = false;
+    while (m_Held && !m_ShouldExit) svcSleepThread(UPDATE_INTERVAL_NS);
+}
+
 // 暂停
 void AutoKeyLoop::Pause() {
-    if (m_Turbo) m_Turbo->TurboFinishing();
-    if (m_Macro) m_Macro->MacroFinishing();
+    HoldLoop();
+    if (m_EnableTurbo) m_Turbo.TurboFinishing();
+    if (m_EnableMacro) m_Macro.MacroFinishing();
+    m_SoftRemapInjecting = false;
     m_IsPaused = true;
+    ReleaseLoop();
 }
 
 // 恢复
@@ -206,26 +293,64 @@ void AutoKeyLoop::Resume() {
     m_IsPaused = false;
 }
 
-// 更新连发功能
-void AutoKeyLoop::UpdateTurboFeature(bool enable, const char* config_path) {
-    if (m_EnableTurbo && enable && m_Turbo) {
-        m_Turbo->LoadConfig(config_path);
-        m_isJCRightHand = m_Turbo->IsJCRightHand();
+// 填充运行状态
+void AutoKeyLoop::FillStatus(KeyXStatus& status) const {
+    status.features |= STATUS_FEATURE_RUNNING;
+    if (m_IsPaused) status.features |= STATUS_FEATURE_PAUSED;
+    status.controllerType = (u8)m_ControllerType;
+    if (m_EnableTurbo) {
+        status.turboActive = m_Turbo.IsActive();
+        status.turboPressed = m_Turbo.IsPressed();
     }
-    else if (m_EnableTurbo && !enable && m_Turbo) m_Turbo.reset();
-    else if (!m_EnableTurbo && enable) {
-        m_Turbo = std::make_unique<Turbo>(config_path);
-        m_isJCRightHand = m_Turbo->IsJCRightHand();
+    if (m_EnableMacro) m_Macro.FillStatus(status);
+    status.loopTicks = m_LoopTicks;
+    status.injectTicks = m_InjectTicks;
+    status.allocViolations = alloc_tripwire_violations();
+    status.wakeSamples = m_WakeJitter.Samples();
+    status.wakeJitterP50Us = m_WakeJitter.PercentileUs(50);
+    status.wakeJitterP99Us = m_WakeJitter.PercentileUs(99);
+    status.wakeJitterMaxUs = m_WakeJitter.MaxUs();
+}
+
+// 更新连发功能（按键线程停下后再修改）
+void AutoKeyLoop::UpdateTurboFeature(bool enable, const char* config_path) {
+    HoldLoop();
+    if (!enable) {
+        m_EnableTurbo = false;
+        m_Turbo.TurboFinishing();
+    } else {
+        if (!m_EnableTurbo) m_Turbo.TurboFinishing();
+        m_Turbo.LoadConfig(config_path);
+        m_isJCRightHand = m_Turbo.IsJCRightHand();
+        m_EnableTurbo = true;
     }
-    m_EnableTurbo = enable;
+    ReleaseLoop();
 }
 
-// 更新宏功能
+// 更新宏功能（宏列表和帧数据在按键线程中使用，按键线程停下后再重载或释放）
 void AutoKeyLoop::UpdateMacroFeature(bool enable, const char* macroCfgPath) {
-    if (m_EnableMacro && enable && m_Macro) m_Macro->LoadConfig(macroCfgPath);
-    else if (m_EnableMacro && !enable && m_Macro) m_Macro.reset();
-    else if (!m_EnableMacro && enable) m_Macro = std::make_unique<Macro>(macroCfgPath);
-    m_EnableMacro = enable;
+    HoldLoop();
+    if (m_EnableMacro && m_Macro.IsPlaying()) m_MacroFlushPending = true;
+    if (!enable) {
+        m_EnableMacro = false;
+        m_Macro.Unload();
+    } else {
+        m_Macro.LoadConfig(macroCfgPath);
+        m_EnableMacro = true;
+    }
+    ReleaseLoop();
+}
+
+// 更新软件映射功能（按键线程停下后再修改）
+void AutoKeyLoop::UpdateSoftRemapFeature(bool enable, const char* config_path) {
+    HoldLoop();
+    if (!enable) {
+        m_EnableSoftRemap = false;
+    } else {
+        m_SoftRemap.LoadConfig(config_path);
+        m_EnableSoftRemap = true;
+    }
+    ReleaseLoop();
 }
 
 // 按键名转换为掩码
@@ -249,8 +374,9 @@ u64 AutoKeyLoop::ButtonNameToMask(const char* name) const {
     return 0;
 }
 
-// 更新按键映射配置（生成逆映射表）
+// 更新按键映射配置（生成逆映射表，按键线程停下后再修改）
 void AutoKeyLoop::UpdateButtonMappings(const char* config_path) {
+    HoldLoop();
     m_MappingCount = 0;
     for (int i = 0; i < MAX_MAPPINGS; i++) {
         char target_buf[64];
@@ -273,31 +399,45 @@ void AutoKeyLoop::UpdateButtonMappings(const char* config_path) {
             m_MappingCount++;
         }
     }
+    BuildReverseLut();
+    ReleaseLoop();
 }
 
-// 应用逆映射到按键（两阶段处理：先收集，后应用）
+// 生成逆映射查找表
+// 每个切片的表项是该字节值命中的所有映射合并后的清除/设置掩码
+void AutoKeyLoop::BuildReverseLut() {
+    for (int k = 0; k < 2; k++) {
+        for (u32 v = 0; v < 256; v++) {
+            u64 bits = (u64)v << (k * 8);
+            u64 to_clear = 0, to_set = 0;
+            for (int i = 0; i < m_MappingCount; i++) {
+                if (bits & m_TargetMasks[i]) {
+                    to_clear |= m_TargetMasks[i];
+                    to_set |= m_SourceMasks[i];
+                }
+            }
+            m_ReverseLut[k][v].clear = (u16)to_clear;
+            m_ReverseLut[k][v].set = (u16)to_set;
+        }
+    }
+}
+
+// 应用逆映射到按键（查表：低字节和高字节各查一次，合并清除/设置掩码）
 // 只有lite需要这个，不然映射后连发按键错乱
 // 别问为什么
 void AutoKeyLoop::ApplyReverseMapping(u64& buttons) const {
     if (m_MappingCount == 0 || buttons == 0) return;
-    u64 to_clear = 0;  // 要清除的按键掩码
-    u64 to_set = 0;    // 要设置的按键掩码
-    // 第一阶段：遍历逆映射表，收集要修改的按键
-    for (int i = 0; i < m_MappingCount; i++) {
-        if (buttons & m_TargetMasks[i]) {
-            to_clear |= m_TargetMasks[i];  // 记录要清除的目标按键
-            to_set |= m_SourceMasks[i];    // 记录要设置的源按键
-        }
-    }
-    // 第二阶段：一次性应用所有修改
+    const ReverseEntry& lo = m_ReverseLut[0][buttons & 0xFF];
+    const ReverseEntry& hi = m_ReverseLut[1][(buttons >> 8) & 0xFF];
     // 1. 清除所有要映射的按键：buttons & ~to_clear
     // 2. 设置所有映射后的按键：... | to_set
-    buttons = (buttons & ~to_clear) | to_set;
+    buttons = (buttons & ~(u64)(lo.clear | hi.clear)) | (u64)(lo.set | hi.set);
 }
 
 // 读取物理输入
 void AutoKeyLoop::ReadPhysicalInput(ProcessResult& result) {
     m_isJoyCon = false;
+    ControllerType last_type = m_ControllerType;
     // 先确认手柄类型
     HidNpadIdType npad_id = HidNpadIdType_No1;
     u32 style_set = hidGetNpadStyleSet(npad_id);
@@ -312,6 +452,7 @@ void AutoKeyLoop::ReadPhysicalInput(ProcessResult& result) {
         if (m_isJoyCon) m_ControllerType = ControllerType::C_JOYCON;
         else m_ControllerType = ControllerType::C_LITE;
     }
+    if (m_ControllerType != last_type) log_event(LOG_EVT_CONTROLLER, (u32)m_ControllerType, (u64)last_type, 0);
     // 根据类型读取按键数据
     switch (m_ControllerType) {
         case ControllerType::C_PRO:
@@ -1,15 +1,19 @@
 #pragma once
 
 #include <switch.h>
-#include <memory>
+#include <functional>
+#include <atomic>
 #include "common.hpp"
 #include "turbo.hpp"
 #include "macro.hpp"
+#include "softremap.hpp"
+#include "ipc.hpp"
+#include "jitter.hpp"
 
 class AutoKeyLoop {
 public:
     // 构造函数
-    AutoKeyLoop(const char* config_path, const char* macroCfgPath, bool enable_turbo, bool enable_macro);
+    AutoKeyLoop(const char* config_path, const char* macroCfgPath, bool enable_turbo, bool enable_macro, bool enable_softremap);
     
     // 析构函数
     ~AutoKeyLoop();
@@ -20,12 +24,26 @@ public:
     // 更新宏功能
     void UpdateMacroFeature(bool enable, const char* macroCfgPath);
     
+    // 更新软件映射功能
+    void UpdateSoftRemapFeature(bool enable, const char* config_path);
+    
     // 更新按键映射（用于动态重载配置）
     void UpdateButtonMappings(const char* config_path);
     
+    // 设置映射方案切换组合键（0表示不检测），按下时在按键线程中调用回调
+    void SetProfileHotkey(u64 combo) { m_ProfileHotkey = combo; }
+    void SetProfileHotkeyCallback(std::function<void()> callback) { m_ProfileHotkeyCallback = callback; }
+    
     // 控制接口
     void Pause();
     void Resume();
+    
+    // 填充运行状态（IPC状态查询用，只读）
+    void FillStatus(KeyXStatus& status) const;
+    
+    // 执行一次循环（读取输入、判定事件并注入），按键线程每1ms调用一次；
+    // 线程没有创建成功时（回放测试）由调用者逐帧驱动
+    FeatureEvent Tick();
 
 private:
     // 手柄类型枚举
@@ -54,18 +72,36 @@ private:
     
     // 线程资源
     Thread m_Thread;
-    bool m_ThreadCreated;
-    bool m_ThreadRunning;
+    bool m_ThreadCreated = false;
+    bool m_ThreadRunning = false;
     bool m_ShouldExit;
     bool m_IsPaused;
     
+    // 按键线程停顿（修改功能模块状态期间，按键线程停在循环开头等待）
+    std::atomic<bool> m_HoldRequested{false};   // 请求按键线程停下
+    std::atomic<bool> m_Held{false};            // 按键线程已停下
+    bool m_MacroFlushPending = false;           // 宏播放被配置更新打断，恢复后注入一次清理
+    
+    // 循环计数（状态查询用）
+    u64 m_LoopTicks = 0;                      // 主循环次数
+    u64 m_InjectTicks = 0;                    // 注入次数
+    WakeJitter m_WakeJitter;                  // 每次休眠后的唤醒延迟
+    
     alignas(0x1000) static char thread_stack[4 * 1024];
     
-    // 功能模块
-    std::unique_ptr<Turbo> m_Turbo;
-    std::unique_ptr<Macro> m_Macro;
-    bool m_EnableTurbo;
-    bool m_EnableMacro;
+    // 功能模块（随对象一起分配，开关只切换启用标志，运行中不再创建/销毁）
+    Turbo m_Turbo;
+    Macro m_Macro;
+    SoftRemap m_SoftRemap;
+    volatile bool m_EnableTurbo;
+    volatile bool m_EnableMacro;
+    volatile bool m_EnableSoftRemap;
+    bool m_SoftRemapInjecting = false;        // 软件映射是否正在注入
+    
+    // 映射方案切换组合键
+    volatile u64 m_ProfileHotkey = 0;
+    bool m_ProfileHotkeyPressed = false;
+    std::function<void()> m_ProfileHotkeyCallback;
     
     
     
@@ -75,15 +111,29 @@ private:
     u64 m_SourceMasks[MAX_MAPPINGS];         // 源按键掩码（要注入的）
     int m_MappingCount;                       // 有效映射数量
     
+    // 逆映射查找表（按键低16位按8位切片，每次只需两次查表）
+    struct ReverseEntry {
+        u16 clear;                            // 要清除的目标按键
+        u16 set;                              // 要设置的源按键
+    };
+    ReverseEntry m_ReverseLut[2][256];
+    
     // 内部方法
     static void ThreadFunc(void* arg);
     
     // 主循环（在线程中运行）
     void MainLoop();
     
+    // 让按键线程停在循环开头（返回后可以安全修改功能模块状态），修改完成后调用 ReleaseLoop
+    void HoldLoop();
+    void ReleaseLoop();
+    
     // 事件判定
     void DetermineEvent(ProcessResult& result);
     
+    // 检测映射方案切换组合键（按下时触发一次，松开后才能再次触发）
+    void CheckProfileHotkey(u64 buttons);
+    
     // 读取物理输入（从 HID 读取真实手柄状态）
     void ReadPhysicalInput(ProcessResult& result);
     
@@ -100,6 +150,7 @@ private:
     // 逆映射相关辅助方法
     void ApplyReverseMapping(u64& buttons) const;
     void ApplyForwardMapping(u64& buttons) const;
+    void BuildReverseLut();
     u64 ButtonNameToMask(const char* name) const;
 };
 
@@ -1,18 +1,20 @@
 #pragma once
 #include <switch.h>
 
-// 功能事件（连发和宏共用）
+// 功能事件（连发、宏和软件映射共用）
 enum class FeatureEvent {
     PAUSED,       // 模块暂停0
     IDLE,         // 无操作/待机1
     STARTING,     // 启动功能2
     Turbo_EXECUTING,    // 执行中3
     Macro_EXECUTING,    // 执行中4
-    FINISHING     // 功能结束5
+    FINISHING,    // 功能结束5
+    Remap_EXECUTING     // 软件映射执行中6
 };
 
 // 处理结果（连发和宏共用）
 struct ProcessResult {
+    u64 tick;                               // 本次循环的系统tick（同一次循环内所有模块使用同一时间）
     FeatureEvent event;                     // 事件状态
     u64 buttons;                            // 原始物理输入的按键
     HidAnalogStickState analog_stick_l;     // 左摇杆
@@ -1,10 +1,14 @@
 #include "macro.hpp"
 #include "minIni.h"
+#include "mempool.h"
 #include <cstdio>
+#include <cstring>
 
 // 常量定义
 constexpr u64 STOP_COOLDOWN_NS = 250000000ULL;        // 250ms 停止后延迟
 constexpr u64 LONG_PRESS_THRESHOLD_NS = 500000000ULL; // 500ms 长按阈值
+constexpr const char* MACROS_DIR = "/config/KeyX/macros/";
+constexpr u16 BINDING_VERSION = 1;
 constexpr u64 THRESHOLD_NS = 158000000ULL;            // 158ms (实测最大会有292ms的相同帧，但是经过实测发现改成158并不会造成问题，所以就这样不管了)
 
 // 构造函数
@@ -12,26 +16,96 @@ Macro::Macro(const char* macroCfgPath) {
     LoadConfig(macroCfgPath);
 }
 
-// 加载配置
+// 析构函数（宏列表和帧数据都在内存池中，整体释放）
+Macro::~Macro() {
+    CloseMacroFile();
+    mempool_reset(MEMPOOL_CONFIG);
+    mempool_reset(MEMPOOL_MACRO);
+}
+
+// 加载配置（先停止播放并清空旧的宏列表，旧的宏索引不再有效）
 void Macro::LoadConfig(const char* macroCfgPath) {
-    m_Macros.clear();
+    Unload();
+    if (!LoadBindingTable(macroCfgPath)) LoadLegacyConfig(macroCfgPath);
+}
+
+// 读取绑定表（游戏配置 {TID}.ini 旁的 {TID}_macros.bin，记录整块读入配置内存池）
+bool Macro::LoadBindingTable(const char* macroCfgPath) {
+    char bindPath[128];
+    const char* ext = strrchr(macroCfgPath, '.');
+    int baseLen = ext ? (int)(ext - macroCfgPath) : (int)strlen(macroCfgPath);
+    snprintf(bindPath, sizeof(bindPath), "%.*s_macros.bin", baseLen, macroCfgPath);
+    FsFileSystem* fs = fsdevGetDeviceFileSystem("sdmc");
+    if (!fs) return false;
+    FsFile file;
+    if (R_FAILED(fsFsOpenFile(fs, bindPath, FsOpenMode_Read, &file))) return false;
+    s64 size = 0;
+    BindingHeader header;
+    u64 bytesRead = 0;
+    if (R_FAILED(fsFileGetSize(&file, &size)) || size < (s64)sizeof(BindingHeader) ||
+        (size - sizeof(BindingHeader)) % sizeof(MacroEntry) != 0 ||
+        R_FAILED(fsFileRead(&file, 0, &header, sizeof(header), FsReadOption_None, &bytesRead)) || bytesRead != sizeof(header) ||
+        memcmp(header.magic, "KXMB", 4) != 0 || header.version != BINDING_VERSION ||
+        header.count != (size - sizeof(BindingHeader)) / sizeof(MacroEntry)) {
+        fsFileClose(&file);
+        return false;
+    }
+    // 只读入配置内存池放得下的记录（插件限制了绑定数量，超出的部分不加载，绑定表有效，不再回退到旧版配置）
+    u32 poolCapacity = 0;
+    mempool_stats(MEMPOOL_CONFIG, &poolCapacity, nullptr, nullptr, nullptr);
+    int count = header.count;
+    if (count > (int)(poolCapacity / sizeof(MacroEntry))) count = poolCapacity / sizeof(MacroEntry);
+    u64 recordSize = (u64)count * sizeof(MacroEntry);
+    m_Macros = count > 0 ? (MacroEntry*)mempool_alloc(MEMPOOL_CONFIG, recordSize) : nullptr;
+    Result rc = m_Macros ? fsFileRead(&file, sizeof(BindingHeader), m_Macros, recordSize, FsReadOption_None, &bytesRead) : 0;
+    fsFileClose(&file);
+    if (!m_Macros) return true;
+    if (R_FAILED(rc) || bytesRead != recordSize) {
+        m_Macros = nullptr;
+        mempool_reset(MEMPOOL_CONFIG);
+        return false;
+    }
+    // 记录直接作为宏列表使用，只去掉无效的绑定
+    for (int i = 0; i < count; i++) {
+        m_Macros[i].path[sizeof(m_Macros[i].path) - 1] = '\0';
+        if (m_Macros[i].combo == 0 || m_Macros[i].path[0] == '\0') continue;
+        if (m_MacroCount != i) m_Macros[m_MacroCount] = m_Macros[i];
+        m_MacroCount++;
+    }
+    return true;
+}
+
+// 读取游戏配置中的旧版绑定（macroCount + macro_path_N / macro_combo_N）
+void Macro::LoadLegacyConfig(const char* macroCfgPath) {
     int macroCount = ini_getl("MACRO", "macroCount", 0, macroCfgPath);
+    if (macroCount <= 0) return;
+    m_Macros = (MacroEntry*)mempool_alloc(MEMPOOL_CONFIG, sizeof(MacroEntry) * macroCount);
+    if (!m_Macros) return;
+    size_t dirLen = strlen(MACROS_DIR);
     for (int i = 1; i <= macroCount; i++) {
-        MacroEntry entry;
+        MacroEntry& entry = m_Macros[m_MacroCount];
+        memset(&entry, 0, sizeof(MacroEntry));
         char pathKey[32];
         sprintf(pathKey, "macro_path_%d", i);
-        ini_gets("MACRO", pathKey, "", entry.MacroFilePath, sizeof(entry.MacroFilePath), macroCfgPath);
+        char macroPath[160];
+        ini_gets("MACRO", pathKey, "", macroPath, sizeof(macroPath), macroCfgPath);
+        // 宏目录下的文件只保存相对路径
+        const char* path = strncmp(macroPath, "sdmc:", 5) == 0 ? macroPath + 5 : macroPath;
+        path = strncmp(path, MACROS_DIR, dirLen) == 0 ? path + dirLen : macroPath;
+        if (strlen(path) >= sizeof(entry.path)) continue;
+        strcpy(entry.path, path);
         char comboKey[32];
         sprintf(comboKey, "macro_combo_%d", i);
         char comboStr[32];
         ini_gets("MACRO", comboKey, "0", comboStr, sizeof(comboStr), macroCfgPath);
         entry.combo = strtoull(comboStr, nullptr, 10);
-        if (entry.combo != 0 && entry.MacroFilePath[0] != '\0') m_Macros.push_back(entry);
+        if (entry.combo != 0 && entry.path[0] != '\0') m_MacroCount++;
     }
 }
 
 // 核心函数：处理输入
 void Macro::Process(ProcessResult& result) {
+    m_Now = result.tick;
     result.event = DetermineEvent(result.buttons);
     // 根据事件执行对应操作
     switch (result.event) {
@@ -54,7 +128,7 @@ void Macro::Process(ProcessResult& result) {
 
 // 判定事件
 FeatureEvent Macro::DetermineEvent(u64 buttons) {
-    if (m_Macros.empty()) return FeatureEvent::IDLE;
+    if (m_MacroCount == 0) return FeatureEvent::IDLE;
     if (m_IsPlaying) return HandlePlayingState(buttons);
     if (m_JustStopped) return HandleStopCooldown(buttons);
     return HandleNormalTrigger(buttons);
@@ -71,13 +145,13 @@ FeatureEvent Macro::HandlePlayingState(u64 buttons) {
     }
     // 记录快捷键处于按下状态还是松开状态
     m_HotkeyPressed = isCurrentMacroPressed;
-    size_t frameCount = (m_Version == 1) ? m_Frames.size() : m_FramesV2.size();
-    if (frameCount == 0) return FeatureEvent::FINISHING;
-    // 计算当前帧并检查播放进度
+    if (m_FrameCount == 0) return FeatureEvent::FINISHING;
+    // 计算当前帧并检查播放进度（读取帧数据失败时帧数会被清零）
     m_CurrentFrameIndex = CalculateTargetFrame();
-    if (m_CurrentFrameIndex >= frameCount) {
+    if (m_FrameCount == 0) return FeatureEvent::FINISHING;
+    if (m_CurrentFrameIndex >= m_FrameCount) {
         if (!m_RepeatMode) return FeatureEvent::FINISHING;
-        m_PlaybackStartTick = armGetSystemTick();
+        m_PlaybackStartTick = m_Now;
         m_CurrentFrameIndex = 0;
         m_AccumulatedMs = 0;
     }
@@ -87,7 +161,7 @@ FeatureEvent Macro::HandlePlayingState(u64 buttons) {
 // 从FINISHING状态进入IDLE状态
 FeatureEvent Macro::HandleStopCooldown(u64 buttons) {
     // 因为注入会污染数据，导致按键状态异常，所以等待一段时间
-    u64 elapsedSinceStop = armTicksToNs(armGetSystemTick() - m_LastFinishTime);
+    u64 elapsedSinceStop = armTicksToNs(m_Now - m_LastFinishTime);
     if (elapsedSinceStop < STOP_COOLDOWN_NS) return FeatureEvent::IDLE;
     // 检查对应的快捷键是否松开了
     u64 currentCombo = m_Macros[m_CurrentMacroIndex].combo;
@@ -106,12 +180,12 @@ FeatureEvent Macro::HandleNormalTrigger(u64 buttons) {
     bool isAnyMacroPressed = (triggered != -1);
     // 检测到快捷键刚按下
     if (isAnyMacroPressed && !m_HotkeyPressed) {
-        m_HotkeyPressTime = armGetSystemTick();
+        m_HotkeyPressTime = m_Now;
         m_CurrentMacroIndex = triggered;
     }
     // 检测到快捷键刚松开
     else if (!isAnyMacroPressed && m_HotkeyPressed) {
-        u64 pressDuration = armTicksToNs(armGetSystemTick() - m_HotkeyPressTime);
+        u64 pressDuration = armTicksToNs(m_Now - m_HotkeyPressTime);
         m_RepeatMode = (pressDuration >= LONG_PRESS_THRESHOLD_NS);
         m_HotkeyPressed = false;
         m_HotkeyPressTime = 0;
@@ -123,7 +197,7 @@ FeatureEvent Macro::HandleNormalTrigger(u64 buttons) {
 }
 
 int Macro::CheckHotkeyTriggered(u64 buttons) {
-    for (size_t i = 0; i < m_Macros.size(); i++) {
+    for (int i = 0; i < m_MacroCount; i++) {
         u64 combo = m_Macros[i].combo;
         if ((buttons & combo) == combo) return i;
     }
@@ -136,15 +210,17 @@ u32 Macro::CalculateTargetFrame() {
         case 1: {
             // V1: 按帧率计算
             if (m_FrameRate == 0) return 0;
-            u64 elapsedTicks = armGetSystemTick() - m_PlaybackStartTick;
+            u64 elapsedTicks = m_Now - m_PlaybackStartTick;
             u64 ticksPerFrame = armGetSystemTickFreq() / m_FrameRate;
             return elapsedTicks / ticksPerFrame;
         }
         default: {
             // V2: 按持续时间累加计算，只在帧切换时累加
-            u64 elapsedMs = armTicksToNs(armGetSystemTick() - m_PlaybackStartTick) / 1000000;
-            while (m_CurrentFrameIndex < m_FramesV2.size()) {
-                u64 frameEndMs = m_AccumulatedMs + m_FramesV2[m_CurrentFrameIndex].durationMs;
+            u64 elapsedMs = armTicksToNs(m_Now - m_PlaybackStartTick) / 1000000;
+            while (m_CurrentFrameIndex < m_FrameCount) {
+                const MacroFrameV2* frame = FrameV2At(m_CurrentFrameIndex);
+                if (!frame) break;
+                u64 frameEndMs = m_AccumulatedMs + frame->durationMs;
                 if (elapsedMs < frameEndMs) break;
                 m_AccumulatedMs = frameEndMs;
                 m_CurrentFrameIndex++;
@@ -157,49 +233,161 @@ u32 Macro::CalculateTargetFrame() {
 // 事件处理：启动宏
 void Macro::MacroStarting() {
     m_IsPlaying = true;
-    LoadMacroFile(m_Macros[m_CurrentMacroIndex].MacroFilePath);
+    // 相对路径位于宏目录下
+    const char* path = m_Macros[m_CurrentMacroIndex].path;
+    char filePath[160];
+    if (path[0] == '/' || strncmp(path, "sdmc:", 5) == 0) snprintf(filePath, sizeof(filePath), "%s", path);
+    else snprintf(filePath, sizeof(filePath), "%s%s", MACROS_DIR, path);
+    LoadMacroFile(filePath);
     m_CurrentFrameIndex = 0;
     m_AccumulatedMs = 0;
-    m_PlaybackStartTick = armGetSystemTick();
+    m_PlaybackStartTick = m_Now;
     m_HotkeyPressed = false;  // 重置状态，因为松开才触发
 }
 
-// 加载宏文件
+// 加载宏文件（帧数据读入宏内存池中的帧窗口）
+// 整个宏放不下时宏内存池分成两个帧窗口：播放一个窗口的同时在后台读入下一个，按键线程不等待读卡
 void Macro::LoadMacroFile(const char* filePath) {
-    m_Frames.clear();
-    m_FramesV2.clear();
+    CloseMacroFile();
+    mempool_reset(MEMPOOL_MACRO);
+    m_Buffers[0] = m_Buffers[1] = nullptr;
+    m_Current = 0;
+    m_FrameCount = 0;
+    m_WindowStart = 0;
+    m_WindowCount = 0;
+    m_WindowCapacity = 0;
     m_FrameRate = 0;
     m_Version = 1;
-    FILE* file = fopen(filePath, "rb");
-    if (!file) return;
+    // 直接使用 sdmc 文件系统会话读取（stdio 打开文件会分配堆内存）
+    FsFileSystem* fs = fsdevGetDeviceFileSystem("sdmc");
+    if (!fs) return;
+    if (strncmp(filePath, "sdmc:", 5) == 0) filePath += 5;
+    if (R_FAILED(fsFsOpenFile(fs, filePath, FsOpenMode_Read, &m_File))) return;
+    m_FileOpen = true;
     // 读取文件头
     MacroHeader header;
-    if (fread(&header, sizeof(MacroHeader), 1, file) != 1) {
-        fclose(file);
+    u64 bytesRead = 0;
+    if (R_FAILED(fsFileRead(&m_File, 0, &header, sizeof(MacroHeader), FsReadOption_None, &bytesRead)) || bytesRead != sizeof(MacroHeader)) {
+        CloseMacroFile();
         return;
     }
     // 验证文件头
     if (header.magic[0] != 'K' || header.magic[1] != 'E' || 
         header.magic[2] != 'Y' || header.magic[3] != 'X') {
-        fclose(file);
+        CloseMacroFile();
         return;
     }
     // 读取版本、帧率和帧数
     m_Version = header.version;
     m_FrameRate = header.frameRate;
-    if (header.frameCount > 0) {
-        switch (m_Version) {
-        case 1:
-            m_Frames.resize(header.frameCount);
-            if (fread(m_Frames.data(), sizeof(MacroFrame), header.frameCount, file) != header.frameCount) m_Frames.clear();
-            break;
-        default:
-            m_FramesV2.resize(header.frameCount);
-            if (fread(m_FramesV2.data(), sizeof(MacroFrameV2), header.frameCount, file) != header.frameCount) m_FramesV2.clear();
-            break;
+    if (header.frameCount == 0) {
+        CloseMacroFile();
+        return;
+    }
+    // 整个宏放得下时只用一个窗口，否则宏内存池平分为两个窗口
+    u32 poolCapacity = 0;
+    mempool_stats(MEMPOOL_MACRO, &poolCapacity, nullptr, nullptr, nullptr);
+    m_FrameSize = m_Version == 1 ? sizeof(MacroFrame) : sizeof(MacroFrameV2);
+    bool fits = header.frameCount <= poolCapacity / m_FrameSize;
+    m_WindowCapacity = fits ? header.frameCount : poolCapacity / 2 / m_FrameSize;
+    int bufferCount = fits ? 1 : 2;
+    for (int i = 0; i < bufferCount && m_WindowCapacity; i++) {
+        m_Buffers[i] = (u8*)mempool_alloc(MEMPOOL_MACRO, m_WindowCapacity * m_FrameSize);
+    }
+    if (!m_Buffers[0] || (!fits && !m_Buffers[1])) {
+        CloseMacroFile();
+        return;
+    }
+    m_FrameCount = header.frameCount;
+    if (!LoadWindow(0)) return;
+    // 整个宏都在窗口中，不再需要文件
+    if (fits) CloseMacroFile();
+    else PrefetchNext();
+}
+
+// 从第 index 帧开始直接读入一个帧窗口到当前缓冲区（读取失败时帧数清零，播放随即结束）
+bool Macro::LoadWindow(u32 index) {
+    if (!m_FileOpen || index >= m_FrameCount) return false;
+    if (m_NextPending) {
+        // 不再需要预读的窗口（例如循环播放回到开头），等它结束后再读
+        m_Reader.Wait();
+        m_NextPending = false;
+    }
+    u32 count = m_FrameCount - index < m_WindowCapacity ? m_FrameCount - index : m_WindowCapacity;
+    u64 size = (u64)count * m_FrameSize;
+    u64 bytesRead = 0;
+    m_WindowCount = 0;
+    if (R_FAILED(fsFileRead(&m_File, sizeof(MacroHeader) + (u64)index * m_FrameSize, m_Buffers[m_Current], size, FsReadOption_None, &bytesRead)) || bytesRead != size) {
+        m_FrameCount = 0;
+        CloseMacroFile();
+        return false;
+    }
+    m_WindowStart = index;
+    m_WindowCount = count;
+    return true;
+}
+
+// 在后台读入当前帧窗口之后的下一个窗口（循环播放时最后一个窗口之后是开头）
+void Macro::PrefetchNext() {
+    if (!m_FileOpen || !m_Buffers[1] || m_NextPending) return;
+    u32 next = m_WindowStart + m_WindowCount;
+    if (next >= m_FrameCount) {
+        if (!m_RepeatMode) return;
+        next = 0;
+    }
+    u32 count = m_FrameCount - next < m_WindowCapacity ? m_FrameCount - next : m_WindowCapacity;
+    if (!m_Reader.Submit(&m_File, sizeof(MacroHeader) + (u64)next * m_FrameSize, m_Buffers[1 - m_Current], (u64)count * m_FrameSize)) return;
+    m_NextStart = next;
+    m_NextCount = count;
+    m_NextPending = true;
+}
+
+// 取帧数据（index 在窗口之前时相减溢出，同样视为不在窗口内）
+const u8* Macro::FrameData(u32 index) {
+    if (index - m_WindowStart < m_WindowCount) return m_Buffers[m_Current] + (index - m_WindowStart) * m_FrameSize;
+    if (m_NextPending && index - m_NextStart < m_NextCount) {
+        // 切换到预读的窗口（通常在播放上一个窗口期间早已读完，读卡很慢时才需要等待）
+        m_NextPending = false;
+        if (m_Reader.Wait() != AsyncReader::State::Done) {
+            m_FrameCount = 0;
+            CloseMacroFile();
+            return nullptr;
         }
+        m_Current = 1 - m_Current;
+        m_WindowStart = m_NextStart;
+        m_WindowCount = m_NextCount;
+    } else if (!LoadWindow(index)) {
+        return nullptr;
+    }
+    PrefetchNext();
+    return m_Buffers[m_Current] + (index - m_WindowStart) * m_FrameSize;
+}
+
+// 关闭宏文件（后台读取可能还在写入帧窗口，先等它结束）
+void Macro::CloseMacroFile() {
+    if (m_NextPending) {
+        m_Reader.Wait();
+        m_NextPending = false;
     }
-    fclose(file);
+    if (!m_FileOpen) return;
+    fsFileClose(&m_File);
+    m_FileOpen = false;
+}
+
+// 停止播放并释放宏列表和帧数据
+void Macro::Unload() {
+    if (m_IsPlaying) MacroFinishing();
+    m_MacroCount = 0;
+    m_Macros = nullptr;
+    m_Buffers[0] = m_Buffers[1] = nullptr;
+    m_FrameCount = 0;
+    m_WindowCount = 0;
+    CloseMacroFile();
+    m_JustStopped = false;
+    m_HotkeyPressed = false;
+    m_CurrentMacroIndex = -1;
+    mempool_reset(MEMPOOL_CONFIG);
+    mempool_reset(MEMPOOL_MACRO);
 }
 
 // 事件处理：执行宏
@@ -210,19 +398,21 @@ void Macro::MacroExecuting(ProcessResult& result) {
     
     switch (m_Version) {
         case 1: {
-            if (m_CurrentFrameIndex >= m_Frames.size()) return;
-            const MacroFrame& frame = m_Frames[m_CurrentFrameIndex];
-            keysHeld = frame.keysHeld;
-            leftX = frame.leftX; leftY = frame.leftY;
-            rightX = frame.rightX; rightY = frame.rightY;
+            if (m_CurrentFrameIndex >= m_FrameCount) return;
+            const MacroFrame* frame = FrameAt(m_CurrentFrameIndex);
+            if (!frame) return;
+            keysHeld = frame->keysHeld;
+            leftX = frame->leftX; leftY = frame->leftY;
+            rightX = frame->rightX; rightY = frame->rightY;
             break;
         }
         default: {
-            if (m_CurrentFrameIndex >= m_FramesV2.size()) return;
-            const MacroFrameV2& frame = m_FramesV2[m_CurrentFrameIndex];
-            keysHeld = frame.keysHeld;
-            leftX = frame.leftX; leftY = frame.leftY;
-            rightX = frame.rightX; rightY = frame.rightY;
+            if (m_CurrentFrameIndex >= m_FrameCount) return;
+            const MacroFrameV2* frame = FrameV2At(m_CurrentFrameIndex);
+            if (!frame) return;
+            keysHeld = frame->keysHeld;
+            leftX = frame->leftX; leftY = frame->leftY;
+            rightX = frame->rightX; rightY = frame->rightY;
             break;
         }
     }
@@ -248,17 +438,29 @@ void Macro::MacroExecuting(ProcessResult& result) {
 
 }
 
+// 填充播放状态
+void Macro::FillStatus(KeyXStatus& status) const {
+    status.macroPlaying = m_IsPlaying;
+    if (!m_IsPlaying) return;
+    status.macroIndex = m_CurrentMacroIndex;
+    status.macroFrameIndex = m_CurrentFrameIndex;
+    status.macroFrameCount = m_FrameCount;
+}
+
 void Macro::MacroFinishing() {
     m_IsPlaying = false;
     m_CurrentFrameIndex = 0;
     m_AccumulatedMs = 0;
     m_PlaybackStartTick = 0;
     m_FrameRate = 0;
-    m_Frames.clear();
-    m_FramesV2.clear();
+    m_Buffers[0] = m_Buffers[1] = nullptr;
+    m_FrameCount = 0;
+    m_WindowCount = 0;
+    CloseMacroFile();
+    mempool_reset(MEMPOOL_MACRO);
     m_HotkeyPressTime = 0;
     m_RepeatMode = false;
-    m_LastFinishTime = armGetSystemTick();
+    m_LastFinishTime = m_Now;
     m_JustStopped = true;  // 标记刚停止，需要等待冷静期
     m_MacroHasStick = false;
     // 重置摇杆污染检测状态
@@ -278,7 +480,7 @@ void Macro::FilterStick(HidAnalogStickState& stick, HidAnalogStickState& last, u
     if (locked) {
         if (!same) {
             locked = false;
-            startTick = armGetSystemTick();
+            startTick = m_Now;
             last = stick;
             return;
         }
@@ -289,7 +491,7 @@ void Macro::FilterStick(HidAnalogStickState& stick, HidAnalogStickState& last, u
     
     // 检测到相同，归0并锁定
     if (same) {
-        if (armTicksToNs(armGetSystemTick() - startTick) > THRESHOLD_NS) {
+        if (armTicksToNs(m_Now - startTick) > THRESHOLD_NS) {
             locked = true;
             stick.x = 0;
             stick.y = 0;
@@ -299,6 +501,6 @@ void Macro::FilterStick(HidAnalogStickState& stick, HidAnalogStickState& last, u
     
     // 未污染，重置计时器
     last = stick;
-    startTick = armGetSystemTick();
+    startTick = m_Now;
 }
 
@@ -2,27 +2,53 @@
 
 #include <switch.h>
 #include "common.hpp"
-#include <vector>
+#include "ipc.hpp"
+#include "asyncread.hpp"
 
 class Macro {
 public:
+    Macro() = default;
     Macro(const char* macroCfgPath);
+    ~Macro();
     
     // 加载配置
     void LoadConfig(const char* macroCfgPath);
     
+    // 停止播放并释放宏列表和帧数据（关闭宏功能时）
+    void Unload();
+    
     // 核心函数：处理输入，填充处理结果（事件+按键数据）
     void Process(ProcessResult& result);
     
     // 宏结束清理工作
     void MacroFinishing();                    
+    
+    // 是否正在播放
+    bool IsPlaying() const { return m_IsPlaying; }
+    
+    // 启动帧窗口读取线程（没有启动时播放中的帧窗口在按键线程中直接读取）
+    bool StartReader(const ThreadSetting& setting) { return m_Reader.Start(setting); }
+    
+    // 填充播放状态（状态查询用）
+    void FillStatus(KeyXStatus& status) const;
 
 private:
 
+    // 快捷键绑定表文件头（后跟 count 个 MacroEntry，由插件写入）
+    struct BindingHeader {
+        char magic[4];      // "KXMB"
+        u16 version;        // 绑定表格式版本
+        u16 count;          // 绑定数量
+    } __attribute__((packed));
+
+    // 快捷键绑定（与绑定表记录格式一致，整表一次读入）
     struct MacroEntry {
-        char MacroFilePath[128];    // 宏文件路径
-        u64 combo;                 // 快捷键组合
-    };
+        u32 pathHash;               // 宏路径哈希（插件查找用）
+        u16 flags;                  // 标志位（保留）
+        u16 reserved;
+        u64 combo;                  // 快捷键组合
+        char path[120];             // 相对宏目录的路径，不在宏目录下时为完整路径
+    } __attribute__((packed));
 
     // 宏文件头
     struct MacroHeader {
@@ -53,15 +79,27 @@ private:
         s32 rightY;         // 右摇杆Y
     } __attribute__((packed));
 
-    std::vector<MacroEntry> m_Macros{};     // 宏列表
+    MacroEntry* m_Macros = nullptr;         // 宏列表（配置内存池）
+    int m_MacroCount = 0;                   // 宏数量
     bool m_IsPlaying = false;               // 是否正在播放
     int m_CurrentMacroIndex = -1;           // 当前播放的宏索引
     u32 m_CurrentFrameIndex = 0;            // 当前播放的帧索引
     u64 m_PlaybackStartTick = 0;            // 播放开始时间
     u16 m_FrameRate = 0;                    // 宏帧率
     u16 m_Version = 1;                      // 宏版本
-    std::vector<MacroFrame> m_Frames{};     // V1 宏帧数据
-    std::vector<MacroFrameV2> m_FramesV2{}; // V2 宏帧数据
+    u32 m_FrameCount = 0;                   // 宏文件总帧数
+    u32 m_FrameSize = 0;                    // 单帧大小（V1/V2）
+    u8* m_Buffers[2] = {};                  // 帧窗口缓冲区（宏内存池；整个宏放得下时只用第一个）
+    int m_Current = 0;                      // 正在播放的帧窗口所在的缓冲区
+    u32 m_WindowStart = 0;                  // 帧窗口中第一帧的序号
+    u32 m_WindowCount = 0;                  // 帧窗口中已读入的帧数
+    u32 m_WindowCapacity = 0;               // 每个帧窗口最多容纳的帧数
+    u32 m_NextStart = 0;                    // 预读的下一个帧窗口（在另一个缓冲区中）
+    u32 m_NextCount = 0;
+    bool m_NextPending = false;             // 已提交下一个帧窗口的读取
+    FsFile m_File;                          // 宏文件（帧数超出窗口时播放中保持打开，按窗口读入）
+    bool m_FileOpen = false;
+    AsyncReader m_Reader;                   // 帧窗口读取线程
     bool m_HotkeyPressed = false;           // 上一次快捷键状态
     u64 m_HotkeyPressTime = 0;              // 快捷键按下时间
     bool m_RepeatMode = false;              // 循环播放标志
@@ -69,6 +107,7 @@ private:
     bool m_JustStopped = false;             // 刚停止，等待冷静期
     u64 m_AccumulatedMs = 0;                // V2 播放累加时间
     bool m_MacroHasStick = false;           // 当前宏是否包含摇杆操作
+    u64 m_Now = 0;                          // 本次循环的系统tick
 
     // 摇杆污染检测
     HidAnalogStickState m_LastStickL = {};
@@ -83,9 +122,17 @@ private:
     FeatureEvent HandleStopCooldown(u64 buttons);     // 处理停止后冷静期
     FeatureEvent HandleNormalTrigger(u64 buttons);    // 处理正常触发检测
     int CheckHotkeyTriggered(u64 buttons);            // 检查快捷键触发
+    bool LoadBindingTable(const char* macroCfgPath);  // 读取绑定表（没有绑定表时返回false）
+    void LoadLegacyConfig(const char* macroCfgPath);  // 读取游戏配置中的旧版绑定（插件尚未迁移时）
     u32 CalculateTargetFrame();                       // 计算当前应该播放第几帧
     void MacroStarting();                             // 宏启动
-    void LoadMacroFile(const char* filePath);         // 加载宏文件
+    void LoadMacroFile(const char* filePath);         // 加载宏文件（不经过 stdio，不分配堆内存）
+    bool LoadWindow(u32 index);                       // 从第 index 帧开始直接读入一个帧窗口（失败时结束播放）
+    void PrefetchNext();                              // 在后台读入当前帧窗口之后的下一个窗口
+    const u8* FrameData(u32 index);                   // 取帧数据（不在当前窗口内时切换到预读的窗口或直接读入）
+    const MacroFrame* FrameAt(u32 index) { return (const MacroFrame*)FrameData(index); }        // 取V1帧
+    const MacroFrameV2* FrameV2At(u32 index) { return (const MacroFrameV2*)FrameData(index); }  // 取V2帧
+    void CloseMacroFile();                            // 关闭宏文件（先等后台读取结束）
     void MacroExecuting(ProcessResult& result);       // 宏执行
     void FilterStick(HidAnalogStickState& stick, HidAnalogStickState& last, u64& startTick, bool& locked);  // 摇杆污染过滤
     
@@ -0,0 +1,121 @@
+#include "softremap.hpp"
+#include <minIni.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// 构造函数
+SoftRemap::SoftRemap(const char* config_path) {
+    LoadConfig(config_path);
+}
+
+// 加载配置
+// [SOFTMAP] ruleCount=N，rule_src_N / rule_dst_N 为十进制按键掩码
+// 低16位为按键（HidNpadButton），16-23位为摇杆方向（HidNpadButton_StickL* / StickR*）
+void SoftRemap::LoadConfig(const char* config_path) {
+    u32 sources[MAX_RULES];
+    u32 targets[MAX_RULES];
+    int count = 0;
+    int ruleCount = ini_getl("SOFTMAP", "ruleCount", 0, config_path);
+    for (int i = 1; i <= ruleCount && count < MAX_RULES; i++) {
+        char key[32];
+        char value[32];
+        sprintf(key, "rule_src_%d", i);
+        ini_gets("SOFTMAP", key, "0", value, sizeof(value), config_path);
+        u32 source = (u32)strtoull(value, nullptr, 10) & (BUTTON_BITS | STICK_L_BITS | STICK_R_BITS);
+        sprintf(key, "rule_dst_%d", i);
+        ini_gets("SOFTMAP", key, "0", value, sizeof(value), config_path);
+        u32 target = (u32)strtoull(value, nullptr, 10) & (BUTTON_BITS | STICK_L_BITS | STICK_R_BITS);
+        if (source == 0 || target == 0 || source == target) continue;
+        sources[count] = source;
+        targets[count] = target;
+        count++;
+    }
+    Compile(sources, targets, count);
+}
+
+// 编译规则为查找表
+void SoftRemap::Compile(const u32* sources, const u32* targets, int count) {
+    m_RuleCount = count;
+    memset(m_MatchLut, 0, sizeof(m_MatchLut));
+    memset(m_TargetLut, 0, sizeof(m_TargetLut));
+    memset(m_SourceLut, 0, sizeof(m_SourceLut));
+    
+    // 规则 r 在切片 k 的值 v 上满足条件：该规则在切片 k 上需要的位都包含在 v 中
+    // 三个切片的结果相与，即为整个输入上满足条件的规则
+    for (int k = 0; k < INPUT_SLICES; k++) {
+        for (u32 v = 0; v < 256; v++) {
+            u32 rules = 0;
+            for (int r = 0; r < count; r++) {
+                u32 need = (sources[r] >> (k * 8)) & 0xFF;
+                if ((need & ~v) == 0) rules |= (1u << r);
+            }
+            m_MatchLut[k][v] = rules;
+        }
+    }
+    
+    // 规则集合 → 目标位 / 源位
+    for (int k = 0; k < RULE_SLICES; k++) {
+        for (u32 v = 0; v < 256; v++) {
+            u32 target = 0, source = 0;
+            for (int b = 0; b < 8; b++) {
+                int r = k * 8 + b;
+                if (r >= count || !(v & (1u << b))) continue;
+                target |= targets[r];
+                source |= sources[r];
+            }
+            m_TargetLut[k][v] = target;
+            m_SourceLut[k][v] = source;
+        }
+    }
+}
+
+// 摇杆状态 → 方向位（左、上、右、下）
+u32 SoftRemap::StickToBits(const HidAnalogStickState& stick, int shift) {
+    u32 bits = 0;
+    if (stick.x <= -STICK_THRESHOLD) bits |= 1u << 0;
+    if (stick.y >= STICK_THRESHOLD) bits |= 1u << 1;
+    if (stick.x >= STICK_THRESHOLD) bits |= 1u << 2;
+    if (stick.y <= -STICK_THRESHOLD) bits |= 1u << 3;
+    return bits << shift;
+}
+
+// 方向位 → 摇杆满偏移
+void SoftRemap::BitsToStick(u32 bits, int shift, HidAnalogStickState& stick) {
+    bits >>= shift;
+    stick.x = 0;
+    stick.y = 0;
+    if (bits & (1u << 0)) stick.x -= STICK_MAX;
+    if (bits & (1u << 1)) stick.y += STICK_MAX;
+    if (bits & (1u << 2)) stick.x += STICK_MAX;
+    if (bits & (1u << 3)) stick.y -= STICK_MAX;
+}
+
+// 核心函数：按规则改写输入
+bool SoftRemap::Process(ProcessResult& result) const {
+    if (m_RuleCount == 0) return false;
+    
+    u32 input = ((u32)result.buttons & BUTTON_BITS) |
+                StickToBits(result.analog_stick_l, 16) |
+                StickToBits(result.analog_stick_r, 20);
+    
+    // 三次查表得到满足条件的规则集合
+    u32 rules = m_MatchLut[0][input & 0xFF] &
+                m_MatchLut[1][(input >> 8) & 0xFF] &
+                m_MatchLut[2][(input >> 16) & 0xFF];
+    if (rules == 0) return false;
+    
+    // 四次查表得到输出位和被消耗的源位
+    u32 target = m_TargetLut[0][rules & 0xFF] | m_TargetLut[1][(rules >> 8) & 0xFF] |
+                 m_TargetLut[2][(rules >> 16) & 0xFF] | m_TargetLut[3][rules >> 24];
+    u32 source = m_SourceLut[0][rules & 0xFF] | m_SourceLut[1][(rules >> 8) & 0xFF] |
+                 m_SourceLut[2][(rules >> 16) & 0xFF] | m_SourceLut[3][rules >> 24];
+    u32 output = (input & ~source) | target;
+    
+    result.buttons = (result.buttons & ~(u64)BUTTON_BITS) | (output & BUTTON_BITS);
+    
+    // 只有涉及到的摇杆才改写，未涉及的保持物理输入
+    if ((source | target) & STICK_L_BITS) BitsToStick(output & STICK_L_BITS, 16, result.analog_stick_l);
+    if ((source | target) & STICK_R_BITS) BitsToStick(output & STICK_R_BITS, 20, result.analog_stick_r);
+    return true;
+}
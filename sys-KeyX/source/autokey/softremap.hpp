@@ -0,0 +1,44 @@
+#pragma once
+
+#include <switch.h>
+#include "common.hpp"
+
+// 软件映射（在按键线程中按规则改写输入，支持多对多映射）
+// 规则类型：组合键 → 按键、按键 → 组合键、摇杆方向 → 按键、按键 → 摇杆方向
+// 规则在加载时编译为按8位切片的查找表，每次处理的耗时与规则数量无关
+class SoftRemap {
+public:
+    SoftRemap() = default;
+    SoftRemap(const char* config_path);
+    
+    // 加载配置并编译查找表
+    void LoadConfig(const char* config_path);
+    
+    // 是否没有任何有效规则
+    bool IsEmpty() const { return m_RuleCount == 0; }
+    
+    // 核心函数：按规则改写 result.buttons 和摇杆，返回是否有规则生效
+    bool Process(ProcessResult& result) const;
+
+private:
+    static constexpr int MAX_RULES = 32;                // 最多32条规则（规则集合用u32表示）
+    static constexpr int INPUT_SLICES = 3;              // 输入24位（16按键 + 8摇杆方向），每8位一个切片
+    static constexpr int RULE_SLICES = 4;               // 规则集合32位，每8位一个切片
+    static constexpr u32 BUTTON_BITS = 0xFFFF;          // 按键位
+    static constexpr u32 STICK_L_BITS = 0x0F0000;       // 左摇杆方向位（与 HidNpadButton_StickL* 一致）
+    static constexpr u32 STICK_R_BITS = 0xF00000;       // 右摇杆方向位（与 HidNpadButton_StickR* 一致）
+    static constexpr s32 STICK_THRESHOLD = 0x4000;      // 摇杆方向判定阈值（约50%）
+    static constexpr s32 STICK_MAX = 0x7FFF;            // 摇杆满偏移
+
+    u32 m_MatchLut[INPUT_SLICES][256];  // 输入切片值 → 该切片上满足条件的规则集合
+    u32 m_TargetLut[RULE_SLICES][256];  // 规则集合切片 → 输出的目标位
+    u32 m_SourceLut[RULE_SLICES][256];  // 规则集合切片 → 被消耗的源位
+    int m_RuleCount = 0;
+
+    // 编译规则为查找表
+    void Compile(const u32* sources, const u32* targets, int count);
+    
+    // 摇杆状态 ↔ 方向位
+    static u32 StickToBits(const HidAnalogStickState& stick, int shift);
+    static void BitsToStick(u32 bits, int shift, HidAnalogStickState& stick);
+};
@@ -18,8 +18,8 @@ namespace {
 }
 
 
-// 构造函数
-Turbo::Turbo(const char* config_path) {
+// 构造函数（默认参数，未加载配置）
+Turbo::Turbo() {
     m_ButtonMask = 0;
     m_PressDurationNs = 100 * 1000000ULL;   // 默认100ms
     m_ReleaseDurationNs = 100 * 1000000ULL; // 默认100ms
@@ -27,6 +27,11 @@ Turbo::Turbo(const char* config_path) {
     m_IsPressed = false;
     m_TurboStartTime = 0;
     m_InitialPressTime = 0;
+    m_DelayStart = true;
+}
+
+// 构造函数
+Turbo::Turbo(const char* config_path) : Turbo() {
     // 自动加载配置
     LoadConfig(config_path);
 }
@@ -61,6 +66,7 @@ void Turbo::Process(ProcessResult& result, bool isJoyCon) {
     // 分类按键
     u64 autokey_buttons = result.buttons & jcWhitelistMask;
     u64 normal_buttons = result.buttons & ~jcWhitelistMask;
+    m_Now = result.tick;
     result.event = DetermineEvent(autokey_buttons);
     switch (result.event) {
         case FeatureEvent::IDLE:
@@ -88,8 +94,8 @@ FeatureEvent Turbo::DetermineEvent(u64 autokey_buttons) {
     if (turbo_active && CheckRelease(autokey_buttons)) return FeatureEvent::FINISHING;
     else if (turbo_active) return FeatureEvent::Turbo_EXECUTING;
     else if (has_autokey) {
-        if (m_InitialPressTime == 0) m_InitialPressTime = armGetSystemTick();
-        u64 elapsed_ns = armTicksToNs(armGetSystemTick() - m_InitialPressTime);
+        if (m_InitialPressTime == 0) m_InitialPressTime = m_Now;
+        u64 elapsed_ns = armTicksToNs(m_Now - m_InitialPressTime);
         if (m_DelayStart && elapsed_ns < 200000000ULL) return FeatureEvent::IDLE;
         m_InitialPressTime = 0;
         return FeatureEvent::STARTING;
@@ -102,13 +108,13 @@ FeatureEvent Turbo::DetermineEvent(u64 autokey_buttons) {
 void Turbo::TurboStarting() {
     m_IsActive = true;
     m_IsPressed = true;
-    m_TurboStartTime = armGetSystemTick();
+    m_TurboStartTime = m_Now;
 }
 
 // 事件处理：连发运行
 void Turbo::TurboExecuting(u64 autokey_buttons, u64 normal_buttons, ProcessResult& result) {
     // 用绝对时间计算当前应该是按下还是松开
-    u64 elapsed_ns = armTicksToNs(armGetSystemTick() - m_TurboStartTime);
+    u64 elapsed_ns = armTicksToNs(m_Now - m_TurboStartTime);
     u64 cycle_ns = m_PressDurationNs + m_ReleaseDurationNs;
     u64 pos_in_cycle = elapsed_ns % cycle_ns;
     m_IsPressed = (pos_in_cycle < m_PressDurationNs);
@@ -127,7 +133,7 @@ void Turbo::TurboFinishing() {
 bool Turbo::CheckRelease(u64 autokey_buttons) {
     if (!m_IsPressed) return false;
     // 用绝对时间计算当前周期内的位置
-    u64 elapsed_ns = armTicksToNs(armGetSystemTick() - m_TurboStartTime);
+    u64 elapsed_ns = armTicksToNs(m_Now - m_TurboStartTime);
     u64 cycle_ns = m_PressDurationNs + m_ReleaseDurationNs;
     u64 pos_in_cycle = elapsed_ns % cycle_ns;
     // 按下周期开始后30ms内不检测松开
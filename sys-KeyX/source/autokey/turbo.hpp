@@ -5,6 +5,7 @@
 
 class Turbo {
 public:
+    Turbo();
     Turbo(const char* config_path);
     
     // 加载配置
@@ -18,6 +19,10 @@ public:
 
     // 获取只允许左边还是右边的手柄联发
     bool IsJCRightHand();
+    
+    // 运行状态查询（状态查询用）
+    bool IsActive() const { return m_IsActive; }
+    bool IsPressed() const { return m_IsPressed; }
 
 private:
 
@@ -33,6 +38,7 @@ private:
     u64 m_TurboStartTime;       // 连发开始时间
     u64 m_InitialPressTime;     // 首次按下时间（用于200ms延迟）
     bool m_DelayStart;          // 是否启用延迟启动
+    u64 m_Now = 0;              // 本次循环的系统tick
     
     // 事件判定
     FeatureEvent DetermineEvent(u64 autokey_buttons);
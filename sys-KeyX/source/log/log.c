@@ -5,6 +5,8 @@
 #include <string.h>
 #include <time.h>
 #include <switch.h>
+#include <stdatomic.h>
+#include "mempool.h"
 
 // 日志系统全局变量
 static Mutex log_mutex = 0;                                    // 日志互斥锁，确保多线程安全
@@ -12,19 +14,12 @@ static Mutex log_mutex = 0;                                    // 日志互斥
 static FILE *log_file = NULL;                                  // 日志文件句柄
 static bool g_log_enabled = true;                                  // 日志全局开关（默认开启）
 
-// 获取计时器时间字符串（从程序启动开始计时）
-static char *cur_time() {
-    static u64 start_time = 0;                                  // 程序启动时间
-    static char timebuf[64];
-    
-    // 第一次调用时记录启动时间
-    if (start_time == 0) {
-        start_time = armGetSystemTick();
-    }
-    
-    // 计算从启动到现在的时间差（纳秒）
-    u64 current_time = armGetSystemTick();
-    u64 elapsed_ns = armTicksToNs(current_time - start_time);
+static u64 g_start_tick = 0;                                    // 程序启动时间（第一次记录日志时）
+
+// 将系统tick格式化为计时器时间字符串（从程序启动开始计时）
+static void format_tick(u64 tick, char *buf, size_t size) {
+    // 计算从启动到该时刻的时间差（纳秒）
+    u64 elapsed_ns = tick > g_start_tick ? armTicksToNs(tick - g_start_tick) : 0;
     
     // 转换为毫秒、秒、分钟
     u64 elapsed_ms = elapsed_ns / 1000000;                      // 纳秒转毫秒
@@ -34,13 +29,33 @@ static char *cur_time() {
     u64 minutes = (total_seconds / 60) % 60;                    // 剩余分钟
     
     // 格式化为 "MM:SS:mmm" 格式
-    snprintf(timebuf, sizeof(timebuf), "[%02lu:%02lu:%03lu]",
+    snprintf(buf, size, "[%02lu:%02lu:%03lu]",
              (unsigned long)minutes,                            // 分钟
              (unsigned long)seconds,                            // 秒数
              (unsigned long)ms);                                // 毫秒
+}
+
+// 获取计时器时间字符串（从程序启动开始计时）
+static char *cur_time() {
+    static char timebuf[64];
+    
+    // 第一次调用时记录启动时间
+    if (g_start_tick == 0) {
+        g_start_tick = armGetSystemTick();
+    }
+    
+    format_tick(armGetSystemTick(), timebuf, sizeof(timebuf));
     return timebuf;
 }
 
+// 打开日志文件（调用前必须持有 log_mutex）
+static bool open_log_file() {
+    if (!log_file) {
+        log_file = fopen(LOG_FILE_PATH, "w");                   // 以写入模式打开日志文件，程序重启时重置内容
+    }
+    return log_file != NULL;
+}
+
 // 设置日志开关（0=关闭，1=开启）
 void log_set_enabled(bool enabled) {
     g_log_enabled = enabled;
@@ -52,12 +67,9 @@ static void log_write(const char *level, const char *file, int line, const char
     if (!g_log_enabled) return;
     
     mutexLock(&log_mutex);                                      // 加锁，确保线程安全
-    if (!log_file) {
-        log_file = fopen(LOG_FILE_PATH, "w");                   // 以写入模式打开日志文件，程序重启时重置内容
-        if (!log_file) {
-            mutexUnlock(&log_mutex);                            // 打开失败则解锁并返回
-            return;
-        }
+    if (!open_log_file()) {
+        mutexUnlock(&log_mutex);                                // 打开失败则解锁并返回
+        return;
     }
     // 只打印文件名最后20个字符，避免路径过长
     const char *short_file = file;
@@ -103,4 +115,180 @@ void log_debug_impl(const char *file, int line, const char *fmt, ...) {
     va_start(args, fmt);
     log_write("DEBUG", file, line, fmt, args);
     va_end(args);
-}
\ No newline at end of file
+}
+
+// ---------------------------------------------------------------------------
+// 二进制事件环形缓冲区
+// 多生产者单消费者的有界队列：每个槽位带序号，生产者通过 CAS 抢占写入位置，
+// 写完后发布序号；刷新线程按顺序读取已发布的槽位
+// ---------------------------------------------------------------------------
+
+#define LOG_RING_SIZE       512                                 // 记录数（必须是2的幂）
+#define LOG_FLUSH_INTERVAL  100000000ULL                        // 100ms 刷新一次
+#define LOG_FLUSH_PRIORITY  0x3F                                // 最低优先级，不与按键线程竞争
+#define LOG_FLUSH_BUF_SIZE  2048                                // 格式化输出缓冲区大小
+
+// 定长事件记录
+typedef struct {
+    _Atomic u32 seq;                                            // 槽位序号（用于生产者/消费者同步）
+    u32 event_id;                                               // 事件ID
+    u64 tick;                                                   // 系统tick
+    u64 arg1;
+    u64 arg2;
+    u32 arg0;
+} LogRecord;
+
+static LogRecord *g_ring = NULL;                                // 环形缓冲区（从日志内存池分配）
+static _Atomic u32 g_ring_head = 0;                             // 下一个写入位置（生产者）
+static u32 g_ring_tail = 0;                                     // 下一个读取位置（刷新线程）
+static _Atomic u32 g_ring_dropped = 0;                          // 丢弃的记录数
+static _Atomic bool g_ring_enabled = false;                     // 事件记录开关
+
+static Thread g_flush_thread;                                   // 刷新线程
+static volatile bool g_flush_exit = false;                      // 刷新线程退出标志
+static char g_flush_stack[8 * 1024] __attribute__((aligned(0x1000)));   // 刷新线程栈
+static char *g_flush_buf = NULL;                                // 格式化输出缓冲区（从日志内存池分配）
+
+// 写入一条事件记录
+void log_event(u32 event_id, u32 arg0, u64 arg1, u64 arg2) {
+    if (!atomic_load_explicit(&g_ring_enabled, memory_order_relaxed)) return;
+    
+    u32 pos = atomic_load_explicit(&g_ring_head, memory_order_relaxed);
+    LogRecord *rec;
+    for (;;) {
+        rec = &g_ring[pos & (LOG_RING_SIZE - 1)];
+        u32 seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+        s32 diff = (s32)(seq - pos);
+        if (diff == 0) {
+            // 槽位空闲，抢占写入位置
+            if (atomic_compare_exchange_weak_explicit(&g_ring_head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // 缓冲区已满（刷新线程未跟上），丢弃
+            atomic_fetch_add_explicit(&g_ring_dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            // 其他生产者已抢占该位置
+            pos = atomic_load_explicit(&g_ring_head, memory_order_relaxed);
+        }
+    }
+    
+    rec->tick = armGetSystemTick();
+    rec->event_id = event_id;
+    rec->arg0 = arg0;
+    rec->arg1 = arg1;
+    rec->arg2 = arg2;
+    atomic_store_explicit(&rec->seq, pos + 1, memory_order_release);   // 发布记录
+}
+
+// 获取丢弃的记录数
+u32 log_ring_dropped(void) {
+    return atomic_load_explicit(&g_ring_dropped, memory_order_relaxed);
+}
+
+// 将缓冲区写入文件
+static void flush_write(size_t len) {
+    if (len == 0) return;
+    mutexLock(&log_mutex);
+    if (open_log_file()) fwrite(g_flush_buf, 1, len, log_file);
+    mutexUnlock(&log_mutex);
+}
+
+// 读取所有已发布的记录，批量格式化后写入文件
+static void flush_ring(void) {
+    static u32 reported_dropped = 0;
+    char timebuf[32];
+    size_t len = 0;
+    
+    for (;;) {
+        LogRecord *rec = &g_ring[g_ring_tail & (LOG_RING_SIZE - 1)];
+        u32 seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+        if (seq != g_ring_tail + 1) break;                      // 没有更多已发布的记录
+        
+        // 剩余空间不足一行时先写出
+        if (LOG_FLUSH_BUF_SIZE - len < 128) {
+            flush_write(len);
+            len = 0;
+        }
+        format_tick(rec->tick, timebuf, sizeof(timebuf));
+        len += snprintf(g_flush_buf + len, LOG_FLUSH_BUF_SIZE - len, "%s [EVT] %u %u 0x%lx 0x%lx\n",
+                        timebuf, rec->event_id, rec->arg0, (unsigned long)rec->arg1, (unsigned long)rec->arg2);
+        
+        // 释放槽位给下一轮生产者
+        atomic_store_explicit(&rec->seq, g_ring_tail + LOG_RING_SIZE, memory_order_release);
+        g_ring_tail++;
+    }
+    
+    // 报告新增的丢弃数量
+    u32 dropped = log_ring_dropped();
+    if (dropped != reported_dropped) {
+        if (LOG_FLUSH_BUF_SIZE - len < 128) {
+            flush_write(len);
+            len = 0;
+        }
+        len += snprintf(g_flush_buf + len, LOG_FLUSH_BUF_SIZE - len, "%s [RING] dropped %u records\n",
+                        cur_time(), dropped - reported_dropped);
+        reported_dropped = dropped;
+    }
+    
+    flush_write(len);
+    if (len) {
+        mutexLock(&log_mutex);
+        if (log_file) fflush(log_file);
+        mutexUnlock(&log_mutex);
+    }
+}
+
+// 刷新线程
+static void flush_thread_func(void *arg) {
+    (void)arg;
+    while (!g_flush_exit) {
+        flush_ring();
+        svcSleepThread(LOG_FLUSH_INTERVAL);
+    }
+    flush_ring();
+}
+
+// 启动刷新线程并开启事件记录
+bool log_ring_start(void) {
+    if (atomic_load(&g_ring_enabled)) return true;
+    
+    // 缓冲区只在开启事件记录时分配，未开启时不占用内存
+    if (!g_ring) {
+        mempool_reset(MEMPOOL_LOG);
+        g_ring = (LogRecord *)mempool_alloc(MEMPOOL_LOG, sizeof(LogRecord) * LOG_RING_SIZE);
+        g_flush_buf = (char *)mempool_alloc(MEMPOOL_LOG, LOG_FLUSH_BUF_SIZE);
+        if (!g_ring || !g_flush_buf) {
+            g_ring = NULL;
+            g_flush_buf = NULL;
+            return false;
+        }
+    }
+    
+    // 初始化槽位序号
+    for (u32 i = 0; i < LOG_RING_SIZE; i++) atomic_store(&g_ring[i].seq, i);
+    atomic_store(&g_ring_head, 0);
+    g_ring_tail = 0;
+    if (g_start_tick == 0) g_start_tick = armGetSystemTick();
+    
+    g_flush_exit = false;
+    Result rc = threadCreate(&g_flush_thread, flush_thread_func, NULL,
+                             g_flush_stack, sizeof(g_flush_stack), LOG_FLUSH_PRIORITY, -2);
+    if (R_FAILED(rc)) return false;
+    rc = threadStart(&g_flush_thread);
+    if (R_FAILED(rc)) {
+        threadClose(&g_flush_thread);
+        return false;
+    }
+    atomic_store(&g_ring_enabled, true);
+    return true;
+}
+
+// 停止刷新线程
+void log_ring_stop(void) {
+    if (!atomic_load(&g_ring_enabled)) return;
+    atomic_store(&g_ring_enabled, false);
+    g_flush_exit = true;
+    threadWaitForExit(&g_flush_thread);
+    threadClose(&g_flush_thread);
+}
@@ -1,4 +1,5 @@
-
+#pragma once
+#include <switch.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +18,33 @@ void log_set_enabled(bool enabled);
 #define log_error(fmt, ...)   log_error_impl(__FILE__, __LINE__, fmt, ##__VA_ARGS__)
 #define log_debug(fmt, ...)   log_debug_impl(__FILE__, __LINE__, fmt, ##__VA_ARGS__)
 
+// ---------------------------------------------------------------------------
+// 二进制事件环形缓冲区（热路径专用）
+// log_event 只写入定长记录，不加锁、不格式化、不做文件IO
+// 由低优先级的刷新线程批量格式化后追加到日志文件
+// ---------------------------------------------------------------------------
+
+// 事件ID
+enum {
+    LOG_EVT_TICK        = 1,    // 按键线程循环：arg0=事件, arg1=物理按键, arg2=注入按键
+    LOG_EVT_CONTROLLER  = 2,    // 手柄类型变化：arg0=新类型
+    LOG_EVT_FOCUS       = 3,    // 焦点变化：arg0=状态, arg1=TID
+    LOG_EVT_GAME        = 4,    // 游戏启动/退出：arg0=事件, arg1=TID
+    LOG_EVT_ALLOC       = 5,    // 按键线程堆分配（调试）：arg0=累计次数, arg1=大小, arg2=调用地址
+};
+
+// 启动刷新线程并开启事件记录
+bool log_ring_start(void);
+
+// 停止刷新线程（会先写完剩余记录）
+void log_ring_stop(void);
+
+// 写入一条事件记录（多线程安全，无锁；缓冲区满时丢弃并计数）
+void log_event(u32 event_id, u32 arg0, u64 arg1, u64 arg2);
+
+// 因缓冲区满而丢弃的记录数
+u32 log_ring_dropped(void);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
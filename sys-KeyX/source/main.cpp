@@ -13,8 +13,14 @@ extern "C" {
 // 内部堆的大小（根据需要调整）62KB
 // #define INNER_HEAP_SIZE 0xF800
 
-// 内部堆的大小（根据需要调整）256KB
-#define INNER_HEAP_SIZE 0x40000
+// 内部堆的大小（根据需要调整）64KB
+// 宏帧数据、配置和日志缓冲区已改为各自的固定内存池（见 mempool.c），线程栈都是静态数组，
+// 堆上最大的是按键模块对象（约16KB，大部分是软件映射和逆映射的查找表，同一时间只有一个），
+// 其余是IPC服务对象、回调和少量字符串；实际用量可以用 CMD_QUERY_MEMORY 查询
+#define INNER_HEAP_SIZE 0x10000
+
+// 按键模块对象变大时至少保留与它同样大小的余量
+static_assert(sizeof(AutoKeyLoop) * 2 <= INNER_HEAP_SIZE, "INNER_HEAP_SIZE 不足以容纳按键模块对象");
 
 // 系统模块不应使用applet相关功能
 u32 __nx_applet_type = AppletType_None;
@@ -1,44 +1,82 @@
 #include "remapper.hpp"
+#include <cstdio>
 #include <cstring>
 #include "minIni.h"
 
 // 映射状态标志
 static bool s_MappingEnabled = false;
 
-// 按键名称表（用于配置读取）
-static constexpr const char* BUTTON_NAMES[] = {
-    "A", "B", "X", "Y",
-    "Up", "Down", "Left", "Right",
-    "L", "R", "ZL", "ZR",
-    "StickL", "StickR", "Start", "Select"
-};
-
 // 按键信息（通用）
 struct ButtonInfo {
     const char* name;
     HidcfgDigitalButtonAssignment value;
 };
 
-// 统一的按键表
+// 统一的按键表（顺序即配置读取顺序，也是下面各成员指针表的下标）
 static constexpr ButtonInfo BUTTONS[] = {
     {"A",      HidcfgDigitalButtonAssignment_A},
     {"B",      HidcfgDigitalButtonAssignment_B},
     {"X",      HidcfgDigitalButtonAssignment_X},
     {"Y",      HidcfgDigitalButtonAssignment_Y},
-    {"StickL", HidcfgDigitalButtonAssignment_StickL},
-    {"StickR", HidcfgDigitalButtonAssignment_StickR},
+    {"Up",     HidcfgDigitalButtonAssignment_Up},
+    {"Down",   HidcfgDigitalButtonAssignment_Down},
+    {"Left",   HidcfgDigitalButtonAssignment_Left},
+    {"Right",  HidcfgDigitalButtonAssignment_Right},
     {"L",      HidcfgDigitalButtonAssignment_L},
     {"R",      HidcfgDigitalButtonAssignment_R},
     {"ZL",     HidcfgDigitalButtonAssignment_ZL},
     {"ZR",     HidcfgDigitalButtonAssignment_ZR},
-    {"Select", HidcfgDigitalButtonAssignment_Select},
+    {"StickL", HidcfgDigitalButtonAssignment_StickL},
+    {"StickR", HidcfgDigitalButtonAssignment_StickR},
     {"Start",  HidcfgDigitalButtonAssignment_Start},
-    {"Left",   HidcfgDigitalButtonAssignment_Left},
-    {"Up",     HidcfgDigitalButtonAssignment_Up},
-    {"Right",  HidcfgDigitalButtonAssignment_Right},
-    {"Down",   HidcfgDigitalButtonAssignment_Down},
+    {"Select", HidcfgDigitalButtonAssignment_Select},
 };
 
+// 完整手柄（Embedded / Full）的成员指针表，与 BUTTONS 顺序一致
+#define FULL_BUTTON_MEMBERS(T) { \
+    &T::hardware_button_a,      &T::hardware_button_b, \
+    &T::hardware_button_x,      &T::hardware_button_y, \
+    &T::hardware_button_up,     &T::hardware_button_down, \
+    &T::hardware_button_left,   &T::hardware_button_right, \
+    &T::hardware_button_l,      &T::hardware_button_r, \
+    &T::hardware_button_zl,     &T::hardware_button_zr, \
+    &T::hardware_button_stick_l, &T::hardware_button_stick_r, \
+    &T::hardware_button_start,  &T::hardware_button_select, \
+}
+
+static constexpr HidcfgDigitalButtonAssignment HidcfgButtonConfigEmbedded::* EMBEDDED_MEMBERS[] = FULL_BUTTON_MEMBERS(HidcfgButtonConfigEmbedded);
+static constexpr HidcfgDigitalButtonAssignment HidcfgButtonConfigFull::* FULL_MEMBERS[] = FULL_BUTTON_MEMBERS(HidcfgButtonConfigFull);
+
+// 左 JoyCon 只有十字键、L/ZL、左摇杆、Select
+static constexpr HidcfgDigitalButtonAssignment HidcfgButtonConfigLeft::* LEFT_MEMBERS[] = {
+    nullptr, nullptr, nullptr, nullptr,
+    &HidcfgButtonConfigLeft::hardware_button_up,    &HidcfgButtonConfigLeft::hardware_button_down,
+    &HidcfgButtonConfigLeft::hardware_button_left,  &HidcfgButtonConfigLeft::hardware_button_right,
+    &HidcfgButtonConfigLeft::hardware_button_l,     nullptr,
+    &HidcfgButtonConfigLeft::hardware_button_zl,    nullptr,
+    &HidcfgButtonConfigLeft::hardware_button_stick_l, nullptr,
+    nullptr,                                        &HidcfgButtonConfigLeft::hardware_button_select,
+};
+
+// 右 JoyCon 只有 A/B/X/Y、R/ZR、右摇杆、Start
+static constexpr HidcfgDigitalButtonAssignment HidcfgButtonConfigRight::* RIGHT_MEMBERS[] = {
+    &HidcfgButtonConfigRight::hardware_button_a,    &HidcfgButtonConfigRight::hardware_button_b,
+    &HidcfgButtonConfigRight::hardware_button_x,    &HidcfgButtonConfigRight::hardware_button_y,
+    nullptr, nullptr, nullptr, nullptr,
+    nullptr,                                        &HidcfgButtonConfigRight::hardware_button_r,
+    nullptr,                                        &HidcfgButtonConfigRight::hardware_button_zr,
+    nullptr,                                        &HidcfgButtonConfigRight::hardware_button_stick_r,
+    &HidcfgButtonConfigRight::hardware_button_start, nullptr,
+};
+
+// 静态成员初始化
+ButtonRemapper::PadCache ButtonRemapper::s_Pads[MAX_PADS];
+s32 ButtonRemapper::s_PadCount = 0;
+s8 ButtonRemapper::s_Profiles[MAX_PROFILES][BUTTON_COUNT];
+int ButtonRemapper::s_ProfileSizes[MAX_PROFILES];
+std::atomic<int> ButtonRemapper::s_ProfileCount{0};
+std::atomic<int> ButtonRemapper::s_ActiveProfile{0};
+
 // 查找按键（返回-1表示无效）
 int ButtonRemapper::FindButton(const char* name) {
     for (const auto& btn : BUTTONS) {
@@ -47,168 +85,170 @@ int ButtonRemapper::FindButton(const char* name) {
     return -1; // 无效按键
 }
 
-// 应用映射（通用）
+// 应用映射到单个手柄
 template<typename ConfigType>
-void ButtonRemapper::ApplyMapping(ConfigType& config, const char* from, const char* to) {
-    int to_value = FindButton(to);
-    if (to_value == -1) return; // 无效的目标按键，跳过
-    
-    // 检查源按键是否有效，并应用映射
-    if (strcmp(from, "A") == 0) config.hardware_button_a = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "B") == 0) config.hardware_button_b = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "X") == 0) config.hardware_button_x = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Y") == 0) config.hardware_button_y = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "StickL") == 0) config.hardware_button_stick_l = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "StickR") == 0) config.hardware_button_stick_r = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "L") == 0) config.hardware_button_l = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "R") == 0) config.hardware_button_r = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "ZL") == 0) config.hardware_button_zl = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "ZR") == 0) config.hardware_button_zr = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Select") == 0) config.hardware_button_select = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Start") == 0) config.hardware_button_start = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Left") == 0) config.hardware_button_left = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Up") == 0) config.hardware_button_up = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Right") == 0) config.hardware_button_right = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Down") == 0) config.hardware_button_down = (HidcfgDigitalButtonAssignment)to_value;
-}
-
-// 应用映射到 Embedded 手柄
-void ButtonRemapper::ApplyMappingsToEmbedded(HidsysUniquePadId pad_id, const std::vector<ButtonMapping>& mappings) {
-    HidcfgButtonConfigEmbedded config;
-    Result rc = hidsysGetHidButtonConfigEmbedded(pad_id, &config);
-    if (R_FAILED(rc)) return;
+void ButtonRemapper::ApplyToPad(PadCache& pad, ConfigType& base, ConfigType& last,
+                                const ButtonMember<ConfigType> (&members)[BUTTON_COUNT],
+                                Result (*get_config)(HidsysUniquePadId, ConfigType*),
+                                Result (*set_config)(HidsysUniquePadId, const ConfigType*),
+                                const s8 (&targets)[BUTTON_COUNT]) {
+    // 原始配置只读取一次
+    if (!pad.has_base) {
+        if (R_FAILED(get_config(pad.id, &base))) return;
+        pad.has_base = true;
+    }
     
-    for (const auto& mapping : mappings) {
-        ApplyMapping(config, mapping.source, mapping.target);
+    ConfigType config = base;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        if (targets[i] < 0 || !members[i]) continue;  // 不映射或该手柄没有此按键
+        config.*members[i] = (HidcfgDigitalButtonAssignment)targets[i];
     }
     
-    hidsysSetHidButtonConfigEmbedded(pad_id, &config);
-}
-
-// 应用映射到 Full 手柄
-void ButtonRemapper::ApplyMappingsToFull(HidsysUniquePadId pad_id, const std::vector<ButtonMapping>& mappings) {
-    HidcfgButtonConfigFull config;
-    Result rc = hidsysGetHidButtonConfigFull(pad_id, &config);
-    if (R_FAILED(rc)) return;
+    // 与上次应用的配置相同，无需再次设置
+    if (pad.applied && memcmp(&config, &last, sizeof(ConfigType)) == 0) return;
     
-    for (const auto& mapping : mappings) {
-        ApplyMapping(config, mapping.source, mapping.target);
+    if (R_SUCCEEDED(set_config(pad.id, &config))) {
+        last = config;
+        pad.applied = true;
     }
-    
-    hidsysSetHidButtonConfigFull(pad_id, &config);
 }
 
-// 应用单个映射到左 JoyCon（只处理左侧按键）
-void ButtonRemapper::ApplyMappingLeft(HidcfgButtonConfigLeft& config, const char* from, const char* to) {
-    int to_value = FindButton(to);
-    if (to_value == -1) return;
-    
-    // 只处理左 JoyCon 拥有的按键
-    if (strcmp(from, "Left") == 0) config.hardware_button_left = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Up") == 0) config.hardware_button_up = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Right") == 0) config.hardware_button_right = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Down") == 0) config.hardware_button_down = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "StickL") == 0) config.hardware_button_stick_l = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "L") == 0) config.hardware_button_l = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "ZL") == 0) config.hardware_button_zl = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Select") == 0) config.hardware_button_select = (HidcfgDigitalButtonAssignment)to_value;
-    // 忽略右侧按键（A/B/X/Y/R/ZR/StickR/Start 等）
+// 从配置文件加载映射关系
+int ButtonRemapper::LoadMappingsFromConfig(const char* config_path, const char* section, s8 (&targets)[BUTTON_COUNT]) {
+    int count = 0;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        char target[8];
+        targets[i] = -1;
+        ini_gets(section, BUTTONS[i].name, BUTTONS[i].name, target, sizeof(target), config_path);
+        // 跳过A=A这种无效映射
+        if (strcmp(BUTTONS[i].name, target) == 0) continue;
+        int value = FindButton(target);
+        if (value == -1) continue;  // 无效的目标按键，跳过
+        targets[i] = (s8)value;
+        count++;
+    }
+    return count;
 }
 
-// 应用映射到左 JoyCon
-void ButtonRemapper::ApplyMappingsToLeft(HidsysUniquePadId pad_id, const std::vector<ButtonMapping>& mappings) {
-    HidcfgButtonConfigLeft config;
-    Result rc = hidsysGetHidButtonConfigLeft(pad_id, &config);
-    if (R_FAILED(rc)) return;
+// 加载全部映射方案
+// [MAPPING] profiles=combat,menu 表示附加方案的名称，对应 [MAPPING_combat]、[MAPPING_menu]
+void ButtonRemapper::LoadProfiles(const char* config_path) {
+    s_ProfileSizes[0] = LoadMappingsFromConfig(config_path, "MAPPING", s_Profiles[0]);
+    s_ProfileCount = 1;
     
-    for (const auto& mapping : mappings) {
-        ApplyMappingLeft(config, mapping.source, mapping.target);
+    char names[96];
+    ini_gets("MAPPING", "profiles", "", names, sizeof(names), config_path);
+    char* save = nullptr;
+    for (char* name = strtok_r(names, ", ", &save); name && s_ProfileCount < MAX_PROFILES; name = strtok_r(nullptr, ", ", &save)) {
+        char section[40];
+        snprintf(section, sizeof(section), "MAPPING_%s", name);
+        s_ProfileSizes[s_ProfileCount] = LoadMappingsFromConfig(config_path, section, s_Profiles[s_ProfileCount]);
+        s_ProfileCount++;
     }
     
-    hidsysSetHidButtonConfigLeft(pad_id, &config);
+    // 方案被删除时回到默认方案
+    if (s_ActiveProfile >= s_ProfileCount) s_ActiveProfile = 0;
 }
 
-// 应用单个映射到右 JoyCon（只处理右侧按键）
-void ButtonRemapper::ApplyMappingRight(HidcfgButtonConfigRight& config, const char* from, const char* to) {
-    int to_value = FindButton(to);
-    if (to_value == -1) return;
-    
-    // 只处理右 JoyCon 拥有的按键
-    if (strcmp(from, "A") == 0) config.hardware_button_a = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "B") == 0) config.hardware_button_b = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "X") == 0) config.hardware_button_x = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Y") == 0) config.hardware_button_y = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "StickR") == 0) config.hardware_button_stick_r = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "R") == 0) config.hardware_button_r = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "ZR") == 0) config.hardware_button_zr = (HidcfgDigitalButtonAssignment)to_value;
-    else if (strcmp(from, "Start") == 0) config.hardware_button_start = (HidcfgDigitalButtonAssignment)to_value;
-    // 忽略左侧按键（十字键/L/ZL/StickL/Select 等）
+// 切换到下一个方案
+void ButtonRemapper::NextProfile() {
+    if (s_ProfileCount <= 1) return;
+    s_ActiveProfile = (s_ActiveProfile + 1) % s_ProfileCount;
 }
 
-// 应用映射到右 JoyCon
-void ButtonRemapper::ApplyMappingsToRight(HidsysUniquePadId pad_id, const std::vector<ButtonMapping>& mappings) {
-    HidcfgButtonConfigRight config;
-    Result rc = hidsysGetHidButtonConfigRight(pad_id, &config);
-    if (R_FAILED(rc)) return;
-    
-    for (const auto& mapping : mappings) {
-        ApplyMappingRight(config, mapping.source, mapping.target);
-    }
-    
-    hidsysSetHidButtonConfigRight(pad_id, &config);
-}
-
-// 从配置文件加载映射关系
-void ButtonRemapper::LoadMappingsFromConfig(const char* config_path, std::vector<ButtonMapping>& out) {
-    out.clear();
-    for (int i = 0; i < 16; i++) {
-        ButtonMapping mapping;
-        mapping.source = BUTTON_NAMES[i];
-        ini_gets("MAPPING", BUTTON_NAMES[i], BUTTON_NAMES[i], mapping.target, sizeof(mapping.target), config_path);
-        // 跳过A=A这种无效映射
-        if (strcmp(mapping.source, mapping.target) != 0) out.push_back(mapping);
+// 查找或创建手柄缓存（从旧缓存中复制已知手柄）
+ButtonRemapper::PadCache* ButtonRemapper::GetPadCache(HidsysUniquePadId pad_id, PadCache* old_cache, s32 old_count, bool& is_new) {
+    PadCache& pad = s_Pads[s_PadCount];
+    for (s32 i = 0; i < old_count; i++) {
+        if (old_cache[i].id.id == pad_id.id) {
+            pad = old_cache[i];
+            s_PadCount++;
+            is_new = false;
+            return &pad;
+        }
     }
+    // 新手柄，获取手柄类型
+    is_new = true;
+    memset(&pad, 0, sizeof(PadCache));
+    pad.id = pad_id;
+    if (R_FAILED(hidsysGetUniquePadType(pad_id, &pad.type))) return nullptr;
+    s_PadCount++;
+    return &pad;
 }
 
 Result ButtonRemapper::SetMapping(const char* config_path) {
-    // 读取配置到局部 vector
-    std::vector<ButtonMapping> mappings;
-    LoadMappingsFromConfig(config_path, mappings);
+    // 读取配置
+    LoadProfiles(config_path);
+    return EnableMapping();
+}
 
+// 应用已加载的当前方案
+Result ButtonRemapper::EnableMapping() {
     // 如果是空的代表不需要修改配置，直接恢复
-    if (mappings.empty()) {
+    if (s_ProfileCount == 0 || s_ProfileSizes[s_ActiveProfile] == 0) {
         RestoreMapping();
         return 0;
     }
 
+    Result rc = ApplyMapping(false);
+    if (R_FAILED(rc)) return rc;
+    
+    // 标记映射已启用
+    s_MappingEnabled = true;
+    return 0;
+}
+
+// 将当前映射应用到新连接的手柄
+Result ButtonRemapper::ApplyToNewPads() {
+    if (!s_MappingEnabled) return 0;
+    return ApplyMapping(true);
+}
+
+// 将当前方案应用到当前连接的手柄
+Result ButtonRemapper::ApplyMapping(bool only_new) {
+    const s8 (&targets)[BUTTON_COUNT] = s_Profiles[s_ActiveProfile];
+    
     // 获取所有手柄的ID
-    HidsysUniquePadId pad_ids[8];
+    HidsysUniquePadId pad_ids[MAX_PADS];
     s32 total = 0;
-    Result rc = hidsysGetUniquePadIds(pad_ids, 8, &total);
+    Result rc = hidsysGetUniquePadIds(pad_ids, MAX_PADS, &total);
     if (R_FAILED(rc) || total == 0) return rc;
     
+    // 按当前连接的手柄重建缓存（已断开的手柄被丢弃）
+    PadCache old_cache[MAX_PADS];
+    s32 old_count = s_PadCount;
+    memcpy(old_cache, s_Pads, sizeof(PadCache) * old_count);
+    s_PadCount = 0;
+    
     // 遍历所有手柄
     for (s32 i = 0; i < total; i++) {
-        // 获取手柄类型
-        HidsysUniquePadType pad_type;
-        rc = hidsysGetUniquePadType(pad_ids[i], &pad_type);
-        if (R_FAILED(rc)) continue;
+        bool is_new = false;
+        PadCache* pad = GetPadCache(pad_ids[i], old_cache, old_count, is_new);
+        if (!pad || (only_new && !is_new)) continue;
         
         // 根据手柄类型应用映射
-        if (pad_type == HidsysUniquePadType_Embedded || 
-            pad_type == HidsysUniquePadType_DebugPadController) {
-            ApplyMappingsToEmbedded(pad_ids[i], mappings);
-        } else if (pad_type == HidsysUniquePadType_FullKeyController) {
-            ApplyMappingsToFull(pad_ids[i], mappings);
-        } else if (pad_type == HidsysUniquePadType_LeftController) {
-            ApplyMappingsToLeft(pad_ids[i], mappings);
-        } else if (pad_type == HidsysUniquePadType_RightController) {
-            ApplyMappingsToRight(pad_ids[i], mappings);
+        switch (pad->type) {
+            case HidsysUniquePadType_Embedded:
+            case HidsysUniquePadType_DebugPadController:
+                ApplyToPad(*pad, pad->base.embedded, pad->last.embedded, EMBEDDED_MEMBERS,
+                           hidsysGetHidButtonConfigEmbedded, hidsysSetHidButtonConfigEmbedded, targets);
+                break;
+            case HidsysUniquePadType_FullKeyController:
+                ApplyToPad(*pad, pad->base.full, pad->last.full, FULL_MEMBERS,
+                           hidsysGetHidButtonConfigFull, hidsysSetHidButtonConfigFull, targets);
+                break;
+            case HidsysUniquePadType_LeftController:
+                ApplyToPad(*pad, pad->base.left, pad->last.left, LEFT_MEMBERS,
+                           hidsysGetHidButtonConfigLeft, hidsysSetHidButtonConfigLeft, targets);
+                break;
+            case HidsysUniquePadType_RightController:
+                ApplyToPad(*pad, pad->base.right, pad->last.right, RIGHT_MEMBERS,
+                           hidsysGetHidButtonConfigRight, hidsysSetHidButtonConfigRight, targets);
+                break;
+            default:
+                break;
         }
     }
-    
-    // 标记映射已启用
-    s_MappingEnabled = true;
     return 0;
 }
 
@@ -222,6 +262,9 @@ Result ButtonRemapper::RestoreMapping() {
     Result rc = hidsysSetAllDefaultButtonConfig();
     if (R_FAILED(rc)) return rc;
     
+    // 所有手柄都回到了默认配置，下次必须重新设置
+    for (s32 i = 0; i < s_PadCount; i++) s_Pads[i].applied = false;
+    
     // 禁用自定义按键配置（使用 0 作为 AppletResourceUserId）
     rc = hidsysSetAllCustomButtonConfigEnabled(0, false);
     if (R_SUCCEEDED(rc)) s_MappingEnabled = false;
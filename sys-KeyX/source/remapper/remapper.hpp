@@ -1,48 +1,91 @@
 #pragma once
 #include <switch.h>
-#include <vector>
-
-// 按键映射结构体
-struct ButtonMapping {
-    const char* source;
-    char target[8];
-};
+#include <atomic>
 
 class ButtonRemapper {
 public:
-    // 设置手柄按键映射（从配置文件读取）
+    // 设置手柄按键映射（从配置文件读取全部方案，然后应用当前方案）
     static Result SetMapping(const char* config_path);
+    
+    // 加载全部映射方案但不应用（[MAPPING] 为默认方案，profiles= 列出的 [MAPPING_名称] 为附加方案）
+    // 游戏不在焦点时使用，回到焦点时由 EnableMapping 应用
+    static void LoadProfiles(const char* config_path);
+    
+    // 应用已加载的当前方案（不读取配置，焦点切换时使用）
+    static Result EnableMapping();
+    
+    // 切换到下一个方案（只切换下标，应用需调用 EnableMapping）
+    static void NextProfile();
+    
+    // 回到默认方案（新游戏启动时）
+    static void ResetProfile() { s_ActiveProfile = 0; }
+    
+    // 当前方案下标 / 方案数量（状态查询用）
+    static int GetActiveProfile() { return s_ActiveProfile; }
+    static int GetProfileCount() { return s_ProfileCount; }
 
     // 恢复默认按键配置
     static Result RestoreMapping();
+    
+    // 将当前映射应用到新连接的手柄（映射未启用时不做任何事）
+    // 不重新读取配置，已应用过的手柄直接跳过
+    static Result ApplyToNewPads();
 
 private:
-    // 从配置文件加载映射关系
-    static void LoadMappingsFromConfig(const char* config_path, std::vector<ButtonMapping>& out);
+    // 可映射的按键数量
+    static constexpr int BUTTON_COUNT = 16;
+    
+    // 最多缓存的手柄数量
+    static constexpr int MAX_PADS = 8;
+    
+    // 最多的映射方案数量（默认方案 + 3个命名方案）
+    static constexpr int MAX_PROFILES = 4;
+
+    // 按键在各类手柄配置结构中的成员指针
+    template<typename ConfigType>
+    using ButtonMember = HidcfgDigitalButtonAssignment ConfigType::*;
+
+    // 单个手柄的配置缓存
+    struct PadCache {
+        HidsysUniquePadId id;
+        HidsysUniquePadType type;
+        bool has_base;          // 是否已读取原始配置
+        bool applied;           // 当前是否已应用映射
+        union {
+            HidcfgButtonConfigEmbedded embedded;
+            HidcfgButtonConfigFull full;
+            HidcfgButtonConfigLeft left;
+            HidcfgButtonConfigRight right;
+        } base, last;           // 原始配置 / 上次应用的配置
+    };
+
+    // 从配置文件的指定节加载映射关系（targets[源按键] = 目标按键，-1表示不映射）
+    // 返回有效映射数量
+    static int LoadMappingsFromConfig(const char* config_path, const char* section, s8 (&targets)[BUTTON_COUNT]);
+
 
     // 查找按键枚举值（返回-1表示无效）
     static int FindButton(const char* name);
     
-    // 应用映射（通用）
-    template<typename ConfigType>
-    static void ApplyMapping(ConfigType& config, const char* from, const char* to);
-    
-    // 应用映射到 Embedded 手柄
-    static void ApplyMappingsToEmbedded(HidsysUniquePadId pad_id, const std::vector<ButtonMapping>& mappings);
-    
-    // 应用映射到 Full 手柄
-    static void ApplyMappingsToFull(HidsysUniquePadId pad_id, const std::vector<ButtonMapping>& mappings);
+    // 查找或创建手柄缓存（is_new 返回是否为新连接的手柄）
+    static PadCache* GetPadCache(HidsysUniquePadId pad_id, PadCache* old_cache, s32 old_count, bool& is_new);
     
-    // 应用映射到左 JoyCon
-    static void ApplyMappingsToLeft(HidsysUniquePadId pad_id, const std::vector<ButtonMapping>& mappings);
+    // 将当前方案应用到当前连接的手柄（only_new=true 时只处理新手柄）
+    static Result ApplyMapping(bool only_new);
     
-    // 应用映射到右 JoyCon
-    static void ApplyMappingsToRight(HidsysUniquePadId pad_id, const std::vector<ButtonMapping>& mappings);
-    
-    // 应用单个映射到左 JoyCon（只处理左侧按键）
-    static void ApplyMappingLeft(HidcfgButtonConfigLeft& config, const char* from, const char* to);
+    // 应用映射到单个手柄（配置与上次应用的相同则跳过设置）
+    template<typename ConfigType>
+    static void ApplyToPad(PadCache& pad, ConfigType& base, ConfigType& last,
+                           const ButtonMember<ConfigType> (&members)[BUTTON_COUNT],
+                           Result (*get_config)(HidsysUniquePadId, ConfigType*),
+                           Result (*set_config)(HidsysUniquePadId, const ConfigType*),
+                           const s8 (&targets)[BUTTON_COUNT]);
     
-    // 应用单个映射到右 JoyCon（只处理右侧按键）
-    static void ApplyMappingRight(HidcfgButtonConfigRight& config, const char* from, const char* to);
+    static PadCache s_Pads[MAX_PADS];   // 手柄配置缓存
+    static s32 s_PadCount;              // 缓存的手柄数量
+    static s8 s_Profiles[MAX_PROFILES][BUTTON_COUNT];   // 预先解析好的各方案映射（切换和热插拔时复用）
+    static int s_ProfileSizes[MAX_PROFILES];            // 各方案的有效映射数量
+    static std::atomic<int> s_ProfileCount;             // 方案数量（状态查询在 IPC 线程读取）
+    static std::atomic<int> s_ActiveProfile;            // 当前方案（同上）
 };
 
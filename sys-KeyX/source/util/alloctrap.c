@@ -0,0 +1,73 @@
+#include "alloctrap.h"
+
+#ifdef KEYX_ALLOC_TRIPWIRE
+
+#include <stdatomic.h>
+#include <reent.h>
+#include "log.h"
+
+static Thread* _Atomic g_watched = NULL;                        // 被监视的线程
+static _Atomic u32 g_violations = 0;                            // 违规次数
+
+// 链接器提供的原始实现
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real__malloc_r(struct _reent* r, size_t size);
+void* __real__calloc_r(struct _reent* r, size_t count, size_t size);
+void* __real__realloc_r(struct _reent* r, void* ptr, size_t size);
+
+// 记录一次违规（只做原子计数和无锁事件记录，不能再分配内存）
+static void check_alloc(size_t size) {
+    Thread* watched = atomic_load_explicit(&g_watched, memory_order_relaxed);
+    if (!watched || watched != threadGetSelf()) return;
+    u32 count = atomic_fetch_add_explicit(&g_violations, 1, memory_order_relaxed) + 1;
+    log_event(LOG_EVT_ALLOC, count, size, (u64)__builtin_return_address(0));
+}
+
+void* __wrap_malloc(size_t size) {
+    check_alloc(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    check_alloc(count * size);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    check_alloc(size);
+    return __real_realloc(ptr, size);
+}
+
+void* __wrap__malloc_r(struct _reent* r, size_t size) {
+    check_alloc(size);
+    return __real__malloc_r(r, size);
+}
+
+void* __wrap__calloc_r(struct _reent* r, size_t count, size_t size) {
+    check_alloc(count * size);
+    return __real__calloc_r(r, count, size);
+}
+
+void* __wrap__realloc_r(struct _reent* r, void* ptr, size_t size) {
+    check_alloc(size);
+    return __real__realloc_r(r, ptr, size);
+}
+
+// 开始监视当前线程
+void alloc_tripwire_watch(void) {
+    atomic_store(&g_watched, threadGetSelf());
+}
+
+// 停止监视
+void alloc_tripwire_unwatch(void) {
+    atomic_store(&g_watched, NULL);
+}
+
+// 被监视线程中发生的分配次数
+u32 alloc_tripwire_violations(void) {
+    return atomic_load_explicit(&g_violations, memory_order_relaxed);
+}
+
+#endif
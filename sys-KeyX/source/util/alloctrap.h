@@ -0,0 +1,35 @@
+#pragma once
+#include <switch.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------
+// 调试用的堆分配检测（make ALLOC_TRIPWIRE=1 时生效）
+// 链接时包装 malloc/calloc/realloc，统计被监视线程中的分配次数，
+// 每次违规都会写入一条 LOG_EVT_ALLOC 事件；正常构建下全部为空操作
+// ---------------------------------------------------------------------------
+
+#ifdef KEYX_ALLOC_TRIPWIRE
+
+// 开始监视当前线程
+void alloc_tripwire_watch(void);
+
+// 停止监视
+void alloc_tripwire_unwatch(void);
+
+// 被监视线程中发生的分配次数
+u32 alloc_tripwire_violations(void);
+
+#else
+
+static inline void alloc_tripwire_watch(void) {}
+static inline void alloc_tripwire_unwatch(void) {}
+static inline u32 alloc_tripwire_violations(void) { return 0; }
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,77 @@
+#include "asyncread.hpp"
+
+namespace {
+    constexpr u64 WAIT_INTERVAL_NS = 100000ULL;  // 等待读取结束时的轮询间隔（100us）
+}
+
+// 静态线程栈定义
+alignas(0x1000) char AsyncReader::thread_stack[4 * 1024];
+
+// 析构函数
+AsyncReader::~AsyncReader() {
+    Stop();
+}
+
+// 启动读取线程
+bool AsyncReader::Start(const ThreadSetting& setting) {
+    if (m_ThreadRunning) return true;
+    ueventCreate(&m_RequestEvent, true);
+    m_ShouldExit = false;
+    if (R_FAILED(threadCreate(&m_Thread, ThreadFunc, this, thread_stack, sizeof(thread_stack), setting.priority, setting.core))) return false;
+    if (R_FAILED(threadStart(&m_Thread))) {
+        threadClose(&m_Thread);
+        return false;
+    }
+    m_ThreadRunning = true;
+    return true;
+}
+
+// 停止读取线程
+void AsyncReader::Stop() {
+    if (!m_ThreadRunning) return;
+    Wait();
+    m_ShouldExit = true;
+    ueventSignal(&m_RequestEvent);
+    threadWaitForExit(&m_Thread);
+    threadClose(&m_Thread);
+    m_ThreadRunning = false;
+}
+
+// 提交读取请求
+bool AsyncReader::Submit(FsFile* file, s64 offset, void* buffer, u64 size) {
+    if (m_State != State::Idle) return false;
+    m_File = file;
+    m_Offset = offset;
+    m_Buffer = buffer;
+    m_Size = size;
+    m_State = State::Pending;
+    if (m_ThreadRunning) ueventSignal(&m_RequestEvent);
+    else Read();
+    return true;
+}
+
+// 等待请求结束并取走结果
+AsyncReader::State AsyncReader::Wait() {
+    while (m_State == State::Pending) svcSleepThread(WAIT_INTERVAL_NS);
+    return m_State.exchange(State::Idle);
+}
+
+// 线程函数
+void AsyncReader::ThreadFunc(void* arg) {
+    static_cast<AsyncReader*>(arg)->ThreadLoop();
+}
+
+// 读取线程主循环：等待请求并完成读取
+void AsyncReader::ThreadLoop() {
+    while (!m_ShouldExit) {
+        waitSingle(waiterForUEvent(&m_RequestEvent), UINT64_MAX);
+        if (m_State == State::Pending) Read();
+    }
+}
+
+// 执行当前请求
+void AsyncReader::Read() {
+    u64 bytesRead = 0;
+    Result rc = fsFileRead(m_File, m_Offset, m_Buffer, m_Size, FsReadOption_None, &bytesRead);
+    m_State = (R_SUCCEEDED(rc) && bytesRead == m_Size) ? State::Done : State::Failed;
+}
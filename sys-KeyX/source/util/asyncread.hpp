@@ -0,0 +1,52 @@
+#pragma once
+#include <switch.h>
+#include <atomic>
+#include "threadcfg.hpp"
+
+// 后台文件读取（宏播放中读入下一个帧窗口用）
+// 按键线程提交请求后立即返回，由低优先级的读取线程完成读取；同一时间只有一个请求
+// 读取线程没有启动时（创建失败或回放测试）在提交时直接读取
+class AsyncReader {
+public:
+    enum class State : u32 {
+        Idle,       // 没有请求
+        Pending,    // 读取中
+        Done,       // 读取完成
+        Failed      // 读取失败或读到的字节数不足
+    };
+
+    AsyncReader() = default;
+    ~AsyncReader();
+    
+    // 启动读取线程
+    bool Start(const ThreadSetting& setting);
+    
+    // 停止读取线程（会先等进行中的读取结束）
+    void Stop();
+    
+    // 提交读取请求（上一个请求的结果还没有取走时返回false）
+    bool Submit(FsFile* file, s64 offset, void* buffer, u64 size);
+    
+    // 等待请求结束并取走结果（没有请求时返回 Idle），之后才能提交下一个请求
+    // 关闭文件或释放缓冲区之前必须调用
+    State Wait();
+
+private:
+    static void ThreadFunc(void* arg);
+    void ThreadLoop();
+    void Read();
+    
+    Thread m_Thread;
+    bool m_ThreadRunning = false;
+    std::atomic<bool> m_ShouldExit{false};
+    UEvent m_RequestEvent;                      // 有新请求
+    std::atomic<State> m_State{State::Idle};
+    
+    // 当前请求（提交后到读取结束前只由读取线程访问）
+    FsFile* m_File = nullptr;
+    s64 m_Offset = 0;
+    void* m_Buffer = nullptr;
+    u64 m_Size = 0;
+    
+    alignas(0x1000) static char thread_stack[4 * 1024];
+};
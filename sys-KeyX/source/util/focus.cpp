@@ -4,6 +4,7 @@
 u64 FocusMonitor::m_LastTid = 0;
 s32 FocusMonitor::m_LastCheckedIndex = 0;
 FocusState FocusMonitor::m_CurrentState = FocusState::Unknown;
+PdmAppletEvent FocusMonitor::s_Events[EVENT_BATCH];
 
 // 重置状态（游戏切换时）
 void FocusMonitor::ResetForNewGame() {
@@ -19,6 +20,36 @@ void FocusMonitor::ResetForNewGame() {
     }
 }
 
+// 分批读取所有新事件，只保留当前游戏最后一个焦点事件
+FocusState FocusMonitor::ReadNewEvents(u64 tid, s32 end_index) {
+    FocusState last_state = FocusState::Unknown;
+    s32 next_index = m_LastCheckedIndex + 1;
+    
+    while (next_index <= end_index) {
+        s32 total_out = 0;
+        Result rc = pdmqryQueryAppletEvent(next_index, false, s_Events, EVENT_BATCH, &total_out);
+        if (R_FAILED(rc) || total_out <= 0) break;
+        
+        for (s32 i = 0; i < total_out; i++) {
+            if (s_Events[i].program_id != tid) continue;  // 其他程序的事件直接跳过
+            if (s_Events[i].event_type == PdmAppletEventType_InFocus) {
+                last_state = FocusState::InFocus;
+            }
+            else if (s_Events[i].event_type == PdmAppletEventType_OutOfFocus || 
+                     s_Events[i].event_type == PdmAppletEventType_OutOfFocus4) {
+                last_state = FocusState::OutOfFocus;
+            }
+        }
+        
+        // 返回的只有 applet 事件，索引不连续，从最后一个事件之后继续
+        next_index = (s32)s_Events[total_out - 1].entry_index + 1;
+        if (total_out < EVENT_BATCH) break;
+    }
+    
+    m_LastCheckedIndex = end_index;
+    return last_state;
+}
+
 // 获取游戏焦点状态(只有在焦点变化的时候才会获取到在焦点或者不在，不然获取的是无变化)
 FocusState FocusMonitor::GetState(u64 tid) {
 
@@ -37,48 +68,19 @@ FocusState FocusMonitor::GetState(u64 tid) {
     // 获取事件范围
     s32 total = 0, start_index = 0, end_index = 0;
     Result rc = pdmqryGetAvailablePlayEventRange(&total, &start_index, &end_index);
+    if (R_FAILED(rc)) return FocusState::Unknown;  // 查询失败
     
-    if (R_FAILED(rc) || end_index <= m_LastCheckedIndex) {
-        return FocusState::Unknown;  // 查询失败或无新事件
-    }
-    
-    // 查询新事件
-    PdmAppletEvent events[10];
-    s32 total_out = 0;
+    // 无新事件
+    if (end_index <= m_LastCheckedIndex) return FocusState::Unknown;
     
-    rc = pdmqryQueryAppletEvent(m_LastCheckedIndex + 1, false, events, 10, &total_out);
+    // 历史记录被轮换，旧的索引已经不可用
+    if (m_LastCheckedIndex + 1 < start_index) m_LastCheckedIndex = start_index - 1;
     
-    if (R_FAILED(rc) || total_out == 0) {
-        m_LastCheckedIndex = end_index;
-        return FocusState::Unknown;  // 查询失败或无事件
+    // 更新状态
+    FocusState new_state = ReadNewEvents(tid, end_index);
+    if (new_state == FocusState::Unknown || new_state == m_CurrentState) {
+        return FocusState::Unknown;  // 状态未变化
     }
-    
-    // 从后往前查找最后一个匹配当前游戏的事件
-    for (s32 i = total_out - 1; i >= 0; i--) {
-        if (events[i].program_id != tid) continue;
-        
-        // 判断事件类型
-        FocusState new_state = FocusState::Unknown;
-        
-        if (events[i].event_type == PdmAppletEventType_InFocus) {
-            new_state = FocusState::InFocus;
-        } 
-        else if (events[i].event_type == PdmAppletEventType_OutOfFocus || 
-                 events[i].event_type == PdmAppletEventType_OutOfFocus4) {
-            new_state = FocusState::OutOfFocus;
-        }
-        
-        // 更新状态
-        if (new_state != FocusState::Unknown && new_state != m_CurrentState) {
-            m_CurrentState = new_state;
-            m_LastCheckedIndex = end_index;
-            return new_state;
-        }
-        
-        break;  // 只处理最后一个匹配的事件
-    }
-    
-    m_LastCheckedIndex = end_index;
-    return FocusState::Unknown;  // 状态未变化
+    m_CurrentState = new_state;
+    return new_state;
 }
-
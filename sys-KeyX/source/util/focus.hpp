@@ -19,8 +19,14 @@ public:
 private:
     static void ResetForNewGame();  // 重置状态（游戏切换时）
     
+    // 从 m_LastCheckedIndex 之后分批读取到 end_index 为止的所有新事件
+    // 返回: 当前游戏最后一个焦点事件对应的状态（没有则返回 Unknown）
+    static FocusState ReadNewEvents(u64 tid, s32 end_index);
+    
+    static constexpr s32 EVENT_BATCH = 32;   // 每次查询的事件数量
+    
     static u64 m_LastTid;              // 上次的游戏 TID（用于检测游戏切换）
     static s32 m_LastCheckedIndex;     // pdmqry 上次检查的索引
     static FocusState m_CurrentState;  // 当前焦点状态
+    static PdmAppletEvent s_Events[EVENT_BATCH];  // 查询缓冲区（避免占用主线程栈）
 };
-
@@ -19,6 +19,10 @@ namespace {
 
 // 静态成员初始化
 u64 GameMonitor::m_LastTid = 0;
+u64 GameMonitor::m_LastPid = 0;
+u64 GameMonitor::m_LastPidTid = 0;
+Handle GameMonitor::m_ProcessHandle = INVALID_HANDLE;
+u64 GameMonitor::m_ProcessHandlePid = 0;
 std::unordered_set<u64> GameMonitor::s_whitelist;
 
 // 获取当前游戏 Title ID（仅游戏，非游戏返回0）
@@ -30,16 +34,50 @@ u64 GameMonitor::GetCurrentGameTitleId() {
         return 0;
     }
 
+    // 进程ID未变化，直接使用缓存的结果
+    if (pid == m_LastPid) return m_LastPidTid;
+
     // 2. 根据进程ID获取程序ID (Title ID)
     if (R_FAILED(pmdmntGetProgramId(&tid, pid))) {
         return 0;
     }
+    m_LastPid = pid;
+    m_LastPidTid = 0;
     
     // 3. 过滤非游戏ID
     u8 type = (u8)(tid >> 56);
-    if (type == 0x01) return tid;           // 游戏直接通过
-    if (s_whitelist.count(tid)) return tid; // 白名单通过
-    return 0;
+    if (type == 0x01 || s_whitelist.count(tid)) m_LastPidTid = tid;  // 游戏或白名单通过
+    return m_LastPidTid;
+}
+
+// 打开当前游戏的进程句柄（用于事件驱动的退出检测）
+void GameMonitor::OpenProcessHandle() {
+    CloseProcessHandle();
+    NcmProgramLocation loc;
+    CfgOverrideStatus status;
+    // 获取失败时只是退化为轮询检测退出，记录进程ID避免重复尝试
+    if (R_FAILED(pmdmntAtmosphereGetProcessInfo(&m_ProcessHandle, &loc, &status, m_LastPid))) {
+        m_ProcessHandle = INVALID_HANDLE;
+    }
+    m_ProcessHandlePid = m_LastPid;
+}
+
+// 关闭进程句柄（游戏退出后必须关闭，否则进程对象无法释放）
+void GameMonitor::CloseProcessHandle() {
+    m_ProcessHandlePid = 0;
+    ReleaseProcessHandle();
+}
+
+// 释放进程句柄（保留进程ID，不会被重新打开）
+void GameMonitor::ReleaseProcessHandle() {
+    if (m_ProcessHandle == INVALID_HANDLE) return;
+    svcCloseHandle(m_ProcessHandle);
+    m_ProcessHandle = INVALID_HANDLE;
+}
+
+// 获取当前游戏进程句柄
+Handle GameMonitor::GetProcessHandle() {
+    return m_ProcessHandle;
 }
 
 // 检查游戏状态（返回事件+TID）
@@ -49,12 +87,14 @@ GameStateResult GameMonitor::GetState() {
     // 游戏退出（tid → 0）
     if (tid == 0 && m_LastTid != 0) {
         m_LastTid = 0;
+        CloseProcessHandle();
         return {GameEvent::Exited, 0};
     }
     
     // 游戏启动（0 → tid）
     if (tid != 0 && m_LastTid == 0) {
         m_LastTid = tid;
+        OpenProcessHandle();
         return {GameEvent::Launched, tid};
     }
     
@@ -63,6 +103,9 @@ GameStateResult GameMonitor::GetState() {
         return {GameEvent::Idle, 0};
     }
     
+    // 两次检测之间换了游戏进程，重新打开进程句柄
+    if (m_ProcessHandlePid != m_LastPid) OpenProcessHandle();
+    
     // 游戏持续运行（tid 不变）
     return {GameEvent::Running, tid};
 }
@@ -70,5 +113,6 @@ GameStateResult GameMonitor::GetState() {
 // 加载白名单到内存
 void GameMonitor::LoadWhitelist() {
     s_whitelist.clear();
+    m_LastPid = 0;  // 白名单变化后需要重新判定当前进程
     ini_browse(WhitelistCallback, &s_whitelist, WHITE_INI_PATH);
 }
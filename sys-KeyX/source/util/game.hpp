@@ -25,13 +25,31 @@ public:
     // 加载白名单到内存
     static void LoadWhitelist();
     
+    // 获取当前游戏进程句柄（进程状态变化时有信号，无游戏返回 INVALID_HANDLE）
+    static Handle GetProcessHandle();
+    
+    // 释放进程句柄（进程已终止时调用，避免句柄一直处于有信号状态）
+    static void ReleaseProcessHandle();
+    
 private:
     // 获取当前游戏 Title ID（仅游戏，非游戏返回0）
     static u64 GetCurrentGameTitleId();
     
+    // 打开/关闭当前游戏的进程句柄
+    static void OpenProcessHandle();
+    static void CloseProcessHandle();
+    
     // 上次检测到的游戏 TID
     static u64 m_LastTid;
     
+    // 上次查询的进程ID及其TID（进程ID不变时无需再查询 ProgramId）
+    static u64 m_LastPid;
+    static u64 m_LastPidTid;
+    
+    // 当前游戏进程句柄及其对应的进程ID
+    static Handle m_ProcessHandle;
+    static u64 m_ProcessHandlePid;
+    
     // 白名单缓存
     static std::unordered_set<u64> s_whitelist;
 };
@@ -1,19 +1,42 @@
 #include "ipc.hpp"
 #include <cstring>
+#include <malloc.h>
+#include "mempool.h"
+#include "threadcfg.hpp"
+
+// newlib 堆范围（main.cpp 中配置）
+extern "C" {
+    extern void* fake_heap_start;
+    extern void* fake_heap_end;
+}
+
+namespace {
+    // 填充内存统计（内存池和堆都是全局的，直接读取）
+    void FillMemoryStats(KeyXMemoryStats& stats) {
+        for (int i = 0; i < KEYX_MEMPOOL_COUNT && i < MEMPOOL_COUNT; i++) {
+            u32 capacity = 0, used = 0, peak = 0, failures = 0;
+            mempool_stats((MemPoolId)i, &capacity, &used, &peak, &failures);
+            stats.pools[i] = {capacity, used, peak, failures};
+        }
+        struct mallinfo info = mallinfo();
+        stats.heapCapacity = (u32)((u8*)fake_heap_end - (u8*)fake_heap_start);
+        stats.heapUsed = (u32)info.uordblks;
+        stats.heapPeak = (u32)info.arena;
+    }
+}
 
 // 静态线程栈定义
 alignas(0x1000) char IPCServer::ipc_thread_stack[8 * 1024];
 
 // 构造函数
 IPCServer::IPCServer() : 
-    m_IsClientConnected(false),
+    m_SessionCount(0),
     m_ShouldExit(false),
     m_ThreadCreated(false),
     m_ThreadRunning(false) {
     
     // 初始化句柄数组
-    m_Handles[0] = INVALID_HANDLE;
-    m_Handles[1] = INVALID_HANDLE;
+    for (auto& handle : m_Handles) handle = INVALID_HANDLE;
     
     // 初始化服务名
     memset(&m_ServerName, 0, sizeof(SmServiceName));
@@ -35,9 +58,10 @@ bool IPCServer::Start(const char* service_name) {
     memcpy(m_ServerName.name, service_name, 
            service_name[7] == '\0' ? 8 : 7);  // 确保不超过8字符
     
-    // 创建IPC线程（-2表示自适应核心分配）
+    // 创建IPC线程（优先级和核心见 ThreadConfig）
+    const ThreadSetting& setting = ThreadConfig::Ipc();
     Result rc = threadCreate(&m_IpcThread, ThreadEntry, this, 
-                           ipc_thread_stack, sizeof(ipc_thread_stack), 44, -2);
+                           ipc_thread_stack, sizeof(ipc_thread_stack), setting.priority, setting.core);
     if (R_FAILED(rc)) {
         return false;
     }
@@ -131,6 +155,16 @@ void IPCServer::SetReloadWhitelistCallback(std::function<void()> callback) {
     m_ReloadWhitelistCallback = callback;
 }
 
+// 设置切换映射方案回调函数
+void IPCServer::SetNextProfileCallback(std::function<void()> callback) {
+    m_NextProfileCallback = callback;
+}
+
+// 设置状态查询回调函数
+void IPCServer::SetStatusCallback(StatusCallback callback) {
+    m_StatusCallback = callback;
+}
+
 // 静态线程入口函数
 void IPCServer::ThreadEntry(void* arg) {
     IPCServer* server = static_cast<IPCServer*>(arg);
@@ -152,7 +186,7 @@ void IPCServer::IpcThreadMain() {
 void IPCServer::StartServer() {
     
     // ★ 修正：第二个参数传 SmServiceName 值，不是指针
-    Result rc = smRegisterService(m_ServerHandle, m_ServerName, false, 1);
+    Result rc = smRegisterService(m_ServerHandle, m_ServerName, false, IPC_MAX_SESSIONS);
     if (R_FAILED(rc)) {
         m_ShouldExit = true;
         return;
@@ -161,12 +195,8 @@ void IPCServer::StartServer() {
 
 // 停止服务器
 void IPCServer::StopServer() {
-    // 关闭客户端连接
-    if (m_IsClientConnected && *m_ClientHandle != INVALID_HANDLE) {
-        svcCloseHandle(*m_ClientHandle);
-        *m_ClientHandle = INVALID_HANDLE;
-        m_IsClientConnected = false;
-    }
+    // 关闭所有客户端连接
+    while (m_SessionCount > 0) CloseSession(m_SessionCount - 1);
     
     // 关闭服务器句柄并注销服务
     if (*m_ServerHandle != INVALID_HANDLE) {
@@ -180,140 +210,154 @@ void IPCServer::StopServer() {
 void IPCServer::WaitAndProcessRequest() {
     s32 index = -1;
     
-    // 等待同步（监听服务器句柄和客户端句柄）
-    Result rc = svcWaitSynchronization(&index, m_Handles, m_IsClientConnected ? 2 : 1, UINT64_MAX);
+    // 等待同步（监听服务器句柄和所有客户端会话）
+    Result rc = svcWaitSynchronization(&index, m_Handles, 1 + m_SessionCount, UINT64_MAX);
     if (R_FAILED(rc)) {
         m_ShouldExit = true;
         return;
     }
     
-    if (index == 0) {
-        // 接受新的客户端会话
-        Handle new_client;
-        rc = svcAcceptSession(&new_client, *m_ServerHandle);
-        if (R_FAILED(rc)) {
-            return;
-        }
-        
-        // 如果已经有客户端连接，关闭新连接（最大客户端数限制）
-        if (m_IsClientConnected) {
-            svcCloseHandle(new_client);
-            return;
-        }
-        
-        m_IsClientConnected = true;
-        *m_ClientHandle = new_client;
-        
-    } else if (index == 1) {
-        // 处理客户端消息
-        if (!m_IsClientConnected) {
-            m_ShouldExit = true;
-            return;
-        }
-        
-        s32 _idx;
-        rc = svcReplyAndReceive(&_idx, m_ClientHandle, 1, 0, UINT64_MAX);
-        if (R_FAILED(rc)) {
-            return;
-        }
-        
-        bool should_close = false;
-        CommandResult cmd_result = {false, false, false, false, false, false, false, false, false, false, false, false, false};
-        Request request = ParseRequestFromTLS();
-        
-        switch (request.type) {
-            case CmifCommandType_Request:
-                // 处理命令并获取结果
-                cmd_result = HandleCommand(request.cmd_id);
-                should_close = cmd_result.should_close_connection;
-                break;
-            case CmifCommandType_Close:
-                WriteResponseToTLS(0);
-                should_close = true;
-                break;
-            default:
-                WriteResponseToTLS(1);
-                break;
-        }
-        
-        // ✅ 先发送响应（此时服务器处于正常运行状态）
-        rc = svcReplyAndReceive(&_idx, m_ClientHandle, 0, *m_ClientHandle, 0);
-        
-        // 然后关闭连接
-        if (should_close) {
-            svcCloseHandle(*m_ClientHandle);
-            *m_ClientHandle = INVALID_HANDLE;
-            m_IsClientConnected = false;
-        }
-        
-        // 最后才执行回调逻辑（确保响应已成功发送）
-        
-        // 开启连发回调
-        if (cmd_result.should_enable_autofire) {
-            if (m_EnableAutoFireCallback) m_EnableAutoFireCallback();
-        }
-        
-        // 关闭连发回调
-        if (cmd_result.should_disable_autofire) {
-            if (m_DisableAutoFireCallback) m_DisableAutoFireCallback();
-        }
-        
-        // 开启映射回调
-        if (cmd_result.should_enable_mapping) {
-            if (m_EnableMappingCallback) m_EnableMappingCallback();
-        }
-        
-        // 关闭映射回调
-        if (cmd_result.should_disable_mapping) {
-            if (m_DisableMappingCallback) m_DisableMappingCallback();
-        }
-        
-        // 重载基础配置回调
-        if (cmd_result.should_reload_basic) {
-            if (m_ReloadBasicCallback) m_ReloadBasicCallback();
-        }
-        
-        // 重载连发配置回调
-        if (cmd_result.should_reload_autofire) {
-            if (m_ReloadAutoFireCallback) m_ReloadAutoFireCallback();
-        }
-        
-        // 重载映射配置回调
-        if (cmd_result.should_reload_mapping) {
-            if (m_ReloadMappingCallback) m_ReloadMappingCallback();
-        }
-        
-        // 开启宏回调
-        if (cmd_result.should_enable_macro) {
-            if (m_EnableMacroCallback) m_EnableMacroCallback();
-        }
-        
-        // 关闭宏回调
-        if (cmd_result.should_disable_macro) {
-            if (m_DisableMacroCallback) m_DisableMacroCallback();
-        }
-        
-        // 重载宏配置回调
-        if (cmd_result.should_reload_macro) {
-            if (m_ReloadMacroCallback) m_ReloadMacroCallback();
-        }
-        
-        // 重载白名单回调
-        if (cmd_result.should_reload_whitelist) {
-            if (m_ReloadWhitelistCallback) m_ReloadWhitelistCallback();
-        }
-        
-        // 退出服务器回调
-        if (cmd_result.should_exit_server) {
-            m_ShouldExit = true;
-            if (m_ExitCallback) m_ExitCallback();
-        }
+    if (index == 0) AcceptSession();
+    else if (index > 0 && index <= m_SessionCount) ProcessSession(index - 1);
+}
+
+// 接受新的客户端会话
+void IPCServer::AcceptSession() {
+    Handle new_client;
+    Result rc = svcAcceptSession(&new_client, *m_ServerHandle);
+    if (R_FAILED(rc)) return;
+    
+    // 会话已满，关闭新连接（最大客户端数限制）
+    if (m_SessionCount >= IPC_MAX_SESSIONS) {
+        svcCloseHandle(new_client);
+        return;
+    }
+    
+    m_SessionHandles[m_SessionCount++] = new_client;
+}
+
+// 关闭客户端会话（用最后一个会话填补空位，保持句柄数组连续）
+void IPCServer::CloseSession(s32 session) {
+    svcCloseHandle(m_SessionHandles[session]);
+    m_SessionCount--;
+    m_SessionHandles[session] = m_SessionHandles[m_SessionCount];
+    m_SessionHandles[m_SessionCount] = INVALID_HANDLE;
+}
+
+// 处理客户端消息
+void IPCServer::ProcessSession(s32 session) {
+    Handle client = m_SessionHandles[session];
+    
+    s32 _idx;
+    Result rc = svcReplyAndReceive(&_idx, &client, 1, 0, UINT64_MAX);
+    if (R_FAILED(rc)) {
+        // 客户端已断开（未发送Close就退出的情况）
+        if (rc == KERNELRESULT(ConnectionClosed)) CloseSession(session);
+        return;
+    }
+    
+    bool should_close = false;
+    CommandResult cmd_result = {false, false, false, false, false, false, false, false, false, false, false, false, false, false};
+    Request request = ParseRequestFromTLS();
+    
+    switch (request.type) {
+        case CmifCommandType_Request:
+            // 处理命令并获取结果
+            cmd_result = HandleCommand(request.cmd_id);
+            should_close = cmd_result.should_close_connection;
+            break;
+        case CmifCommandType_Close:
+            WriteResponseToTLS(0);
+            should_close = true;
+            break;
+        default:
+            WriteResponseToTLS(1);
+            break;
+    }
+    
+    // ✅ 先发送响应（此时服务器处于正常运行状态）
+    rc = svcReplyAndReceive(&_idx, &client, 0, client, 0);
+    
+    // 然后关闭连接
+    if (should_close) CloseSession(session);
+    
+    // 最后才执行回调逻辑（确保响应已成功发送）
+    DispatchCallbacks(cmd_result);
+}
+
+// 执行命令对应的回调
+void IPCServer::DispatchCallbacks(const CommandResult& cmd_result) {
+    
+    // 开启连发回调
+    if (cmd_result.should_enable_autofire) {
+        if (m_EnableAutoFireCallback) m_EnableAutoFireCallback();
+    }
+    
+    // 关闭连发回调
+    if (cmd_result.should_disable_autofire) {
+        if (m_DisableAutoFireCallback) m_DisableAutoFireCallback();
+    }
+    
+    // 开启映射回调
+    if (cmd_result.should_enable_mapping) {
+        if (m_EnableMappingCallback) m_EnableMappingCallback();
+    }
+    
+    // 关闭映射回调
+    if (cmd_result.should_disable_mapping) {
+        if (m_DisableMappingCallback) m_DisableMappingCallback();
+    }
+    
+    // 重载基础配置回调
+    if (cmd_result.should_reload_basic) {
+        if (m_ReloadBasicCallback) m_ReloadBasicCallback();
+    }
+    
+    // 重载连发配置回调
+    if (cmd_result.should_reload_autofire) {
+        if (m_ReloadAutoFireCallback) m_ReloadAutoFireCallback();
+    }
+    
+    // 重载映射配置回调
+    if (cmd_result.should_reload_mapping) {
+        if (m_ReloadMappingCallback) m_ReloadMappingCallback();
+    }
+    
+    // 开启宏回调
+    if (cmd_result.should_enable_macro) {
+        if (m_EnableMacroCallback) m_EnableMacroCallback();
+    }
+    
+    // 关闭宏回调
+    if (cmd_result.should_disable_macro) {
+        if (m_DisableMacroCallback) m_DisableMacroCallback();
+    }
+    
+    // 重载宏配置回调
+    if (cmd_result.should_reload_macro) {
+        if (m_ReloadMacroCallback) m_ReloadMacroCallback();
+    }
+    
+    // 重载白名单回调
+    if (cmd_result.should_reload_whitelist) {
+        if (m_ReloadWhitelistCallback) m_ReloadWhitelistCallback();
+    }
+    
+    // 切换映射方案回调
+    if (cmd_result.should_next_profile) {
+        if (m_NextProfileCallback) m_NextProfileCallback();
+    }
+    
+    // 退出服务器回调
+    if (cmd_result.should_exit_server) {
+        m_ShouldExit = true;
+        if (m_ExitCallback) m_ExitCallback();
     }
 }
 
 // 处理命令 - 完整处理命令逻辑，但不直接修改服务器状态
 CommandResult IPCServer::HandleCommand(u64 cmd_id) {
-    CommandResult result = {false, false, false, false, false, false, false, false, false, false, false, false, false};
+    CommandResult result = {false, false, false, false, false, false, false, false, false, false, false, false, false, false};
     
     switch (cmd_id) {
         case CMD_ENABLE_AUTOFIRE:
@@ -371,6 +415,27 @@ CommandResult IPCServer::HandleCommand(u64 cmd_id) {
             result.should_reload_whitelist = true;
             break;
             
+        case CMD_NEXT_PROFILE:
+            WriteResponseToTLS(0);
+            result.should_next_profile = true;
+            break;
+            
+        case CMD_QUERY_STATUS: {
+            // 只读查询，直接在响应中返回状态数据
+            KeyXStatus status = {};
+            status.macroIndex = -1;
+            if (m_StatusCallback) m_StatusCallback(status);
+            WriteResponseToTLS(0, &status, sizeof(status));
+            break;
+        }
+            
+        case CMD_QUERY_MEMORY: {
+            KeyXMemoryStats stats = {};
+            FillMemoryStats(stats);
+            WriteResponseToTLS(0, &stats, sizeof(stats));
+            break;
+        }
+            
         case CMD_EXIT:
             WriteResponseToTLS(0);
             result.should_close_connection = true;
@@ -416,11 +481,11 @@ IPCServer::Request IPCServer::ParseRequestFromTLS() {
     return req;
 }
 
-// 写响应到TLS
-void IPCServer::WriteResponseToTLS(Result rc) {
+// 写响应到TLS（data 紧跟在 CmifOutHeader 之后）
+void IPCServer::WriteResponseToTLS(Result rc, const void* data, size_t data_size) {
     HipcMetadata meta = {0};
     meta.type = CmifCommandType_Request;
-    meta.num_data_words = (sizeof(CmifOutHeader) + 0x10) / 4;
+    meta.num_data_words = (sizeof(CmifOutHeader) + 0x10 + ((data_size + 3) & ~3)) / 4;
     
     void* base = armGetTls();
     HipcRequest hipc = hipcMakeRequest(base, meta);
@@ -429,4 +494,6 @@ void IPCServer::WriteResponseToTLS(Result rc) {
     raw_header->magic = CMIF_OUT_HEADER_MAGIC;
     raw_header->result = rc;
     raw_header->token = 0;
+    
+    if (data && data_size) memcpy(raw_header + 1, data, data_size);
 }
\ No newline at end of file
@@ -22,9 +22,74 @@
 #define CMD_DISABLE_MACRO     9   // 关闭宏
 #define CMD_RELOAD_MACRO      10  // 重载宏配置
 
+// 状态查询（只读，不触发任何回调）
+#define CMD_QUERY_STATUS      12  // 查询运行状态
+
+// 映射方案
+#define CMD_NEXT_PROFILE      13  // 切换到下一个映射方案
+
+// 内存查询（只读）
+#define CMD_QUERY_MEMORY      14  // 查询内存池和堆的使用情况
+
 // 系统控制
 #define CMD_EXIT              999 // 退出系统模块
 
+// 最大同时连接的客户端数量（特效层 + 其他统计客户端）
+#define IPC_MAX_SESSIONS      4
+
+// 运行中的功能位（KeyXStatus::features）
+#define STATUS_FEATURE_TURBO    (1 << 0)   // 连发已开启
+#define STATUS_FEATURE_MACRO    (1 << 1)   // 宏已开启
+#define STATUS_FEATURE_MAPPING  (1 << 2)   // 映射已开启
+#define STATUS_FEATURE_FOCUS    (1 << 3)   // 游戏在前台
+#define STATUS_FEATURE_RUNNING  (1 << 4)   // 按键线程运行中
+#define STATUS_FEATURE_PAUSED   (1 << 5)   // 按键线程已暂停
+
+// 运行状态（CMD_QUERY_STATUS 的返回数据，与 ovl-KeyX 保持一致）
+struct KeyXStatus {
+    u64 tid;                // 当前游戏 TID（无游戏为0）
+    u32 features;           // 功能位（STATUS_FEATURE_*）
+    u8  controllerType;     // 手柄类型（0=无, 1=Pro, 2=双JoyCon, 3=SystemExt, 4=JoyCon, 5=Lite）
+    u8  turboActive;        // 连发是否正在执行
+    u8  turboPressed;       // 连发当前处于按下周期
+    u8  macroPlaying;       // 宏是否正在播放
+    s32 macroIndex;         // 正在播放的宏索引（-1=无）
+    u32 macroFrameIndex;    // 宏当前帧
+    u32 macroFrameCount;    // 宏总帧数
+    u32 pollIntervalMs;     // 当前游戏状态检测间隔（焦点变化检测延迟的上限）
+    u64 loopTicks;          // 按键线程循环次数
+    u64 injectTicks;        // 按键线程注入次数
+    u32 launchLatencyUs;    // 上次游戏启动：检测轮询被唤醒 → 功能生效的耗时（不含之前最多 pollIntervalMs 的等待）
+    u32 focusLatencyUs;     // 上次焦点变化：检测轮询被唤醒 → 暂停/恢复生效的耗时（同上）
+    u32 hotplugLatencyUs;   // 上次手柄连接：连接事件唤醒主循环 → 映射生效的耗时
+    u8  remapProfile;       // 当前映射方案（0=默认 [MAPPING]）
+    u8  remapProfileCount;  // 映射方案数量
+    u32 allocViolations;    // 按键线程中的堆分配次数（仅 ALLOC_TRIPWIRE 调试构建统计）
+    u8  inputPriority;      // 按键线程优先级
+    s8  inputCore;          // 按键线程核心（-2=默认）
+    u32 wakeSamples;        // 按键线程唤醒次数（本次游戏）
+    u32 wakeJitterP50Us;    // 唤醒延迟 p50（比预定时间晚多少）
+    u32 wakeJitterP99Us;    // 唤醒延迟 p99
+    u32 wakeJitterMaxUs;    // 唤醒延迟最大值
+} __attribute__((packed));
+
+// 单个内存池的统计
+struct KeyXPoolStats {
+    u32 capacity;           // 预算上限
+    u32 used;               // 当前使用
+    u32 peak;               // 历史峰值
+    u32 failures;           // 超出预算的分配次数
+} __attribute__((packed));
+
+// 内存统计（CMD_QUERY_MEMORY 的返回数据，与 ovl-KeyX 保持一致）
+#define KEYX_MEMPOOL_COUNT  3
+struct KeyXMemoryStats {
+    KeyXPoolStats pools[KEYX_MEMPOOL_COUNT];   // 0=宏帧数据, 1=配置, 2=日志
+    u32 heapCapacity;       // 堆大小
+    u32 heapUsed;           // 堆当前已分配
+    u32 heapPeak;           // 堆已向系统申请的总量（只增不减）
+} __attribute__((packed));
+
 // IPC命令处理结果
 struct CommandResult {
     bool should_close_connection;   // 是否需要关闭客户端连接
@@ -40,19 +105,23 @@ struct CommandResult {
     bool should_disable_macro;      // 是否需要关闭宏（在响应发送后）
     bool should_reload_macro;       // 是否需要重载宏配置（在响应发送后）
     bool should_reload_whitelist;   // 是否需要重载白名单（在响应发送后）
+    bool should_next_profile;       // 是否需要切换映射方案（在响应发送后）
 };
 
+// 状态查询回调（在IPC线程中同步调用，只允许读取状态）
+using StatusCallback = std::function<void(KeyXStatus&)>;
+
 // IPC服务器类
 class IPCServer {
 private:
-    // 句柄和服务名
-    Handle m_Handles[2];
+    // 句柄和服务名（0号为服务器句柄，其后为各客户端会话）
+    Handle m_Handles[1 + IPC_MAX_SESSIONS];
     SmServiceName m_ServerName;
     Handle* const m_ServerHandle = &m_Handles[0];
-    Handle* const m_ClientHandle = &m_Handles[1];
+    Handle* const m_SessionHandles = &m_Handles[1];
     
     // 状态变量
-    bool m_IsClientConnected = false;
+    s32 m_SessionCount = 0;
     volatile bool m_ShouldExit = false;
     
     // 线程相关
@@ -74,11 +143,17 @@ private:
     std::function<void()> m_DisableMacroCallback;     // 关闭宏回调
     std::function<void()> m_ReloadMacroCallback;      // 重载宏配置回调
     std::function<void()> m_ReloadWhitelistCallback;  // 重载白名单回调
+    std::function<void()> m_NextProfileCallback;      // 切换映射方案回调
+    StatusCallback m_StatusCallback;                  // 状态查询回调
     
     // 内部方法
     void StartServer();
     void StopServer();
     void WaitAndProcessRequest();
+    void AcceptSession();
+    void ProcessSession(s32 session);
+    void CloseSession(s32 session);
+    void DispatchCallbacks(const CommandResult& cmd_result);
     CommandResult HandleCommand(u64 cmd_id);
     
     // 请求解析和响应
@@ -90,7 +165,7 @@ private:
     };
     
     Request ParseRequestFromTLS();
-    void WriteResponseToTLS(Result rc);
+    void WriteResponseToTLS(Result rc, const void* data = nullptr, size_t data_size = 0);
     
     // 静态线程入口函数
     static void ThreadEntry(void* arg);
@@ -118,5 +193,7 @@ public:
     void SetDisableMacroCallback(std::function<void()> callback);
     void SetReloadMacroCallback(std::function<void()> callback);
     void SetReloadWhitelistCallback(std::function<void()> callback);
+    void SetNextProfileCallback(std::function<void()> callback);
+    void SetStatusCallback(StatusCallback callback);
     bool ShouldExit() const { return m_ShouldExit; }
 };
\ No newline at end of file
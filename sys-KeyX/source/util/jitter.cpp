@@ -0,0 +1,35 @@
+#include "jitter.hpp"
+
+// 清空统计
+void WakeJitter::Reset() {
+    for (auto& bucket : m_Buckets) bucket.store(0, std::memory_order_relaxed);
+    m_Samples.store(0, std::memory_order_relaxed);
+    m_MaxNs.store(0, std::memory_order_relaxed);
+}
+
+// 记录一次唤醒延迟（只有按键线程写，读改写不需要原子指令）
+void WakeJitter::Record(u64 late_ns) {
+    u64 bucket = late_ns / BUCKET_NS;
+    if (bucket > BUCKET_COUNT) bucket = BUCKET_COUNT;
+    m_Buckets[bucket].store(m_Buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_Samples.store(m_Samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (late_ns > m_MaxNs.load(std::memory_order_relaxed)) m_MaxNs.store(late_ns, std::memory_order_relaxed);
+}
+
+// 分位数（在直方图的快照上计算，样本数取快照中各桶之和，与记录同时进行也不会越界或前后不一致）
+u32 WakeJitter::PercentileUs(u32 percent) const {
+    u32 buckets[BUCKET_COUNT + 1];
+    u64 samples = 0;
+    for (int i = 0; i <= BUCKET_COUNT; i++) {
+        buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+        samples += buckets[i];
+    }
+    if (samples == 0) return 0;
+    u64 target = (samples * percent + 99) / 100;
+    u64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= target) return (u32)((i + 1) * BUCKET_NS / 1000);
+    }
+    return MaxUs();
+}
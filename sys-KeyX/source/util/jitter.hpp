@@ -0,0 +1,34 @@
+#pragma once
+#include <switch.h>
+#include <atomic>
+
+// 线程唤醒抖动统计（实际唤醒比预期晚了多久）
+// 用直方图统计，记录是常数时间，查询时再计算分位数
+// 只有按键线程记录，状态查询在 IPC 线程读取：计数都是原子变量，查询时先把直方图复制一份再计算
+class WakeJitter {
+public:
+    WakeJitter() { Reset(); }
+    
+    // 清空统计（只在没有线程记录时调用）
+    void Reset();
+    
+    // 记录一次唤醒延迟（纳秒）
+    void Record(u64 late_ns);
+    
+    // 分位数（微秒，按桶上界估算；percent=50/99等）
+    u32 PercentileUs(u32 percent) const;
+    
+    // 最大延迟（微秒）
+    u32 MaxUs() const { return m_MaxNs.load(std::memory_order_relaxed) / 1000; }
+    
+    // 样本数
+    u32 Samples() const { return m_Samples.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int BUCKET_COUNT = 64;         // 64个桶
+    static constexpr u64 BUCKET_NS = 25000;         // 每桶25us，覆盖0-1.6ms，超出的计入最后一个桶
+    
+    std::atomic<u32> m_Buckets[BUCKET_COUNT + 1];
+    std::atomic<u32> m_Samples;
+    std::atomic<u64> m_MaxNs;
+};
@@ -0,0 +1,58 @@
+#include "mempool.h"
+
+// 各池预算
+#ifndef MEMPOOL_MACRO_SIZE
+#define MEMPOOL_MACRO_SIZE  0x30000                             // 192KB：宏帧窗口，V2宏约7000帧，更长的宏播放中分段读入
+#endif
+#define MEMPOOL_CONFIG_SIZE 0x2000                              // 8KB
+#define MEMPOOL_LOG_SIZE    0x6000                              // 24KB：512条事件记录 + 格式化缓冲区
+
+// 单个内存池
+typedef struct {
+    u8 *base;                                                   // 起始地址
+    u32 capacity;                                               // 预算上限
+    u32 used;                                                   // 当前使用
+    u32 peak;                                                   // 历史峰值
+    u32 failures;                                               // 超出预算的分配次数
+} MemPool;
+
+static u8 g_macro_mem[MEMPOOL_MACRO_SIZE] __attribute__((aligned(16)));
+static u8 g_config_mem[MEMPOOL_CONFIG_SIZE] __attribute__((aligned(16)));
+static u8 g_log_mem[MEMPOOL_LOG_SIZE] __attribute__((aligned(16)));
+
+static MemPool g_pools[MEMPOOL_COUNT] = {
+    { g_macro_mem,  MEMPOOL_MACRO_SIZE,  0, 0, 0 },
+    { g_config_mem, MEMPOOL_CONFIG_SIZE, 0, 0, 0 },
+    { g_log_mem,    MEMPOOL_LOG_SIZE,    0, 0, 0 },
+};
+
+// 从指定池分配内存
+void* mempool_alloc(MemPoolId pool, size_t size) {
+    if (pool >= MEMPOOL_COUNT) return NULL;
+    MemPool *p = &g_pools[pool];
+    size_t aligned = (size + 7) & ~(size_t)7;
+    if (aligned > p->capacity - p->used) {
+        p->failures++;
+        return NULL;
+    }
+    void *ptr = p->base + p->used;
+    p->used += aligned;
+    if (p->used > p->peak) p->peak = p->used;
+    return ptr;
+}
+
+// 释放指定池的全部内存
+void mempool_reset(MemPoolId pool) {
+    if (pool >= MEMPOOL_COUNT) return;
+    g_pools[pool].used = 0;
+}
+
+// 获取指定池的统计
+void mempool_stats(MemPoolId pool, u32* capacity, u32* used, u32* peak, u32* failures) {
+    if (pool >= MEMPOOL_COUNT) return;
+    const MemPool *p = &g_pools[pool];
+    if (capacity) *capacity = p->capacity;
+    if (used) *used = p->used;
+    if (peak) *peak = p->peak;
+    if (failures) *failures = p->failures;
+}
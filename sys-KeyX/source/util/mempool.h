@@ -0,0 +1,33 @@
+#pragma once
+#include <switch.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------
+// 分子系统的固定内存池
+// 每个池是一块独立的静态内存，按预算上限线性分配，由唯一的使用者整体重置，
+// 某个子系统用超预算只会让自己分配失败，不会挤占其他子系统和堆
+// ---------------------------------------------------------------------------
+
+// 内存池ID（顺序与 KeyXMemoryStats::pools 一致）
+typedef enum {
+    MEMPOOL_MACRO   = 0,    // 宏帧数据（每次加载宏文件时重置）
+    MEMPOOL_CONFIG  = 1,    // 配置数据（宏列表等，每次加载配置时重置）
+    MEMPOOL_LOG     = 2,    // 日志环形缓冲区（开启事件记录时分配）
+    MEMPOOL_COUNT
+} MemPoolId;
+
+// 从指定池分配内存（8字节对齐，超出预算返回NULL并计数）
+void* mempool_alloc(MemPoolId pool, size_t size);
+
+// 释放指定池的全部内存
+void mempool_reset(MemPoolId pool);
+
+// 获取指定池的统计（容量、当前使用、历史峰值、分配失败次数）
+void mempool_stats(MemPoolId pool, u32* capacity, u32* used, u32* peak, u32* failures);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+#include "threadcfg.hpp"
+#include <cstdio>
+#include <minIni.h>
+
+// 默认值：按键线程固定在系统核心（核心3）且优先级最高，
+// IPC线程优先级低于按键线程，避免处理请求时推迟按键注入；
+// 宏文件读取线程优先级最低，只在按键线程休眠时读卡
+ThreadSetting ThreadConfig::s_Input = {40, 3};
+ThreadSetting ThreadConfig::s_Ipc = {46, 3};
+ThreadSetting ThreadConfig::s_Monitor = {44, 3};
+ThreadSetting ThreadConfig::s_Reader = {50, 3};
+
+// 读取单个线程的设置
+ThreadSetting ThreadConfig::LoadSetting(const char* config_path, const char* name, ThreadSetting def) {
+    char key[32];
+    ThreadSetting setting;
+    snprintf(key, sizeof(key), "%s_priority", name);
+    setting.priority = ini_getl("THREAD", key, def.priority, config_path);
+    snprintf(key, sizeof(key), "%s_core", name);
+    setting.core = ini_getl("THREAD", key, def.core, config_path);
+    if (setting.priority < MIN_PRIORITY || setting.priority > MAX_PRIORITY) setting.priority = def.priority;
+    if (setting.core != -2 && (setting.core < MIN_CORE || setting.core > MAX_CORE)) setting.core = def.core;
+    return setting;
+}
+
+// 读取配置
+void ThreadConfig::Load(const char* config_path) {
+    s_Input = LoadSetting(config_path, "input", s_Input);
+    s_Ipc = LoadSetting(config_path, "ipc", s_Ipc);
+    s_Monitor = LoadSetting(config_path, "monitor", s_Monitor);
+    s_Reader = LoadSetting(config_path, "reader", s_Reader);
+}
+
+// 将设置应用到当前线程
+void ThreadConfig::ApplyToCurrentThread(const ThreadSetting& setting) {
+    svcSetThreadPriority(CUR_THREAD_HANDLE, setting.priority);
+    if (setting.core >= 0) svcSetThreadCoreMask(CUR_THREAD_HANDLE, setting.core, 1ULL << setting.core);
+}
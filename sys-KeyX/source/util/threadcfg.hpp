@@ -0,0 +1,41 @@
+#pragma once
+#include <switch.h>
+
+// 线程的优先级和核心设置
+struct ThreadSetting {
+    int priority;   // 优先级（24-63，数值越小越优先）
+    int core;       // 运行核心（npdm 只允许核心3，核心0-2留给游戏；-2表示使用默认核心）
+};
+
+// 线程配置（从 config.ini 的 [THREAD] 节读取，重启系统模块后生效）
+// input_priority / input_core      按键线程
+// ipc_priority / ipc_core          IPC线程
+// monitor_priority / monitor_core  主线程（游戏状态检测）
+// reader_priority / reader_core    宏文件读取线程（播放中读入下一个帧窗口）
+class ThreadConfig {
+public:
+    // 读取配置（超出 npdm 允许范围的值会被修正）
+    static void Load(const char* config_path);
+    
+    static const ThreadSetting& Input() { return s_Input; }
+    static const ThreadSetting& Ipc() { return s_Ipc; }
+    static const ThreadSetting& Monitor() { return s_Monitor; }
+    static const ThreadSetting& Reader() { return s_Reader; }
+    
+    // 将设置应用到当前线程（主线程由系统创建，只能事后调整）
+    static void ApplyToCurrentThread(const ThreadSetting& setting);
+
+private:
+    // npdm 中允许的范围
+    static constexpr int MIN_PRIORITY = 24;
+    static constexpr int MAX_PRIORITY = 63;
+    static constexpr int MIN_CORE = 3;
+    static constexpr int MAX_CORE = 3;
+    
+    static ThreadSetting LoadSetting(const char* config_path, const char* name, ThreadSetting def);
+    
+    static ThreadSetting s_Input;
+    static ThreadSetting s_Ipc;
+    static ThreadSetting s_Monitor;
+    static ThreadSetting s_Reader;
+};
@@ -0,0 +1,125 @@
+// 焦点事件回放测试：按用例构造 pdm 游玩事件历史（含成批的其他程序事件、非 applet 事件造成的索引空洞、历史轮换），
+// 在指定时刻调用 FocusMonitor::GetState 并检查返回的焦点变化
+//
+// 用法：focus_trace <用例.txt>   输出一行 PASS/FAIL，失败时返回1
+//
+// 用例格式（每行一条，# 开头为注释，数值支持 0x 十六进制）：
+//   applet <tid> <in|out|out4|launch|exit>     追加一个 applet 事件
+//   play <数量>                                 追加若干个非 applet 的游玩事件（只占用索引）
+//   burst <数量> <tid>                          追加若干个其他程序交替的 in/out 事件
+//   rotate <数量>                               最旧的若干个事件被轮换出历史
+//   poll <tid> <unknown|in|out>                 调用 GetState 并检查结果
+#include "focus.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+    struct PlayEvent {
+        bool applet;
+        PdmAppletEvent event;
+    };
+
+    std::vector<PlayEvent> s_history;   // 下标即 entry_index
+    s32 s_start = 0;                    // 历史中最旧的可用索引
+    u32 s_queries = 0;                  // QueryAppletEvent 调用次数
+
+    void addApplet(u64 tid, u8 type) {
+        PlayEvent e{};
+        e.applet = true;
+        e.event.program_id = tid;
+        e.event.entry_index = s_history.size();
+        e.event.event_type = type;
+        s_history.push_back(e);
+    }
+
+    bool parseType(const char* text, u8& type) {
+        if (!strcmp(text, "in")) type = PdmAppletEventType_InFocus;
+        else if (!strcmp(text, "out")) type = PdmAppletEventType_OutOfFocus;
+        else if (!strcmp(text, "out4")) type = PdmAppletEventType_OutOfFocus4;
+        else if (!strcmp(text, "launch")) type = PdmAppletEventType_Launch;
+        else if (!strcmp(text, "exit")) type = PdmAppletEventType_Exit;
+        else return false;
+        return true;
+    }
+
+    const char* stateName(FocusState state) {
+        return state == FocusState::InFocus ? "in" : state == FocusState::OutOfFocus ? "out" : "unknown";
+    }
+
+    bool runCase(const char* path) {
+        FILE* fp = fopen(path, "r");
+        if (!fp) {
+            printf("FAIL %s（无法打开）\n", path);
+            return false;
+        }
+        bool ok = true;
+        char line[256];
+        int lineNo = 0;
+        while (fgets(line, sizeof(line), fp)) {
+            lineNo++;
+            char cmd[16], a[32], b[32];
+            int n = sscanf(line, "%15s %31s %31s", cmd, a, b);
+            if (n <= 0 || cmd[0] == '#') continue;
+            u8 type;
+            if (!strcmp(cmd, "applet") && n == 3 && parseType(b, type)) {
+                addApplet(strtoull(a, nullptr, 0), type);
+            }
+            else if (!strcmp(cmd, "play") && n >= 2) {
+                for (long i = strtol(a, nullptr, 0); i > 0; i--) s_history.push_back({});
+            }
+            else if (!strcmp(cmd, "burst") && n == 3) {
+                u64 tid = strtoull(b, nullptr, 0);
+                for (long i = strtol(a, nullptr, 0); i > 0; i--) {
+                    addApplet(tid, (i % 2) ? PdmAppletEventType_InFocus : PdmAppletEventType_OutOfFocus);
+                }
+            }
+            else if (!strcmp(cmd, "rotate") && n >= 2) {
+                s_start += strtol(a, nullptr, 0);
+            }
+            else if (!strcmp(cmd, "poll") && n == 3) {
+                FocusState state = FocusMonitor::GetState(strtoull(a, nullptr, 0));
+                if (strcmp(stateName(state), b) != 0) {
+                    printf("  %s:%d: 期望 %s，实际 %s\n", path, lineNo, b, stateName(state));
+                    ok = false;
+                }
+            }
+            else {
+                printf("  %s:%d: 无法解析：%s", path, lineNo, line);
+                ok = false;
+            }
+        }
+        fclose(fp);
+        printf("%s %s（%u 次事件查询）\n", ok ? "PASS" : "FAIL", path, s_queries);
+        return ok;
+    }
+}
+
+Result pdmqryGetAvailablePlayEventRange(s32* total, s32* start_index, s32* end_index) {
+    s32 end = (s32)s_history.size() - 1;
+    *start_index = s_start;
+    *end_index = end < s_start ? s_start : end;
+    *total = end < s_start ? 0 : end - s_start + 1;
+    return 0;
+}
+
+// 从 entry_index 开始返回最多 count 个 applet 事件（跳过非 applet 事件）；索引已被轮换出历史时返回错误
+Result pdmqryQueryAppletEvent(s32 entry_index, bool, PdmAppletEvent* events, s32 count, s32* total_out) {
+    s_queries++;
+    *total_out = 0;
+    if (entry_index < s_start) return 1;
+    for (size_t i = entry_index; i < s_history.size() && *total_out < count; i++) {
+        if (s_history[i].applet) events[(*total_out)++] = s_history[i].event;
+    }
+    return 0;
+}
+
+// 每个用例在单独的进程中运行（FocusMonitor 是全静态的）
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "用法：%s <用例.txt>\n", argv[0]);
+        return 2;
+    }
+    return runCase(argv[1]) ? 0 : 1;
+}
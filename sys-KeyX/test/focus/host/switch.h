@@ -0,0 +1,46 @@
+// 焦点事件回放测试用的 libnx 替身：只提供 FocusMonitor 用到的 pdmqry 类型与函数，事件历史由回放代码控制
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u32 Result;
+
+#define R_SUCCEEDED(rc) ((rc) == 0)
+#define R_FAILED(rc)    ((rc) != 0)
+
+typedef enum {
+    PdmAppletEventType_Launch       = 0,
+    PdmAppletEventType_Exit         = 1,
+    PdmAppletEventType_InFocus      = 2,
+    PdmAppletEventType_OutOfFocus   = 3,
+    PdmAppletEventType_OutOfFocus4  = 4,
+} PdmAppletEventType;
+
+typedef struct {
+    u64 program_id;
+    u32 entry_index;
+    u32 timestamp_user;
+    u32 timestamp_network;
+    u8 event_type;
+    u8 pad[3];
+} PdmAppletEvent;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+Result pdmqryGetAvailablePlayEventRange(s32* total, s32* start_index, s32* end_index);
+Result pdmqryQueryAppletEvent(s32 entry_index, bool flag, PdmAppletEvent* events, s32 count, s32* total_out);
+
+#ifdef __cplusplus
+}
+#endif
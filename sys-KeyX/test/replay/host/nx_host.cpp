@@ -0,0 +1,149 @@
+// 回放测试用的 libnx 替身：文件系统用 stdio 实现，HID/HDLS 由回放代码控制
+#include <switch.h>
+#include "log.h"
+#include <cstdio>
+#include <string>
+
+namespace {
+    std::string s_root = ".";
+    FsFileSystem s_sdmc;
+
+    u64 s_tick = 0;
+    bool s_handheld = false;
+    HidNpadCommonState s_input = {};
+    bool s_injected = false;
+    HiddbgHdlsState s_injectedState = {};
+
+    size_t readInput(HidNpadCommonState* states, size_t count) {
+        if (count == 0) return 0;
+        states[0] = s_input;
+        states[0].attributes = HidNpadAttribute_IsConnected;
+        return 1;
+    }
+}
+
+void host_set_sdmc_root(const char* root) {
+    s_root = root;
+}
+
+FsFileSystem* fsdevGetDeviceFileSystem(const char*) {
+    return &s_sdmc;
+}
+
+Result fsFsOpenFile(FsFileSystem*, const char* path, u32, FsFile* out) {
+    out->fp = fopen((s_root + path).c_str(), "rb");
+    return out->fp ? 0 : 1;
+}
+
+Result fsFileGetSize(FsFile* f, s64* out) {
+    FILE* fp = (FILE*)f->fp;
+    long pos = ftell(fp);
+    fseek(fp, 0, SEEK_END);
+    *out = ftell(fp);
+    fseek(fp, pos, SEEK_SET);
+    return 0;
+}
+
+Result fsFileRead(FsFile* f, s64 off, void* buf, u64 size, u32, u64* bytesRead) {
+    FILE* fp = (FILE*)f->fp;
+    if (fseek(fp, off, SEEK_SET) != 0) return 1;
+    *bytesRead = fread(buf, 1, size, fp);
+    return 0;
+}
+
+void fsFileClose(FsFile* f) {
+    if (f->fp) fclose((FILE*)f->fp);
+    f->fp = nullptr;
+}
+
+// 时间与线程
+void host_set_tick(u64 tick) {
+    s_tick = tick;
+}
+
+u64 armGetSystemTick(void) {
+    return s_tick;
+}
+
+Result threadCreate(Thread*, ThreadFunc, void*, void*, size_t, int, int) {
+    return 1;
+}
+
+Result threadStart(Thread*) { return 1; }
+Result threadWaitForExit(Thread*) { return 0; }
+Result threadClose(Thread*) { return 0; }
+void svcSleepThread(s64) {}
+Result svcSetThreadPriority(Handle, u32) { return 0; }
+Result svcSetThreadCoreMask(Handle, s32, u32) { return 0; }
+
+void ueventCreate(UEvent* e, bool auto_clear) { *e = {0, auto_clear}; }
+void ueventSignal(UEvent* e) { e->signaled = 1; }
+Waiter waiterForUEvent(UEvent* e) { return {0, e}; }
+Result waitSingle(Waiter, s64) { return 0; }
+
+// 日志事件不记录
+void log_event(u32, u32, u64, u64) {}
+
+// 物理输入：Pro 手柄接在1号位，或者 Lite 掌机
+void host_set_handheld(bool handheld) {
+    s_handheld = handheld;
+}
+
+void host_set_input(u64 buttons, HidAnalogStickState l, HidAnalogStickState r) {
+    s_input.buttons = buttons;
+    s_input.analog_stick_l = l;
+    s_input.analog_stick_r = r;
+}
+
+u32 hidGetNpadStyleSet(HidNpadIdType id) {
+    if (id == HidNpadIdType_Handheld) return s_handheld ? HidNpadStyleTag_NpadHandheld : 0;
+    return s_handheld ? 0 : HidNpadStyleTag_NpadFullKey;
+}
+
+Result hidGetNpadInterfaceType(HidNpadIdType, u8* out) {
+    *out = HidNpadInterfaceType_Bluetooth;  // Lite 不是导轨连接
+    return 0;
+}
+
+size_t hidGetNpadStatesFullKey(HidNpadIdType, HidNpadFullKeyState* states, size_t count) { return readInput(states, count); }
+size_t hidGetNpadStatesHandheld(HidNpadIdType, HidNpadHandheldState* states, size_t count) { return readInput(states, count); }
+size_t hidGetNpadStatesJoyDual(HidNpadIdType, HidNpadJoyDualState* states, size_t count) { return readInput(states, count); }
+size_t hidGetNpadStatesSystemExt(HidNpadIdType, HidNpadSystemExtState* states, size_t count) { return readInput(states, count); }
+
+// HDLS：只有一个虚拟设备（Pro 为 FullKey3，Lite 为 DebugPad），记录最后一次注入
+Result hiddbgAttachHdlsWorkBuffer(HiddbgHdlsSessionId* session_id, void*, size_t) {
+    session_id->id = 1;
+    return 0;
+}
+
+Result hiddbgReleaseHdlsWorkBuffer(HiddbgHdlsSessionId) {
+    return 0;
+}
+
+Result hiddbgDumpHdlsStates(HiddbgHdlsSessionId, HiddbgHdlsStateList* state) {
+    *state = {};
+    state->total_entries = 1;
+    state->entries[0].handle.handle = 1;
+    state->entries[0].device.deviceType = s_handheld ? HidDeviceType_DebugPad : HidDeviceType_FullKey3;
+    return 0;
+}
+
+Result hiddbgApplyHdlsStateList(HiddbgHdlsSessionId, const HiddbgHdlsStateList* state) {
+    if (state->total_entries == 0) return 0;
+    s_injected = true;
+    s_injectedState = state->entries[0].state;
+    return 0;
+}
+
+Result hiddbgSetHdlsState(HiddbgHdlsHandle, const HiddbgHdlsState* state) {
+    s_injected = true;
+    s_injectedState = *state;
+    return 0;
+}
+
+bool host_take_injected(HiddbgHdlsState* out) {
+    if (!s_injected) return false;
+    s_injected = false;
+    *out = s_injectedState;
+    return true;
+}
@@ -0,0 +1,150 @@
+// 回放测试用的 libnx 替身：只提供按键线程（AutoKeyLoop 及连发、宏、软件映射模块）用到的类型与函数，在电脑上编译
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u32 Result;
+typedef u32 Handle;
+
+#define R_SUCCEEDED(rc) ((rc) == 0)
+#define R_FAILED(rc)    ((rc) != 0)
+#define BITL(n)         (1ULL << (n))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 系统tick（与主机一致的 19.2MHz）
+#define HOST_TICK_FREQ  19200000ULL
+static inline u64 armGetSystemTickFreq(void) { return HOST_TICK_FREQ; }
+static inline u64 armTicksToNs(u64 tick) { return (tick * 625) / 12; }
+static inline u64 armNsToTicks(u64 ns) { return (ns * 12) / 625; }
+u64 armGetSystemTick(void);
+
+// 线程与服务（threadCreate 总是失败，AutoKeyLoop 不会启动按键线程，由回放代码调用 Tick）
+typedef struct { u8 x[0x1C0]; } Thread;
+typedef struct { char name[8]; } SmServiceName;
+typedef void (*ThreadFunc)(void*);
+#define CUR_THREAD_HANDLE 0xFFFF8000
+Result threadCreate(Thread* t, ThreadFunc entry, void* arg, void* stack_mem, size_t stack_sz, int prio, int cpuid);
+Result threadStart(Thread* t);
+Result threadWaitForExit(Thread* t);
+Result threadClose(Thread* t);
+void svcSleepThread(s64 nano);
+Result svcSetThreadPriority(Handle handle, u32 priority);
+Result svcSetThreadCoreMask(Handle handle, s32 preferred_core, u32 affinity_mask);
+
+// 用户态事件（读取线程不会启动，只需要能编译）
+typedef struct { u32 signaled; bool auto_clear; } UEvent;
+typedef struct { u32 type; void* object; } Waiter;
+void ueventCreate(UEvent* e, bool auto_clear);
+void ueventSignal(UEvent* e);
+Waiter waiterForUEvent(UEvent* e);
+Result waitSingle(Waiter w, s64 timeout);
+
+// 按键与摇杆
+typedef struct { s32 x, y; } HidAnalogStickState;
+typedef enum {
+    HidNpadButton_A = BITL(0), HidNpadButton_B = BITL(1), HidNpadButton_X = BITL(2), HidNpadButton_Y = BITL(3),
+    HidNpadButton_StickL = BITL(4), HidNpadButton_StickR = BITL(5), HidNpadButton_L = BITL(6), HidNpadButton_R = BITL(7),
+    HidNpadButton_ZL = BITL(8), HidNpadButton_ZR = BITL(9), HidNpadButton_Plus = BITL(10), HidNpadButton_Minus = BITL(11),
+    HidNpadButton_Left = BITL(12), HidNpadButton_Up = BITL(13), HidNpadButton_Right = BITL(14), HidNpadButton_Down = BITL(15),
+} HidNpadButton;
+
+// 手柄状态（只有1号手柄和掌机模式）
+typedef enum { HidNpadIdType_No1 = 0, HidNpadIdType_Handheld = 0x20 } HidNpadIdType;
+typedef enum {
+    HidNpadStyleTag_NpadFullKey = BITL(0), HidNpadStyleTag_NpadHandheld = BITL(1),
+    HidNpadStyleTag_NpadJoyDual = BITL(2), HidNpadStyleTag_NpadSystemExt = BITL(29),
+} HidNpadStyleTag;
+typedef enum { HidNpadAttribute_IsConnected = BITL(0) } HidNpadAttribute;
+typedef enum { HidNpadInterfaceType_Bluetooth = 1, HidNpadInterfaceType_Rail = 2 } HidNpadInterfaceType;
+typedef struct {
+    u64 sampling_number;
+    u64 buttons;
+    HidAnalogStickState analog_stick_l;
+    HidAnalogStickState analog_stick_r;
+    u32 attributes;
+    u32 reserved;
+} HidNpadCommonState;
+typedef HidNpadCommonState HidNpadFullKeyState;
+typedef HidNpadCommonState HidNpadHandheldState;
+typedef HidNpadCommonState HidNpadJoyDualState;
+typedef HidNpadCommonState HidNpadSystemExtState;
+
+u32 hidGetNpadStyleSet(HidNpadIdType id);
+Result hidGetNpadInterfaceType(HidNpadIdType id, u8* out);
+size_t hidGetNpadStatesFullKey(HidNpadIdType id, HidNpadFullKeyState* states, size_t count);
+size_t hidGetNpadStatesHandheld(HidNpadIdType id, HidNpadHandheldState* states, size_t count);
+size_t hidGetNpadStatesJoyDual(HidNpadIdType id, HidNpadJoyDualState* states, size_t count);
+size_t hidGetNpadStatesSystemExt(HidNpadIdType id, HidNpadSystemExtState* states, size_t count);
+
+// HDLS 虚拟手柄注入
+typedef enum {
+    HidDeviceType_JoyRight1 = 1, HidDeviceType_JoyLeft2 = 2, HidDeviceType_FullKey3 = 3,
+    HidDeviceType_JoyLeft4 = 4, HidDeviceType_JoyRight5 = 5, HidDeviceType_DebugPad = 17,
+    HidDeviceType_LarkHvcLeft = 19, HidDeviceType_LarkHvcRight = 20,
+    HidDeviceType_LarkNesLeft = 21, HidDeviceType_LarkNesRight = 22,
+} HidDeviceType;
+typedef struct { u64 id; } HiddbgHdlsSessionId;
+typedef struct { u64 handle; } HiddbgHdlsHandle;
+typedef struct { u8 deviceType; u8 npadInterfaceType; u8 pad[0x16]; } HiddbgHdlsDeviceInfo;
+typedef struct {
+    u8 battery_level;
+    u32 flags;
+    u64 buttons;
+    HidAnalogStickState analog_stick_l;
+    HidAnalogStickState analog_stick_r;
+    u8 indicator;
+} HiddbgHdlsState;
+typedef struct {
+    HiddbgHdlsHandle handle;
+    HiddbgHdlsDeviceInfo device;
+    HiddbgHdlsState state;
+} HiddbgHdlsStateListEntry;
+typedef struct {
+    s32 total_entries;
+    u32 pad;
+    HiddbgHdlsStateListEntry entries[0x10];
+} HiddbgHdlsStateList;
+
+Result hiddbgAttachHdlsWorkBuffer(HiddbgHdlsSessionId* session_id, void* buffer, size_t size);
+Result hiddbgReleaseHdlsWorkBuffer(HiddbgHdlsSessionId session_id);
+Result hiddbgDumpHdlsStates(HiddbgHdlsSessionId session_id, HiddbgHdlsStateList* state);
+Result hiddbgApplyHdlsStateList(HiddbgHdlsSessionId session_id, const HiddbgHdlsStateList* state);
+Result hiddbgSetHdlsState(HiddbgHdlsHandle handle, const HiddbgHdlsState* state);
+
+// 文件系统（sdmc 映射到 host_set_sdmc_root 指定的目录）
+typedef struct { int unused; } FsFileSystem;
+typedef struct { void* fp; } FsFile;
+typedef enum { FsOpenMode_Read = 1 } FsOpenMode;
+typedef enum { FsReadOption_None = 0 } FsReadOption;
+
+FsFileSystem* fsdevGetDeviceFileSystem(const char* name);
+Result fsFsOpenFile(FsFileSystem* fs, const char* path, u32 mode, FsFile* out);
+Result fsFileGetSize(FsFile* f, s64* out);
+Result fsFileRead(FsFile* f, s64 off, void* buf, u64 size, u32 option, u64* bytesRead);
+void fsFileClose(FsFile* f);
+
+void host_set_sdmc_root(const char* root);
+
+// 回放控制：当前时间、手柄类型（Pro 或 Lite 掌机）、物理输入
+void host_set_tick(u64 tick);
+void host_set_handheld(bool handheld);
+void host_set_input(u64 buttons, HidAnalogStickState l, HidAnalogStickState r);
+
+// 取出上次调用以来注入的状态（没有注入返回 false）
+bool host_take_injected(HiddbgHdlsState* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,424 @@
+// 按键线程回放测试：把录制好的输入时间线经替身 HID 逐帧送入 AutoKeyLoop，输出 HDLS 注入结果与金样文件比对
+//
+// 用法：
+//   replay <用例.txt>                 输出回放结果（与 <用例>.golden 比对）
+//   replay --bench <次数> <用例.txt>  重复回放，输出每帧平均处理耗时和边沿时间误差
+//   replay --bench-mapping <次数>     Lite 连发注入（每帧都经过逆映射），输出 0/4/16 个按键映射时每帧的处理耗时
+//
+// 用例格式（每行一条，# 开头为注释，数值支持 0x 十六进制）：
+//   step <ms>                                   循环间隔（默认1ms，与按键线程一致）
+//   controller <pro|lite>                       手柄类型（默认 Pro；Lite 注入时经过逆映射）
+//   map <源按键> <目标按键>                       [MAPPING] 按键映射（按键名与配置文件一致，如 A、ZL、Up）
+//   softmap <源掩码> <目标掩码>                   [SOFTMAP] 软件映射规则
+//   end <ms>                                    回放结束时间
+//   turbo <按键掩码> <按下ms> <松开ms> <延迟启动0/1>
+//   macro <快捷键> <文件名>                      添加一个V2宏，之后的 frame 行属于它
+//   frame <持续ms> <按键> [lx ly rx ry]
+//   input <开始ms> <结束ms> <按键> [lx ly rx ry]   [开始, 结束) 期间的物理输入
+//   edge <ms> <按键>                             期望的按键边沿：输出按键在 <ms> 变为 <按键>（按顺序匹配）
+//
+// 输出：状态变化时打印一行 "<ms> <事件> <按键> <lx> <ly> <rx> <ry>"
+//       本帧有注入时为注入的 HDLS 状态，否则为物理输入
+//       之后每个期望边沿打印一行 "edge <期望ms> <实际ms> <误差ms>"（没有匹配到为 "edge <期望ms> missing"）
+#include "autokeyloop.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace {
+    constexpr u64 TICKS_PER_MS = HOST_TICK_FREQ / 1000;
+    constexpr u64 BASE_TICK = HOST_TICK_FREQ;       // 从1秒开始计时（0 在模块中表示未开始）
+    constexpr const char* TITLE_DIR = "0100000000000000";
+    constexpr const char* GAME_CFG = "/config/KeyX/GameConfig/0100000000000000.ini";
+    constexpr const char* LOOP_CFG = "/loop.ini";
+
+    struct Frame {
+        u32 durationMs;
+        u64 keys;
+        s32 lx, ly, rx, ry;
+    };
+
+    struct MacroDef {
+        u64 combo;
+        std::string name;
+        std::vector<Frame> frames;
+    };
+
+    struct Input {
+        u32 fromMs, toMs;
+        u64 buttons;
+        s32 lx, ly, rx, ry;
+    };
+
+    struct Mapping {
+        std::string source, target;
+    };
+
+    struct SoftRule {
+        u64 source, target;
+    };
+
+    struct Edge {
+        u32 ms;
+        u64 buttons;
+    };
+
+    struct Case {
+        u32 stepMs = 1;
+        u32 endMs = 0;
+        bool handheld = false;
+        bool hasTurbo = false;
+        u64 turboMask = 0;
+        u32 pressMs = 100, releaseMs = 100;
+        bool delayStart = true;
+        std::vector<MacroDef> macros;
+        std::vector<Input> inputs;
+        std::vector<Mapping> mappings;
+        std::vector<SoftRule> softRules;
+        std::vector<Edge> edges;
+    };
+
+    // 与插件写入的格式一致
+    struct MacroHeader {
+        char magic[4];
+        u16 version;
+        u16 frameRate;
+        u64 titleId;
+        u32 frameCount;
+    } __attribute__((packed));
+
+    struct MacroFrameV2 {
+        u32 durationMs;
+        u64 keysHeld;
+        s32 leftX, leftY, rightX, rightY;
+    } __attribute__((packed));
+
+    struct BindingHeader {
+        char magic[4];
+        u16 version;
+        u16 count;
+    } __attribute__((packed));
+
+    struct Binding {
+        u32 pathHash;
+        u16 flags;
+        u16 reserved;
+        u64 combo;
+        char path[120];
+    } __attribute__((packed));
+
+    const char* eventName(FeatureEvent event) {
+        switch (event) {
+            case FeatureEvent::PAUSED: return "PAUSED";
+            case FeatureEvent::IDLE: return "IDLE";
+            case FeatureEvent::STARTING: return "STARTING";
+            case FeatureEvent::Turbo_EXECUTING: return "TURBO";
+            case FeatureEvent::Macro_EXECUTING: return "MACRO";
+            case FeatureEvent::FINISHING: return "FINISHING";
+            case FeatureEvent::Remap_EXECUTING: return "REMAP";
+        }
+        return "?";
+    }
+
+    u64 number(const char* text) {
+        return strtoull(text, nullptr, 0);
+    }
+
+    s32 snumber(const char* text) {
+        return (s32)strtol(text, nullptr, 0);
+    }
+
+    bool parseCase(const char* path, Case& out) {
+        FILE* fp = fopen(path, "r");
+        if (!fp) return false;
+        char line[256];
+        int lineNo = 0;
+        while (fgets(line, sizeof(line), fp)) {
+            lineNo++;
+            char* hash = strchr(line, '#');
+            if (hash) *hash = '\0';
+            char* argv[8];
+            int argc = 0;
+            for (char* tok = strtok(line, " \t\r\n"); tok && argc < 8; tok = strtok(nullptr, " \t\r\n")) argv[argc++] = tok;
+            if (argc == 0) continue;
+            std::string cmd = argv[0];
+            if (cmd == "step" && argc == 2) {
+                out.stepMs = number(argv[1]);
+            } else if (cmd == "end" && argc == 2) {
+                out.endMs = number(argv[1]);
+            } else if (cmd == "controller" && argc == 2 && (strcmp(argv[1], "pro") == 0 || strcmp(argv[1], "lite") == 0)) {
+                out.handheld = strcmp(argv[1], "lite") == 0;
+            } else if (cmd == "map" && argc == 3) {
+                out.mappings.push_back({argv[1], argv[2]});
+            } else if (cmd == "softmap" && argc == 3) {
+                out.softRules.push_back({number(argv[1]), number(argv[2])});
+            } else if (cmd == "edge" && argc == 3) {
+                out.edges.push_back({(u32)number(argv[1]), number(argv[2])});
+            } else if (cmd == "turbo" && argc == 5) {
+                out.hasTurbo = true;
+                out.turboMask = number(argv[1]);
+                out.pressMs = number(argv[2]);
+                out.releaseMs = number(argv[3]);
+                out.delayStart = number(argv[4]) != 0;
+            } else if (cmd == "macro" && argc == 3) {
+                out.macros.push_back({number(argv[1]), argv[2], {}});
+            } else if (cmd == "frame" && (argc == 3 || argc == 7) && !out.macros.empty()) {
+                Frame frame{(u32)number(argv[1]), number(argv[2]), 0, 0, 0, 0};
+                if (argc == 7) {
+                    frame.lx = snumber(argv[3]); frame.ly = snumber(argv[4]);
+                    frame.rx = snumber(argv[5]); frame.ry = snumber(argv[6]);
+                }
+                out.macros.back().frames.push_back(frame);
+            } else if (cmd == "input" && (argc == 4 || argc == 8)) {
+                Input input{(u32)number(argv[1]), (u32)number(argv[2]), number(argv[3]), 0, 0, 0, 0};
+                if (argc == 8) {
+                    input.lx = snumber(argv[4]); input.ly = snumber(argv[5]);
+                    input.rx = snumber(argv[6]); input.ry = snumber(argv[7]);
+                }
+                out.inputs.push_back(input);
+            } else {
+                fprintf(stderr, "%s:%d: 无法识别的行\n", path, lineNo);
+                fclose(fp);
+                return false;
+            }
+        }
+        fclose(fp);
+        return out.stepMs > 0;
+    }
+
+    bool writeFile(const std::string& path, const void* data, size_t size) {
+        FILE* fp = fopen(path.c_str(), "wb");
+        if (!fp) return false;
+        bool ok = fwrite(data, 1, size, fp) == size;
+        return (fclose(fp) == 0) && ok;
+    }
+
+    // 在临时 sdmc 目录中生成按键线程配置（连发、按键映射、软件映射）、宏文件和绑定表
+    bool prepareFiles(const Case& c, const std::string& root) {
+        std::string macroDir = root + "/config/KeyX/macros/" + TITLE_DIR;
+        std::string cfgDir = root + "/config/KeyX/GameConfig";
+        for (std::string dir : {root + "/config", root + "/config/KeyX", root + "/config/KeyX/macros", macroDir, cfgDir}) {
+            mkdir(dir.c_str(), 0755);
+        }
+
+        char line[256];
+        snprintf(line, sizeof(line), "[AUTOFIRE]\nbuttons=%llu\npresstime=%u\nfireinterval=%u\ndelaystart=%d\n",
+                 (unsigned long long)c.turboMask, c.pressMs, c.releaseMs, c.delayStart ? 1 : 0);
+        std::string ini = line;
+        ini += "[MAPPING]\n";
+        for (const auto& m : c.mappings) ini += m.source + "=" + m.target + "\n";
+        snprintf(line, sizeof(line), "[SOFTMAP]\nruleCount=%zu\n", c.softRules.size());
+        ini += line;
+        for (size_t i = 0; i < c.softRules.size(); i++) {
+            snprintf(line, sizeof(line), "rule_src_%zu=%llu\nrule_dst_%zu=%llu\n", i + 1, (unsigned long long)c.softRules[i].source,
+                     i + 1, (unsigned long long)c.softRules[i].target);
+            ini += line;
+        }
+        if (!writeFile(root + LOOP_CFG, ini.data(), ini.size())) return false;
+
+        std::vector<u8> table(sizeof(BindingHeader));
+        for (const auto& def : c.macros) {
+            std::vector<u8> data(sizeof(MacroHeader));
+            MacroHeader header;
+            memcpy(header.magic, "KEYX", 4);
+            header.version = 2;
+            header.frameRate = 0;
+            header.titleId = 0x0100000000000000ULL;
+            header.frameCount = def.frames.size();
+            memcpy(data.data(), &header, sizeof(header));
+            for (const auto& f : def.frames) {
+                MacroFrameV2 frame{f.durationMs, f.keys, f.lx, f.ly, f.rx, f.ry};
+                const u8* p = (const u8*)&frame;
+                data.insert(data.end(), p, p + sizeof(frame));
+            }
+            if (!writeFile(macroDir + "/" + def.name, data.data(), data.size())) return false;
+
+            Binding binding{};
+            binding.combo = def.combo;
+            snprintf(binding.path, sizeof(binding.path), "%s/%s", TITLE_DIR, def.name.c_str());
+            const u8* p = (const u8*)&binding;
+            table.insert(table.end(), p, p + sizeof(binding));
+        }
+        BindingHeader header;
+        memcpy(header.magic, "KXMB", 4);
+        header.version = 1;
+        header.count = c.macros.size();
+        memcpy(table.data(), &header, sizeof(header));
+        return writeFile(cfgDir + "/" + TITLE_DIR + "_macros.bin", table.data(), table.size());
+    }
+
+    struct Output {
+        FeatureEvent event;
+        u64 buttons;
+        HidAnalogStickState l, r;
+        bool operator!=(const Output& o) const {
+            return event != o.event || buttons != o.buttons || l.x != o.l.x || l.y != o.l.y || r.x != o.r.x || r.y != o.r.y;
+        }
+    };
+
+    // 期望边沿与实际输出的匹配结果（按顺序匹配，实际边沿只用一次）
+    struct EdgeResult {
+        u32 expectedMs;
+        bool found;
+        s32 errorMs;
+    };
+
+    // 输出按键每次变化的时间与变化后的值
+    void matchEdges(const std::vector<Edge>& expected, const std::vector<Edge>& actual, std::vector<EdgeResult>& out) {
+        size_t next = 0;
+        for (const auto& edge : expected) {
+            EdgeResult r{edge.ms, false, 0};
+            for (size_t i = next; i < actual.size(); i++) {
+                if (actual[i].buttons != edge.buttons) continue;
+                r.found = true;
+                r.errorMs = (s32)actual[i].ms - (s32)edge.ms;
+                next = i + 1;
+                break;
+            }
+            out.push_back(r);
+        }
+    }
+
+    // 回放一次，返回处理的帧数，loopNs 累加逐帧处理的耗时（不含加载配置），edges 返回输出按键的边沿
+    u64 replay(const Case& c, const std::string& root, bool print, u64& loopNs, std::vector<Edge>& edges) {
+        host_set_handheld(c.handheld);
+        host_set_tick(BASE_TICK);
+        AutoKeyLoop loop((root + LOOP_CFG).c_str(), GAME_CFG, c.hasTurbo, !c.macros.empty(), !c.softRules.empty());
+
+        Output last{FeatureEvent::PAUSED, ~0ULL, {0, 0}, {0, 0}};
+        u64 ticks = 0;
+        u64 ns = 0;
+        for (u32 ms = 0; ms < c.endMs; ms += c.stepMs, ticks++) {
+            u64 buttons = 0;
+            HidAnalogStickState physL = {0, 0}, physR = {0, 0};
+            for (const auto& input : c.inputs) {
+                if (ms < input.fromMs || ms >= input.toMs) continue;
+                buttons = input.buttons;
+                physL = {input.lx, input.ly};
+                physR = {input.rx, input.ry};
+            }
+            host_set_tick(BASE_TICK + (u64)ms * TICKS_PER_MS);
+            host_set_input(buttons, physL, physR);
+
+            auto start = std::chrono::steady_clock::now();
+            FeatureEvent event = loop.Tick();
+            ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+            Output out{event, buttons, physL, physR};
+            HiddbgHdlsState injected;
+            if (host_take_injected(&injected)) {
+                out.buttons = injected.buttons;
+                out.l = injected.analog_stick_l;
+                out.r = injected.analog_stick_r;
+            }
+            if (print && out != last) {
+                printf("%6u %-9s %016llx %d %d %d %d\n", ms, eventName(out.event), (unsigned long long)out.buttons,
+                       out.l.x, out.l.y, out.r.x, out.r.y);
+            }
+            if (out.buttons != last.buttons) edges.push_back({ms, out.buttons});
+            last = out;
+        }
+        loopNs += ns;
+        return ticks;
+    }
+
+    // 逆映射耗时：Lite 上按住全部16个按键连发，每帧都注入并查逆映射表
+    void benchMapping(const std::string& root, int rounds) {
+        static const char* names[] = {
+            "A", "B", "X", "Y", "Up", "Down", "Left", "Right",
+            "L", "R", "ZL", "ZR", "StickL", "StickR", "Start", "Select",
+        };
+        constexpr u32 TICKS_PER_ROUND = 1000;
+        host_set_handheld(true);
+        for (int count : {0, 4, 16}) {
+            // 前 count 个按键轮换映射（A→B、B→X ...，最后一个映射回第一个）
+            std::string ini = "[AUTOFIRE]\nbuttons=65535\npresstime=1\nfireinterval=1\ndelaystart=0\n[MAPPING]\n";
+            for (int i = 0; i < count; i++) ini += std::string(names[i]) + "=" + names[(i + 1) % count] + "\n";
+            std::string path = root + "/bench_map.ini";
+            if (!writeFile(path, ini.data(), ini.size())) return;
+
+            host_set_tick(BASE_TICK);
+            AutoKeyLoop loop(path.c_str(), GAME_CFG, true, false, false);
+            host_set_input(0xFFFF, {0, 0}, {0, 0});
+            u64 ticks = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < rounds; r++) {
+                for (u32 i = 0; i < TICKS_PER_ROUND; i++, ticks++) {
+                    host_set_tick(BASE_TICK + ticks * TICKS_PER_MS);
+                    loop.Tick();
+                }
+            }
+            u64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            printf("逆映射 %2d 个: %llu 帧, 平均 %.1f ns/帧\n", count, (unsigned long long)ticks, ticks ? (double)ns / ticks : 0.0);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int bench = 0;
+    const char* casePath = nullptr;
+    if (argc == 3 && strcmp(argv[1], "--bench-mapping") == 0) {
+        char root[] = "/tmp/keyx-replay-XXXXXX";
+        if (!mkdtemp(root)) return 2;
+        host_set_sdmc_root(root);
+        benchMapping(root, atoi(argv[2]));
+        std::string cleanup = std::string("rm -rf ") + root;
+        return system(cleanup.c_str()) == 0 ? 0 : 1;
+    }
+    if (argc == 4 && strcmp(argv[1], "--bench") == 0) {
+        bench = atoi(argv[2]);
+        casePath = argv[3];
+    } else if (argc == 2) {
+        casePath = argv[1];
+    } else {
+        fprintf(stderr, "用法: %s [--bench <次数>] <用例.txt> | --bench-mapping <次数>\n", argv[0]);
+        return 2;
+    }
+
+    Case c;
+    if (!parseCase(casePath, c)) {
+        fprintf(stderr, "读取用例失败: %s\n", casePath);
+        return 2;
+    }
+    char root[] = "/tmp/keyx-replay-XXXXXX";
+    if (!mkdtemp(root) || !prepareFiles(c, root)) {
+        fprintf(stderr, "创建测试文件失败\n");
+        return 2;
+    }
+    host_set_sdmc_root(root);
+
+    u64 ns = 0;
+    std::vector<Edge> edges;
+    std::vector<EdgeResult> results;
+    if (bench <= 0) {
+        replay(c, root, true, ns, edges);
+        matchEdges(c.edges, edges, results);
+        for (const auto& r : results) {
+            if (r.found) printf("edge %6u %6u %+d\n", r.expectedMs, r.expectedMs + r.errorMs, r.errorMs);
+            else printf("edge %6u missing\n", r.expectedMs);
+        }
+    } else {
+        u64 ticks = 0;
+        for (int i = 0; i < bench; i++) {
+            edges.clear();
+            ticks += replay(c, root, false, ns, edges);
+        }
+        matchEdges(c.edges, edges, results);
+        int missing = 0;
+        s32 maxError = 0;
+        for (const auto& r : results) {
+            if (!r.found) missing++;
+            else if (abs(r.errorMs) > abs(maxError)) maxError = r.errorMs;
+        }
+        printf("%s: %llu 帧, 平均 %.1f ns/帧", casePath, (unsigned long long)ticks, ticks ? (double)ns / ticks : 0.0);
+        if (!results.empty()) printf(", %zu 个边沿最大误差 %+d ms（缺失 %d）", results.size(), maxError, missing);
+        printf("\n");
+    }
+
+    std::string cleanup = std::string("rm -rf ") + root;
+    return system(cleanup.c_str()) == 0 ? 0 : 1;
+}